@@ -9,9 +9,11 @@
 
 #include <string>
 
+#include "core/ComponentAccess.hpp"
 #include "core/GameObject.hpp"
 #include "core/RenderContext.hpp"
 #include "core/UpdateContext.hpp"
+#include "core/util/SDLConversions.hpp"
 
 #ifdef GIZMOS
 #include "core/util/Gizmos.hpp"
@@ -54,6 +56,12 @@ public:
      */
     std::string GetType() const { return mType; }
 
+    /**
+     * Returns the game object this component is attached to
+     * @return The game object of this component
+     */
+    GameObject* GetGameObject() const { return mGameObject; }
+
     /**
      * An startup lifecycle event for a component
      */
@@ -65,12 +73,35 @@ public:
      */
     virtual void Update(UpdateContext* update) {}
 
+    /**
+     * Declares which component types Update reads and writes, so that
+     * non-conflicting components can be updated in parallel.
+     * Components that do not override this are updated exclusively.
+     * @return The access of this component's Update
+     */
+    virtual ComponentAccess GetAccess() const { return ComponentAccess(); }
+
     /**
      * A render loop for a component
      * @param renderer The render data that operates the render loop
      */
     virtual void Render(RenderContext* renderer) {}
 
+    /**
+     * Gets the world space area this component draws or collides in, used to
+     * cull and to find nearby objects.
+     * @param bounds Set to the bounds of this component (if it has any)
+     * @return False if this component has no bounds
+     */
+    virtual bool GetBounds(FRect* bounds) { return false; }
+
+    /**
+     * Called between frames when the renderer lost the contents of its
+     * render target textures (e.g. the graphics device was reset), so
+     * components that draw into their own targets can draw them again.
+     */
+    virtual void HandleRenderTargetsReset() {}
+
 #ifdef GIZMOS
     virtual void DrawGizmos(RenderContext* renderer, util::Gizmos* util) {}
 #endif
@@ -89,6 +120,11 @@ public:
      */
     friend void GameObject::RemoveComponent(const std::string& toRemove);
 
+    /**
+     * Attaches the transform to a newly created GameObject
+     */
+    friend GameObject::GameObject(Engine*, util::ScopeArena*);
+
     /**
      * Gets the GameObject
      */
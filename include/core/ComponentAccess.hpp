@@ -0,0 +1,80 @@
+#ifndef __COMPONENTACCESS_HPP__
+#define __COMPONENTACCESS_HPP__
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+/**
+ * A set of component types (or other shared engine state, like "camera"),
+ * one bit per name.
+ */
+typedef uint64_t ComponentMask;
+
+/**
+ * Get the bit that represents the given component type.
+ * Bits are assigned the first time a name is seen.
+ * @param type The name of the component type (or shared state)
+ * @return The mask containing only that type
+ */
+ComponentMask ComponentTypeMask(const std::string& type);
+
+/**
+ * Declares what a component's Update reads and writes, so the Engine can run
+ * non-conflicting components in parallel.
+ *
+ * Components that have not declared their access are exclusive: they conflict
+ * with everything and always run alone.
+ */
+struct ComponentAccess
+{
+    ComponentMask reads = ~ComponentMask(0);
+    ComponentMask writes = ~ComponentMask(0);
+    // Update only touches data on its own game object, so the components of
+    // this type can be split across threads by game object. Objects with a
+    // parent or children are the exception: moving a transform marks its
+    // children dirty and reads its parent, so the components on them run on
+    // one thread (see Engine::BuildUpdateSystems).
+    bool bObjectLocal = false;
+
+    /**
+     * Access for components that do no work in Update.
+     */
+    static ComponentAccess None() { return ComponentAccess{0, 0, true}; }
+
+    ComponentAccess& Reads(std::initializer_list<const char*> types)
+    {
+        if (reads == ~ComponentMask(0)) reads = 0;
+        for (const char* type : types) reads |= ComponentTypeMask(type);
+        return *this;
+    }
+    ComponentAccess& Writes(std::initializer_list<const char*> types)
+    {
+        if (writes == ~ComponentMask(0)) writes = 0;
+        for (const char* type : types) writes |= ComponentTypeMask(type);
+        return *this;
+    }
+    ComponentAccess& ObjectLocal(bool isObjectLocal = true)
+    {
+        bObjectLocal = isObjectLocal;
+        return *this;
+    }
+
+    /**
+     * Does this component have any Update work at all?
+     */
+    bool IsNone() const { return reads == 0 && writes == 0; }
+
+    /**
+     * Can this run at the same time as the other access?
+     * @param other The other access
+     * @return True if one writes what the other reads or writes
+     */
+    bool ConflictsWith(const ComponentAccess& other) const
+    {
+        return (writes & (other.reads | other.writes)) != 0 ||
+               (other.writes & reads) != 0;
+    }
+};
+
+#endif  // __COMPONENTACCESS_HPP__
@@ -25,6 +25,16 @@ public:
      */
     virtual void Update(UpdateContext* update) override;
 
+    /**
+     * Moves its own transform, drives the camera and posts animation
+     * messages to its game object, so it does not conflict with the
+     * animator that plays them.
+     * NOTE: raycasting may trigger colliders on other game objects, which
+     * broadcast to their own components, so this does not run object-local.
+     * @return The access of the controller
+     */
+    virtual ComponentAccess GetAccess() const override;
+
     /**
      * Sets the speed of this game object, the speed is default
      * if this is not called at all.
@@ -35,6 +45,11 @@ public:
 
 private:
     float mMoveSpeed = 64.0f;
+    // The movement actions, looked up once
+    int mMoveRight;
+    int mMoveLeft;
+    int mMoveUp;
+    int mMoveDown;
 };
 
 #endif
@@ -10,11 +10,43 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
 
+#include "core/ComponentAccess.hpp"
 #include "core/GameObject.hpp"
 #include "core/IGraphicsEngineRenderer.hpp"
 #include "core/InputManager.hpp"
+#include "core/TransformHierarchy.hpp"
 #include "core/UpdateContext.hpp"
+#include "core/render/CommandBuffer.hpp"
+#include "core/render/RenderThread.hpp"
+#include "core/render/SpriteBatch.hpp"
+#include "core/util/FrameArena.hpp"
+#include "core/util/FramePacer.hpp"
+#include "core/util/ScopeArena.hpp"
+#include "core/util/SpatialGrid.hpp"
+#include "core/util/ThreadPool.hpp"
+
+class SceneResources;
+
+/**
+ * How long each phase of Engine::LoadScene took, in milliseconds.
+ */
+struct SceneLoadTimes
+{
+    // Reading the scene file
+    double readMs = 0;
+    // Loading the spritesheets and tilemaps it uses
+    double resourcesMs = 0;
+    // Creating its game objects and components
+    double instantiateMs = 0;
+    // Destroying the scene switched from, and freeing its resources (see
+    // Engine::SwitchToPrefetchedScene)
+    double unloadMs = 0;
+    double totalMs = 0;
+};
 
 /**
  * This class sets up the main game engine and all necessary subsystems.
@@ -28,12 +60,16 @@ public:
     void Input(bool* quit);
 
     /**
-     * Per frame update
-     * @param update The update data that operates the update loop
+     * Per frame update. Starts a new frame, so everything allocated in the
+     * frame arena since the previous update is freed.
+     * Components are grouped into systems by type. Systems whose declared
+     * access does not conflict are updated in parallel on the job system.
+     * @param deltaTime The time since the previous frame started, in seconds
      */
-    void Update();
+    void Update(float deltaTime);
     /**
-     * Per frame render. Renders everything
+     * Per frame render. Records everything into a command buffer, then
+     * executes it (on the render thread, if there is one).
      */
     void Render();
 
@@ -47,6 +83,93 @@ public:
 
     void RunGameLoop();
 
+    /**
+     * Stop the game loop after a number of frames and report how long they
+     * took. Useful for performance runs.
+     * @param frameCount The number of frames to run, or 0 to run until quit
+     */
+    void SetFrameLimit(unsigned int frameCount) { mFrameLimit = frameCount; }
+
+    /**
+     * Set the frame rate the game loop is paced to.
+     * @param framesPerSecond The target rate, or 0 to run as fast as possible
+     */
+    void SetTargetFrameRate(double framesPerSecond);
+
+    /**
+     * Pace frames by waiting for the display's vertical sync instead of a
+     * timer. Falls back to the timer if the renderer does not support it.
+     * @param bEnabled Whether to use vsync
+     * @param fallbackFrameRate The timer rate to use without vsync
+     */
+    void SetVSync(bool bEnabled, double fallbackFrameRate = 60.0);
+
+    /**
+     * Get the frame pacer, which has the timing history of recent frames
+     * @return The frame pacer
+     */
+    const util::FramePacer& GetFramePacer() const { return mFramePacer; }
+
+    /**
+     * Set how long each frame may spend uploading textures that finished
+     * loading in the background. At least one texture is uploaded per frame.
+     * @param ms The upload budget per frame, in milliseconds
+     */
+    void SetLoadBudget(double ms) { mLoadBudgetMs = ms; }
+
+    /**
+     * Block until every resource loading in the background is ready to use.
+     * Useful after starting the loads of a level with LoadAsync.
+     */
+    void WaitForLoads();
+
+    /**
+     * Create the game objects of a scene file (see SceneLoader), after the
+     * ones already in the scene. The spritesheets of the scene are decoded in
+     * the background while its tilemaps are read, and every container is
+     * sized up front. The time of each phase is logged.
+     * @param fileLoc The location of the scene file
+     * @param out_times Set to how long each phase took, if not null
+     * @return 0 if the scene was created, -1 if it could not be loaded (and
+     * nothing was created)
+     */
+    int LoadScene(const std::string& fileLoc,
+                  SceneLoadTimes* out_times = nullptr);
+
+    /**
+     * Start loading a scene in the background while the current one plays,
+     * to switch to it with SwitchToPrefetchedScene. Its resources are loaded
+     * a few at a time between frames (see SceneResources), then its
+     * spritesheets are packed like ResourceManager::PackSpritesheets does.
+     * Replaces the scene prefetched before.
+     * @param fileLoc The location of the scene file
+     * @param memoryCap The most memory the prefetched resources may take, in
+     * bytes, 0 for no cap. What does not fit is loaded when switching.
+     * @return 0 if the scene file was read, -1 if not
+     */
+    int PrefetchScene(const std::string& fileLoc, size_t memoryCap = 0);
+
+    /**
+     * Whether the prefetched scene is loaded, so switching to it is quick
+     */
+    bool IsScenePrefetched() const;
+
+    /**
+     * Replace the scene with the prefetched one before the next frame. Every
+     * game object is destroyed and the resources only the old scenes used
+     * are freed together, then the prefetched scene is created. What the
+     * prefetch has not loaded yet is loaded first. Safe to call from
+     * components, since nothing changes until the frame is over.
+     */
+    void SwitchToPrefetchedScene() { mbSwitchScene = true; }
+
+    /**
+     * Pack the spritesheets loaded so far into atlas pages (see
+     * ResourceManager::PackSpritesheets), on the thread that owns the
+     * renderer
+     */
+    void PackSpritesheets();
+
     /**
      * Initialization and shutdown pattern
      * Explicitly call 'Startup' to launch the engine
@@ -60,20 +183,93 @@ public:
 
     /**
      * Request to startup the Graphics Subsystem
+     * @param bRenderThread Whether to draw frames on a separate thread, which
+     * creates the renderer, while the main thread updates and records the
+     * next frame. See render::RenderThread for the restrictions this puts on
+     * renderer use. Falls back to drawing on the main thread if the renderer
+     * cannot be created on the render thread.
      */
-    void InitializeGraphicsSubSystem();
+    void InitializeGraphicsSubSystem(bool bRenderThread = true);
+
+    /**
+     * Request to startup the Graphics Subsystem without a window, for
+     * machines without a display. Frames are not paced.
+     * @param discardDraws Whether to only count draws instead of drawing
+     * @param bRenderThread Whether to draw frames on a separate thread, see
+     * InitializeGraphicsSubSystem
+     */
+    void InitializeHeadlessGraphicsSubSystem(bool discardDraws = false,
+                                             bool bRenderThread = true);
 
     /**
      * Request to startup the User Input System
      */
     InputState* InitializeInputSystem();
 
+    /**
+     * Request to startup the worker threads used to update components in
+     * parallel. Without a job system, components are updated serially.
+     * @param workerCount The number of worker threads (besides the main
+     * thread)
+     */
+    void InitializeJobSystem(
+        unsigned int workerCount = util::ThreadPool::DefaultWorkerCount());
+
+    /**
+     * How long game objects and other data live.
+     */
+    enum class Scope
+    {
+        // Until the level is unloaded, see UnloadLevel
+        Level,
+        // Until the engine shuts down
+        Persistent
+    };
+
     /**
      * Create a new game object and place it in the scene.
      * See mGameObjects for note about rendering.
+     * @param scope How long the game object lives
      * @return The new game object created
      */
-    GameObject& InstantiateGameObject();
+    GameObject& InstantiateGameObject(Scope scope = Scope::Level);
+
+    /**
+     * Get the arena of a scope, for data that lives as long as its game
+     * objects.
+     * @param scope The scope
+     * @return The arena of the scope
+     */
+    util::ScopeArena& GetArena(Scope scope)
+    {
+        return scope == Scope::Level ? mLevelArena : mPersistentArena;
+    }
+
+    /**
+     * Destroy every game object of the level, and everything else in the
+     * level arena, at once. Persistent game objects stay. Must be called
+     * between frames.
+     */
+    void UnloadLevel();
+
+    /**
+     * Get the draw counters of the last frame that finished drawing
+     * @return The frame stats
+     */
+    const render::FrameStats& GetFrameStats() const { return mFrameStats; }
+
+    /**
+     * Set whether sprites on a layer are drawn in order of their bottom edge,
+     * so sprites lower on the screen overlap the ones above them. Layers a
+     * scene turns on are turned off again when the level is unloaded, see
+     * UnloadLevel.
+     * @param layer The render layer
+     * @param bYSorted Whether to sort the layer by y
+     */
+    void SetLayerYSorted(int layer, bool bYSorted)
+    {
+        mSpriteBatch.SetLayerYSorted(layer, bYSorted);
+    }
 
     /**
      * Create a new component and attach it to an object.
@@ -87,33 +283,204 @@ public:
     {
         // This template method must be defined in the header to be used
         // elsewhere.
-        Component* component = (Component*)new Component_t(args...);
+        Component* component;
+        if (util::ScopeArena* arena = obj.GetArena())
+        {
+            // Destroyed in place by the game object, see GameObject
+            void* memory = arena->Allocate(sizeof(Component_t),
+                                           alignof(Component_t));
+            component = (Component*)new (memory) Component_t(args...);
+        }
+        else
+        {
+            component = (Component*)new Component_t(args...);
+        }
         obj.AddComponent(component);
         return (Component_t*)component;
     }
 
+    /**
+     * Gets the flattened hierarchy of all transforms in the scene
+     * @return The transform hierarchy
+     */
+    TransformHierarchy& GetTransformHierarchy() { return mTransformHierarchy; }
+
 private:
+    /**
+     * All of the components of one type that are updated this frame.
+     */
+    struct UpdateSystem
+    {
+        ComponentAccess access;
+        std::vector<Component*> components;
+        // For object-local systems, the number of components at the front
+        // that can be split across threads. The rest are on objects in a
+        // transform hierarchy, which touch each other's transforms.
+        size_t splitCount = 0;
+        // Systems in the same wave do not conflict and run in parallel
+        unsigned int wave = 0;
+    };
+
+    /**
+     * Group the components of all active game objects into systems and
+     * schedule them into waves of non-conflicting systems.
+     * @return The number of waves
+     */
+    unsigned int BuildUpdateSystems();
+
+    /**
+     * Tell every component that the render targets lost their contents.
+     */
+    void HandleRenderTargetsReset();
+
+    /**
+     * Re-insert every active game object that cannot move during the update
+     * into the spatial grid, and list the ones that can.
+     */
+    void RebuildSpatialGrid();
+
+    /**
+     * Whether a game object may move during the update: one of its
+     * components, or one of its parent's, writes transforms. Components are
+     * assumed to only move their own game object.
+     * @param pGO The game object
+     * @return true if it may move
+     */
+    static bool CanMove(GameObject* pGO);
+
+    /**
+     * Find the game objects that may overlap a rectangle: the ones in the
+     * spatial grid, plus the ones that may have moved or were created since
+     * it was built.
+     * @param rect The world space region to search
+     * @param out The indices of the game objects, in scene order
+     */
+    template <typename Allocator>
+    void QueryObjects(const FRect& rect,
+                      std::vector<unsigned int, Allocator>& out) const;
+
+    /**
+     * Load every resource of a scene that is not loaded yet, and wait for
+     * them.
+     */
+    void FinishSceneLoads(SceneResources& resources);
+
+    /**
+     * Create the game objects of a scene whose resources are loaded.
+     */
+    void InstantiateScene(const SceneResources& resources);
+
+    /**
+     * Take the prefetch's finished loads and start the next ones. Called
+     * between frames.
+     * @param frameIdx The frame about to be drawn
+     */
+    void UpdatePrefetch(int frameIdx);
+
+    /**
+     * Stop prefetching, freeing what the prefetch loaded.
+     */
+    void CancelPrefetch();
+
+    /**
+     * Start drawing frames on a separate thread, which creates the renderer
+     * if it was not created yet. Falls back to creating it on this thread if
+     * that fails.
+     */
+    void StartRenderThread();
+
+    /**
+     * Switch to the prefetched scene (see SwitchToPrefetchedScene). Called
+     * between frames.
+     * @param out_times Set to how long each phase took, if not null
+     * @return 0 if it worked, -1 if the old scene is kept
+     */
+    int SwitchScene(SceneLoadTimes* out_times = nullptr);
+
     // Engine Subsystem
-    SDLGraphicsEngineRenderer* mRenderer = nullptr;
+    IGraphicsEngineRenderer* mRenderer = nullptr;
     // Input management system
     InputManager* mInput = nullptr;
+    // Worker threads for parallel updates
+    util::ThreadPool* mJobs = nullptr;
+    // Draws recorded frames, when rendering is pipelined
+    render::RenderThread* mRenderThread = nullptr;
 
     UpdateContext mUpdateCtx;
     RenderContext mRenderCtx;
+    // Temporary allocations for the current frame, shared by both contexts
+    util::FrameArena mFrameArena;
+    // Collects the sprites of a frame to draw them in batches
+    render::SpriteBatch mSpriteBatch;
+    // The y-sorted layers the scene turned on, see InstantiateScene
+    std::vector<int> mSceneYSortedLayers;
+    // One frame is recorded while the other may still be drawing
+    render::CommandBuffer mCommandBuffers[2];
+    unsigned int mRecordingBuffer = 0;
+    render::FrameStats mFrameStats;
 #ifdef GIZMOS
     util::Gizmos mGizmosUtil{};
 #endif
 
     glm::vec2 mScreenSize;
     glm::vec2 mScreenCenter;
+    // Waits between frames and measures them
+    util::FramePacer mFramePacer;
+    // The number of frames to run, 0 to run until quit
+    unsigned int mFrameLimit = 0;
+    // Time each frame may spend uploading loaded textures, in milliseconds
+    double mLoadBudgetMs = 2.0;
 
     /**
      * Our scene of game objects.
-     * The order of elements determines the order of rendering.
-     * Game objects (and their components) are rendered from first to last.
-     * Later elements will render above earlier elements.
+     * Draw order is decided by the layer (and y, on y-sorted layers) that
+     * components draw with, see render::SpriteBatch. Only draws with the same
+     * sort key fall back to this order, later elements above earlier ones.
      */
     std::vector<GameObject*> mGameObjects;
+
+    // The resources of the scenes that were loaded, freed when switching
+    // scenes
+    std::vector<SceneResources*> mSceneResources;
+    // The scene loading in the background, null if none
+    SceneResources* mPrefetch = nullptr;
+    bool mbPrefetchPacked = false;
+    bool mbSwitchScene = false;
+
+    /**
+     * All transforms of the scene, sorted by depth for world position
+     * propagation.
+     */
+    TransformHierarchy mTransformHierarchy;
+
+    // Game objects, their components and anything else that lives as long
+    // as the level, freed at once by UnloadLevel. After the hierarchy, so
+    // they are destroyed before it
+    util::ScopeArena mLevelArena;
+    // Game objects that outlive levels. Resources are kept apart from both,
+    // by the ResourceManager
+    util::ScopeArena mPersistentArena{64 * 1024};
+
+    /**
+     * Update systems in the order their component type was first seen.
+     */
+    std::vector<UpdateSystem> mUpdateSystems;
+    std::unordered_map<std::type_index, size_t> mUpdateSystemIndex;
+
+    /**
+     * Active game objects (by index into mGameObjects) bucketed by their
+     * bounds. Used to cull rendering to the view and to narrow down collision
+     * checks. Rebuilt at the start of every update, see QueryObjects.
+     */
+    util::SpatialGrid mSpatialGrid;
+    // Active game objects that may move during the update, checked where
+    // they are at the time of each query instead of being in the grid
+    std::vector<unsigned int> mMovingObjects;
+    // How many game objects there were when the grid was built. The ones
+    // after were created during the frame, and are checked like the moving
+    // ones
+    size_t mGridObjectCount = 0;
+    std::vector<unsigned int> mVisibleObjects;
 };
 
 #endif  // __ENGINE_HPP__
@@ -7,6 +7,8 @@
 
 #include "core/RenderContext.hpp"
 #include "core/UpdateContext.hpp"
+#include "core/util/SDLConversions.hpp"
+#include "core/util/ScopeArena.hpp"
 
 #ifdef GIZMOS
 #include "core/util/Gizmos.hpp"
@@ -29,18 +31,27 @@ class ColliderComponent;
  * Life cycle events triggered on game objects will trigger on its components.
  *
  * All game objects have a transform component (whether or not they need it).
+ * Game objects can be parented to other game objects, in which case their
+ * transform is relative to the parent's transform.
+ *
+ * A game object made in a scope arena (see Engine::Scope) keeps its
+ * components there too, and destroys them in place instead of deleting them.
  *
- * TODO: add ability to add children game objects
  * TODO: add Start lifecycle event;
  */
 class GameObject final
 {
 public:
+    typedef std::vector<Component*, util::ScopeAllocator<Component*>>
+        ComponentList;
+
     /**
      * A constructor
      * @param engine The engine we are using
+     * @param arena The arena this game object and its components are made
+     * in, or null for the heap
      */
-    GameObject(Engine* engine);
+    GameObject(Engine* engine, util::ScopeArena* arena = nullptr);
     // Must implement Move (noexcept) Contructor to prevent destructor calls on
     // contained components
     /**
@@ -91,6 +102,13 @@ public:
      */
     void AddComponent(Component* to_add);
 
+    /**
+     * Make room for a number of components, so adding them does not
+     * reallocate.
+     * @param count The number of components this game object will have
+     */
+    void ReserveComponents(size_t count) { mComponents.reserve(count); }
+
     /**
      * Removes and destroys the component of the given type (if it exists on
      * this game object). WARN: removing a component to reattach elsewhere is
@@ -108,20 +126,94 @@ public:
     Component* GetComponent(const std::string& type);
     TransformComponent& GetTransform();
 
+    /**
+     * Returns all components attached to this game object (except the
+     * transform)
+     * @return The components of this game object
+     */
+    const ComponentList& GetComponents() const { return mComponents; }
+
+    /**
+     * The arena this game object and its components are made in
+     * @return The arena, or null for the heap
+     */
+    util::ScopeArena* GetArena() const { return mArena; }
+
+    /**
+     * Gets the union of the bounds of all components.
+     * @param bounds Set to the bounds of this game object (if it has any)
+     * @return False if no component has bounds, meaning the game object could
+     * be anywhere
+     */
+    bool GetBounds(FRect* bounds);
+
     /**
      * Broadcasts the given message to all of this components
      * @param message The message we are trying to broadcast
      */
     void BroadcastMessage(const std::string& message) const;
 
+    /**
+     * Queue a message to broadcast to all of this game object's components
+     * once every component has updated. Unlike BroadcastMessage, posting
+     * does not touch the receivers while they may be updating on another
+     * thread, so a component that posts only declares the "messages"
+     * channel in its access (see ComponentAccess), not what the receivers
+     * write.
+     * @param message The message to broadcast
+     */
+    void PostMessage(const std::string& message)
+    {
+        mPostedMessages.push_back(InternMessage(message));
+    }
+
+    /**
+     * Broadcast the messages posted so far. Messages posted while they are
+     * delivered wait for the next delivery. Called by the Engine after the
+     * update.
+     */
+    void DeliverPostedMessages();
+
     bool IsActive() const { return mIsActive; }
     void SetActive(bool isActive) { mIsActive = isActive; }
 
+    /**
+     * Attach this game object to a parent game object (or detach it with
+     * nullptr). The world position of this game object is preserved.
+     * @param parent The new parent game object
+     */
+    void SetParent(GameObject* parent);
+
+    /**
+     * Returns the parent game object, if it exists
+     * @return The parent game object
+     */
+    GameObject* GetParent() const;
+
 private:
+    /**
+     * Destroy a component this game object owns.
+     */
+    void DestroyComponent(Component* component);
+
+    /**
+     * Find the one copy of a message that is kept for every game object, so
+     * posting a message does not copy it. Messages are a small fixed set, so
+     * their copies are kept until the program exits.
+     * @param message The message
+     * @return The copy of the message
+     */
+    static const std::string* InternMessage(const std::string& message);
+
     Engine* mEngine;
+    util::ScopeArena* mArena = nullptr;
     bool mIsActive = true;
     TransformComponent* mTransform;
-    std::vector<Component*> mComponents;
+    ComponentList mComponents;
+    // Interned messages (see InternMessage)
+    std::vector<const std::string*> mPostedMessages;
+    // The messages being delivered, kept to reuse their memory
+    std::vector<const std::string*> mDeliveredMessages;
 };
 
 #endif
@@ -58,6 +58,43 @@ public:
      */
     virtual void RenderPresent() = 0;
 
+    /**
+     * Get Pointer to Window
+     * @return The pointer to the window, or null if there is none
+     */
+    virtual SDL_Window* GetWindow() = 0;
+
+    /**
+     * Get Pointer to Renderer, used to create textures and draw
+     * @return The pointer to the renderer
+     */
+    virtual SDL_Renderer* GetRenderer() = 0;
+
+    /**
+     * Create the renderer, if the constructor was told to leave it to the
+     * thread that draws (see render::RenderThread)
+     * @return true if the renderer was created
+     */
+    virtual bool CreateRenderer() = 0;
+
+    /**
+     * Destroy the renderer, on the thread that created it
+     */
+    virtual void DestroyRenderer() = 0;
+
+    /**
+     * Whether recorded frames should only be counted instead of drawn
+     * @return true if draws are thrown away
+     */
+    virtual bool DiscardsDraws() const { return false; }
+
+    /**
+     * Make presenting wait for the display's vertical sync (if supported)
+     * @param bEnabled Whether to wait for vsync
+     * @return true if the setting was applied
+     */
+    virtual bool SetVSync(bool bEnabled) { return false; }
+
 protected:
     // Screen dimension constants
     int mScreenWidth{0};
@@ -74,8 +111,10 @@ public:
      * Concrete implementation of constructor
      * @param w Width
      * @param h Height
+     * @param bDeferRenderer Whether to only open the window, and leave
+     * creating the renderer to CreateRenderer
      */
-    SDLGraphicsEngineRenderer(int w, int h);
+    SDLGraphicsEngineRenderer(int w, int h, bool bDeferRenderer = false);
     /**
      * Destructor
      */
@@ -100,17 +139,27 @@ public:
      */
     void RenderPresent() override;
 
+    /**
+     * Make presenting wait for the display's vertical sync
+     * @param bEnabled Whether to wait for vsync
+     * @return true if the renderer supports changing vsync
+     */
+    bool SetVSync(bool bEnabled) override;
+
     /**
      * Get Pointer to Window
      * @return The pointer to the window
      */
-    SDL_Window* GetWindow();
+    SDL_Window* GetWindow() override;
 
     /**
      * Get Pointer to Renderer
      * @return The pointer to the renderer
      */
-    SDL_Renderer* GetRenderer();
+    SDL_Renderer* GetRenderer() override;
+
+    bool CreateRenderer() override;
+    void DestroyRenderer() override;
 
 private:
     // SDL Window
@@ -119,4 +168,63 @@ private:
     SDL_Renderer* mRenderer = nullptr;
 };
 
+/**
+ * A renderer without a window, for running the engine on machines without a
+ * display (e.g. performance regression runs).
+ *
+ * Frames are drawn with SDL's software renderer into an offscreen surface, or
+ * only counted when draws are discarded. Textures are still created, so
+ * resources load the same way as with a window.
+ */
+class HeadlessGraphicsEngineRenderer : public IGraphicsEngineRenderer
+{
+public:
+    /**
+     * Constructor
+     * @param w Width of the offscreen surface
+     * @param h Height of the offscreen surface
+     * @param discardDraws Whether to skip drawing frames and only count them
+     * @param bDeferRenderer Whether to leave creating the renderer to
+     * CreateRenderer
+     */
+    HeadlessGraphicsEngineRenderer(int w, int h, bool discardDraws = false,
+                                   bool bDeferRenderer = false);
+    /**
+     * Destructor
+     */
+    ~HeadlessGraphicsEngineRenderer();
+
+    void SetRenderDrawColor(int r, int g, int b, int a) override;
+    void RenderClear() override;
+    void RenderPresent() override;
+
+    /**
+     * There is no window
+     * @return null
+     */
+    SDL_Window* GetWindow() override { return nullptr; }
+
+    /**
+     * Get Pointer to the software renderer
+     * @return The pointer to the renderer
+     */
+    SDL_Renderer* GetRenderer() override { return mRenderer; }
+
+    bool CreateRenderer() override;
+    void DestroyRenderer() override;
+
+    bool DiscardsDraws() const override { return mbDiscardDraws; }
+
+    /**
+     * Get the surface frames are drawn to, e.g. to save or compare them
+     * @return The offscreen surface
+     */
+    SDL_Surface* GetSurface() { return mSurface; }
+
+private:
+    SDL_Surface* mSurface = nullptr;
+    SDL_Renderer* mRenderer = nullptr;
+    bool mbDiscardDraws;
+};
+
 #endif
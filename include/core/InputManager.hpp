@@ -1,9 +1,11 @@
 #ifndef __INPUTMANAGER_HPP__
 #define __INPUTMANAGER_HPP__
 
+#include <bitset>
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <glm/vec2.hpp>
 
@@ -74,31 +76,105 @@ public:
 /**
  * Represents the current state of user input devices like mouse and keyboard.
  *
- * TODO: define an Axis struct for handling multiple keys for the same action.
+ * Keys are queried by scancode (their position on the keyboard), or through
+ * actions: named inputs bound to one or more keys. Look up the id of an
+ * action once with GetActionId, so each query is only a few bit tests. The
+ * state of the last frame is kept, so presses and releases can be told
+ * apart from keys held down.
+ *
  * TODO: add support for scroll wheel input
  */
 class InputState
 {
 public:
     /**
-     * Check if a key is pressed by key name.
+     * Actions the engine binds by default, see InputManager.
+     */
+    static constexpr const char* MOVE_RIGHT = "move_right";
+    static constexpr const char* MOVE_LEFT = "move_left";
+    static constexpr const char* MOVE_UP = "move_up";
+    static constexpr const char* MOVE_DOWN = "move_down";
+
+    /**
+     * Get the id of an action, registering it if it is new. Ids are the same
+     * for every input state. Not thread safe, so look ids up ahead of time.
+     * @param actionName The name of the action
+     * @return The id of the action
+     */
+    static int GetActionId(const std::string& actionName);
+
+    /**
+     * Check if a key is pressed by key name. Slower than the other queries,
+     * since the name is looked up every time.
      * @param keyName The name of the key we are checking
      * @return Was that key pressed?
      */
-    virtual bool IsKeyPressed(const std::string& keyName) = 0;
+    virtual bool IsKeyPressed(const std::string& keyName) const = 0;
 
     /**
-     * Get axis direction from currently pressed keys.
+     * Get axis direction from currently pressed keys. Slower than the other
+     * queries, since the names are looked up every time.
      *
      * If both the positive and negative keys are pressed, the net effect is 0.
-     *
-     * TODO: add support for multiple keys for the same action.
      * @param positive The name of the key that is the "positive" for the axis
      * @param negative The name of the key that is the "negative" for the axis
      * @return The value of the input on the axis
      */
     virtual int GetAxis(const std::string& positive,
-                        const std::string& negative) = 0;
+                        const std::string& negative) const = 0;
+
+    /**
+     * Check if a key is held down.
+     * @param scancode The key
+     * @return Is the key down?
+     */
+    virtual bool IsKeyDown(SDL_Scancode scancode) const = 0;
+
+    /**
+     * Check if a key went down since the last frame.
+     * @param scancode The key
+     * @return Was the key pressed this frame?
+     */
+    virtual bool WasKeyPressed(SDL_Scancode scancode) const = 0;
+
+    /**
+     * Check if a key went up since the last frame.
+     * @param scancode The key
+     * @return Was the key released this frame?
+     */
+    virtual bool WasKeyReleased(SDL_Scancode scancode) const = 0;
+
+    /**
+     * Check if any key bound to an action is held down.
+     * @param actionId The id of the action, see GetActionId
+     * @return Is the action down?
+     */
+    virtual bool IsActionDown(int actionId) const = 0;
+
+    /**
+     * Check if an action went down since the last frame.
+     * @param actionId The id of the action, see GetActionId
+     * @return Was the action pressed this frame?
+     */
+    virtual bool WasActionPressed(int actionId) const = 0;
+
+    /**
+     * Check if an action went up since the last frame.
+     * @param actionId The id of the action, see GetActionId
+     * @return Was the action released this frame?
+     */
+    virtual bool WasActionReleased(int actionId) const = 0;
+
+    /**
+     * Get axis direction from the actions that are down.
+     *
+     * If both the positive and negative actions are down, the net effect is
+     * 0.
+     * @param positive The id of the "positive" action for the axis
+     * @param negative The id of the "negative" action for the axis
+     * @return The value of the input on the axis
+     */
+    virtual int GetAxis(int positive, int negative) const = 0;
 
     /**
      * Check if a mouse button is pressed by mouse button number.
@@ -110,6 +186,8 @@ public:
 
 /**
  * Manager to handle all input events for keyboard and mouse.
+ *
+ * The movement actions are bound to WASD and the arrow keys to begin with.
  */
 class InputManager : public InputState
 {
@@ -134,29 +212,39 @@ public:
     void HandleEvent(SDL_Event evt);
 
     /**
-     * Singleton for accessing input state globally.
+     * Keep the key state of the last frame, for presses and releases. Called
+     * before the events of a frame are handled.
      */
-    static InputState* State;
+    void BeginFrame() { mPreviousKeyboardState = mKeyboardState; }
 
     /**
-     * Check if a key is pressed by key name.
-     * @param keyName The name of the key we are checking
-     * @return Was that key pressed?
+     * Bind a key to an action, in addition to the keys it has.
+     * @param actionId The id of the action, see GetActionId
+     * @param scancode The key
      */
-    virtual bool IsKeyPressed(const std::string& keyName) override;
+    void BindAction(int actionId, SDL_Scancode scancode);
 
     /**
-     * Get axis direction from currently pressed keys.
-     *
-     * If both the positive and negative keys are pressed, the net effect is 0.
-     *
-     * TODO: add support for multiple keys for the same action.
-     * @param positive The name of the key that is the "positive" for the axis
-     * @param negative The name of the key that is the "negative" for the axis
-     * @return The value of the input on the axis
+     * Remove every key bound to an action.
+     * @param actionId The id of the action, see GetActionId
      */
+    void UnbindAction(int actionId);
+
+    /**
+     * Singleton for accessing input state globally.
+     */
+    static InputState* State;
+
+    virtual bool IsKeyPressed(const std::string& keyName) const override;
     virtual int GetAxis(const std::string& positive,
-                        const std::string& negative) override;
+                        const std::string& negative) const override;
+    virtual bool IsKeyDown(SDL_Scancode scancode) const override;
+    virtual bool WasKeyPressed(SDL_Scancode scancode) const override;
+    virtual bool WasKeyReleased(SDL_Scancode scancode) const override;
+    virtual bool IsActionDown(int actionId) const override;
+    virtual bool WasActionPressed(int actionId) const override;
+    virtual bool WasActionReleased(int actionId) const override;
+    virtual int GetAxis(int positive, int negative) const override;
 
     /**
      * Check if a mouse button is pressed by mouse button number.
@@ -210,15 +298,33 @@ public:
 protected:
     /**
      * Update keyboard state for a key and alert key event listeners.
-     * @param keyName The name of the key pressed
+     * @param scancode The key pressed
      */
-    inline void PressKey(std::string& keyName);
+    inline void PressKey(SDL_Scancode scancode);
 
     /**
      * Update keyboard state for a key and alert key event listeners.
-     * @param keyName The name of the key removed
+     * @param scancode The key released
+     */
+    inline void ReleaseKey(SDL_Scancode scancode);
+
+    /**
+     * Check if any key bound to an action is down in a keyboard state.
+     * @param actionId The id of the action
+     * @param keyboardState The keyboard state
+     * @return Is the action down?
+     */
+    inline bool IsActionDown(int actionId,
+                             const std::bitset<SDL_NUM_SCANCODES>&
+                                 keyboardState) const;
+
+    /**
+     * Translate from the name of a key to its scancode.
+     * @param keyName The name of the key
+     * @return The scancode, SDL_SCANCODE_UNKNOWN if there is no such key
      */
-    inline void ReleaseKey(std::string& keyName);
+    static inline SDL_Scancode SDL_GetScancodeFromKeyName(
+        const std::string& keyName);
 
     /**
      * Update mouse button state for a button.
@@ -266,8 +372,12 @@ protected:
     static inline std::string SDL_GetKeyNameFromScancode(SDL_Scancode scancode);
 
 private:
-    // Stores state for each key, indexed by key name
-    std::unordered_map<std::string, bool> mKeyboardState;
+    // Stores state for each key, indexed by scancode
+    std::bitset<SDL_NUM_SCANCODES> mKeyboardState;
+    // The state at the start of the frame
+    std::bitset<SDL_NUM_SCANCODES> mPreviousKeyboardState;
+    // The keys bound to each action, indexed by action id
+    std::vector<std::vector<SDL_Scancode>> mActionBindings;
     // Stores state for each mouse button, indexed by MouseButtonNumber - 1
     bool mMouseButtonsState[5]{0, 0, 0, 0, 0};
     bool mIsDragging = false;
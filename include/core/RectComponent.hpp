@@ -29,6 +29,20 @@ public:
      */
     virtual void Render(RenderContext* renderer) override;
 
+    /**
+     * The area the rectangle is drawn in
+     */
+    virtual bool GetBounds(FRect* bounds) override;
+
+    /**
+     * Does no work in Update
+     * @return No access
+     */
+    virtual ComponentAccess GetAccess() const override
+    {
+        return ComponentAccess::None();
+    }
+
     /**
      * Is the given rect intersecting with this rect
      * @param rect The rect we are checking
@@ -38,14 +52,21 @@ public:
 
     inline void SetSize(glm::vec2 size) { mSize = size; }
 
-    inline void SetColor(unsigned char r, unsigned char g, unsigned char b,
-                         unsigned char a = 0xFF);
+    void SetColor(unsigned char r, unsigned char g, unsigned char b,
+                  unsigned char a = 0xFF);
 
     const glm::vec2& GetSize() const { return mSize; }
 
+    /**
+     * Sets the layer to draw on. Lower layers are drawn first.
+     * @param layer The render layer
+     */
+    inline void SetLayer(int layer) { mLayer = layer; }
+
 private:
     unsigned char mColor[4] = {0, 0, 0, 0xFF};
     glm::vec2 mSize{1, 1};
+    int mLayer = 0;
 };
 
 #endif
@@ -3,6 +3,10 @@
 
 #include <glm/vec2.hpp>
 #include "core/IGraphicsEngineRenderer.hpp"
+#include "core/render/RenderThread.hpp"
+#include "core/render/SpriteBatch.hpp"
+#include "core/util/FrameArena.hpp"
+#include "core/util/SDLConversions.hpp"
 
 #if defined(LINUX) || defined(MINGW)
 #include <SDL2/SDL.h>
@@ -12,11 +16,44 @@
 
 struct RenderContext
 {
+    // Only use directly when there is no render thread, see RunOnRenderer
     SDL_Renderer* renderer;
     glm::vec2 worldToCamera;
+    glm::vec2 screenSize;
     int frameIdx;
+    // Scratch memory that is freed at the end of the frame
+    util::FrameArena* frameArena;
+    // Quads drawn this frame, submitted once all game objects have rendered
+    render::SpriteBatch* spriteBatch;
+    // Counters for the current frame
+    render::FrameStats* stats;
+    // Executes recorded frames when rendering is pipelined, otherwise null
+    render::RenderThread* renderThread;
 
     inline SDL_Rect& WorldToCamera(SDL_Rect& rect);
+
+    /**
+     * Run work that needs the renderer right away (e.g. rendering into a
+     * texture). With a render thread, this waits for the frame in flight and
+     * runs the work there, so it should be rare.
+     * @param work The work to run with the renderer
+     */
+    inline void RunOnRenderer(const render::RenderCallback& work)
+    {
+        if (renderThread)
+            renderThread->Invoke(work);
+        else
+            work(renderer);
+    }
+
+    /**
+     * The area of the world that is visible on the screen
+     * @return The view rectangle in world space
+     */
+    inline FRect GetViewRect() const
+    {
+        return FRect(worldToCamera, screenSize);
+    }
 };
 
 inline SDL_Rect& RenderContext::WorldToCamera(SDL_Rect& rect)
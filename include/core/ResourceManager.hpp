@@ -9,15 +9,21 @@
 
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <variant>
+#include <vector>
 
+#include "core/resources/AssetBundle.hpp"
 #include "core/resources/ResourceLoader.hpp"
+#include "core/resources/SceneLoader.hpp"
 #include "core/resources/Spritesheet.hpp"
 #include "core/resources/SpritesheetLoader.hpp"
 #include "core/resources/TextureLoader.hpp"
 #include "core/resources/TilemapLoader.hpp"
+#include "core/util/FileWatcher.hpp"
+#include "core/util/ThreadPool.hpp"
 
 /**
  * Resource manager is a singleton that should be initialized with
@@ -54,6 +60,16 @@ public:
      */
     int Shutdown();
 
+    /**
+     * Serve loads from an asset bundle made by the assetbake tool. Files in
+     * the bundle are loaded from it instead of the disk, the others are still
+     * loaded from the disk. Replaces the bundle mounted before, so it should
+     * be called before loading starts.
+     * @param bundleLoc The location of the bundle
+     * @return 0 if it worked
+     */
+    int MountBundle(const std::string& bundleLoc);
+
     // Expose the resource loaders for use on the singleton instance.
     // Create the loader if it doesn't already exist.
 
@@ -61,19 +77,94 @@ public:
      * Gets the textures
      * @return The textures
      */
-    ResourceLoader<SDL_Texture>* Textures();
+    TextureLoader* Textures();
 
     /**
      * Gets the tile maps
      * @return The tile maps
      */
-    ResourceLoader<TilemapData>* Tilemaps();
+    TilemapLoader* Tilemaps();
 
     /**
      * Gets the spritesheets
      * @return The spritesheets
      */
-    ResourceLoader<Spritesheet>* Spritesheets();
+    SpritesheetLoader* Spritesheets();
+
+    /**
+     * Gets the scenes
+     * @return The scenes
+     */
+    SceneLoader* Scenes();
+
+    /**
+     * Pack all loaded spritesheets into shared atlas textures to cut down on
+     * texture switches while drawing. Drawing with the sheets is unchanged.
+     * @param pageSize The maximum width and height of an atlas texture
+     */
+    void PackSpritesheets(unsigned int pageSize = 2048);
+
+    /**
+     * Finish asynchronous loads whose files have been decoded or read,
+     * within a time budget. Must be called where the renderer may be used.
+     * @param budgetMs The time budget in milliseconds, negative for none
+     */
+    void ProcessUploads(double budgetMs);
+
+    /**
+     * Block until an asynchronous load is ready for ProcessUploads, or none
+     * are left.
+     */
+    void WaitForDecodes();
+
+    /**
+     * Whether there are asynchronous loads that have not finished
+     */
+    bool HasPendingLoads() const;
+
+    /**
+     * Whether textures are over their memory budget, and EvictTextures should
+     * be called before the frame (see TextureLoader::SetMemoryBudget)
+     * @param frameIdx The frame about to be drawn
+     */
+    bool ShouldEvictTextures(int frameIdx) const;
+
+    /**
+     * Evict the textures drawn least recently until they are within their
+     * memory budget. Must be called between frames, where the renderer may
+     * be used.
+     * @param frameIdx The frame about to be drawn
+     */
+    void EvictTextures(int frameIdx);
+
+    /**
+     * Reload textures, spritesheets and tilemaps when their files change on
+     * the disk, so edits show up without restarting. Only supported on
+     * Linux. Changed files are read on the load workers, then swapped into
+     * the loaded resources in place by ApplyReloads, so everything holding
+     * them sees the new data. Files in the asset bundle are reloaded from
+     * their own files.
+     * @param bEnabled Whether to watch for changes
+     * @return 0 if it worked
+     */
+    int EnableHotReload(bool bEnabled);
+
+    /**
+     * Start reading the files that changed since the last call. Called
+     * between frames.
+     */
+    void PollReloads();
+
+    /**
+     * Whether files have been read again and are ready for ApplyReloads
+     */
+    bool HasReloads();
+
+    /**
+     * Swap the files that have been read again into their resources. Must
+     * be called where the renderer may be used, between frames.
+     */
+    void ApplyReloads();
 
 private:
     // Hide the constructor to be used as a singleton
@@ -82,12 +173,55 @@ private:
      */
     ResourceManager();
 
+    /**
+     * A changed file, read again on a load worker.
+     */
+    struct ReloadedFile
+    {
+        std::string fileLoc;
+        // The new image of a texture, if it is one
+        SDL_Surface* surface = nullptr;
+        // The new tiles of a tilemap, if it is one
+        std::shared_ptr<TilemapData> mapData;
+        TilemapFormat mapFormat = TilemapFormat::Text;
+        // Set if the file could not be read
+        std::string error;
+    };
+
+    /**
+     * The load workers, started on first use.
+     */
+    util::ThreadPool* LoadWorkers();
+
+    /**
+     * Watch the files of every loaded resource, if any were loaded since
+     * the last time.
+     */
+    void WatchLoadedFiles();
+
     SDL_Renderer* mRenderer = NULL;
 
+    // Baked assets, looked up by the loaders before the disk
+    std::unique_ptr<AssetBundle> mBundle;
+
+    // The number of threads files are read and decoded on
+    static constexpr unsigned int LOAD_WORKER_COUNT = 2;
+    util::ThreadPool* mLoadWorkers = NULL;
+
+    // Null unless hot reload is enabled
+    std::unique_ptr<util::FileWatcher> mFileWatcher;
+    // The number of resources loaded when files were last watched
+    size_t mWatchedLoadCount = 0;
+    std::vector<std::string> mChangedFiles;
+    // Shared with the load workers:
+    std::mutex mReloadedMutex;
+    std::vector<ReloadedFile> mReloaded;
+
     // All loaders should be stored here:
     TextureLoader* mTextureLoader = NULL;
     TilemapLoader* mTilemapLoader = NULL;
     SpritesheetLoader* mSpritesheetLoader = NULL;
+    SceneLoader* mSceneLoader = NULL;
 };
 
 #endif
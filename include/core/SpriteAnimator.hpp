@@ -3,21 +3,36 @@
 
 #include <iostream>
 #include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "core/Component.hpp"
 #include "core/RenderContext.hpp"
 #include "core/SpriteRenderer.hpp"
 #include "core/resources/Spritesheet.hpp"
 
-struct Animation
+/**
+ * A row of frames on a spritesheet, played in a loop.
+ */
+struct AnimationClip
 {
+    std::string name;
     unsigned int spritesheetRow;
     unsigned int frameCount;
+    // How long each frame is shown, in seconds
+    float frameDuration;
+    // The source rect of every frame on the spritesheet's texture
+    std::vector<SDL_Rect> frames;
 };
 
 /**
  * A SpriteAnimator to cycle through the walking direction animations.
+ *
+ * Animations advance by the frame's deltaTime in Update, so every animator is
+ * stepped in one pass per frame (in parallel, by game object) and playback
+ * speed does not depend on the frame rate. Rendering just draws the current
+ * frame from the active clip's table of source rects.
  */
 class SpriteAnimator : public SpriteRenderer
 {
@@ -31,20 +46,82 @@ public:
      */
     virtual ~SpriteAnimator();
     /**
-     * Render the sprite
+     * Advance the active animation
      */
-    virtual void Render(RenderContext* render) override;
+    virtual void Update(UpdateContext* update) override;
     /**
-     * Receive the broadcasted message
+     * Receive the broadcasted message, playing the animation of the same name
      */
     virtual void Receive(const std::string& message) override;
 
-    void SetAnimation(const std::string& animName, unsigned int spritesheetRow,
-                      unsigned int frameCount);
+    /**
+     * Only steps its own animation
+     * @return Reads and writes sprite state on its own game object
+     */
+    virtual ComponentAccess GetAccess() const override;
+
+    /**
+     * Add an animation
+     * @param animName The name of the animation, which plays it when received
+     * @param spritesheetRow The row of the frames on the spritesheet
+     * @param frameCount The number of frames in the row
+     * @param frameDuration How long each frame is shown, in seconds
+     * @return The id of the animation, for Play
+     */
+    unsigned int SetAnimation(const std::string& animName,
+                              unsigned int spritesheetRow,
+                              unsigned int frameCount,
+                              float frameDuration = 0.2f);
+
+    /**
+     * Find an animation by name, so it can be played without a lookup
+     * @param animName The name of the animation
+     * @param out_clipId Set to the id of the animation if it exists
+     * @return true if the animation exists
+     */
+    bool FindAnimation(const std::string& animName,
+                       unsigned int* out_clipId) const;
+
+    /**
+     * Play an animation from its first frame, unless it is already playing
+     * @param clipId The id of the animation
+     */
+    void Play(unsigned int clipId);
+
+protected:
+    /**
+     * The current frame of the active animation
+     */
+    virtual SDL_Rect GetSourceRect() override;
 
 private:
-    Animation mActiveAnimation{0, 0};
-    std::unordered_map<std::string, Animation> mAnimations;
+    /**
+     * Fill in the source rects of every clip from the spritesheet.
+     */
+    void BuildFrameTables();
+
+    /**
+     * Whether the frame tables were built for the current spritesheet, with
+     * its sprites where they are now. Does not touch the texture, which
+     * may only be used on the main thread.
+     */
+    bool AreFrameTablesCurrent() const
+    {
+        return mTableSheet == mSpritesheet.get() &&
+               mTableVersion == mSpritesheet->GetLayoutVersion();
+    }
+
+    std::vector<AnimationClip> mClips;
+    std::unordered_map<std::string, unsigned int> mClipIds;
+    // What the frame tables were built for. Tables are rebuilt when the
+    // spritesheet changes or moves (e.g. into an atlas).
+    Spritesheet* mTableSheet = nullptr;
+    unsigned int mTableVersion = 0;
+
+    unsigned int mActiveClip = 0;
+    unsigned int mFrame = 0;
+    // Time spent on the current frame, in seconds
+    float mFrameTime = 0;
 };
 
 #endif
@@ -9,6 +9,7 @@
 #include "core/RenderContext.hpp"
 #include "core/TransformComponent.hpp"
 #include "core/UpdateContext.hpp"
+#include "core/resources/ResourceLoader.hpp"
 #include "core/resources/Spritesheet.hpp"
 
 /**
@@ -25,7 +26,22 @@ public:
     virtual void Render(RenderContext* ren) override;
 
     /**
-     * Load a spritesheet
+     * The area the sprite is drawn in
+     */
+    virtual bool GetBounds(FRect* bounds) override;
+
+    /**
+     * Does no work in Update
+     * @return No access
+     */
+    virtual ComponentAccess GetAccess() const override
+    {
+        return ComponentAccess::None();
+    }
+
+    /**
+     * Load a spritesheet. A spritesheet from the resource manager stays
+     * loaded while the sprite uses it.
      * @param spritesheet The spritesheet we are using
      */
     void UseSpritesheet(std::shared_ptr<Spritesheet> spritesheet);
@@ -44,12 +60,30 @@ public:
 
     Size2D GetSize() { return Size2D{mDest.w, mDest.h}; }
 
+    /**
+     * Sets the layer to draw on. Lower layers are drawn first.
+     * @param layer The render layer
+     */
+    inline void SetLayer(int layer) { mLayer = layer; }
+
 private:
     unsigned int mSpriteIndex = 0;
     SDL_Rect mDest{0, 0, 0, 0};
+    int mLayer = 0;
 
 protected:
+    /**
+     * The rect of the sprite to draw on the spritesheet's texture
+     * @return The source rect
+     */
+    virtual SDL_Rect GetSourceRect()
+    {
+        return mSpritesheet->GetSourceRect(mSpriteIndex);
+    }
+
     std::shared_ptr<Spritesheet> mSpritesheet = nullptr;
+    // The reference to mSpritesheet in the spritesheet loader
+    ResourceHandle<Spritesheet> mSpritesheetHandle;
 };
 
 #endif
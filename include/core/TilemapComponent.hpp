@@ -8,19 +8,26 @@
 #include "core/Component.hpp"
 #include "core/IGraphicsEngineRenderer.hpp"
 #include "core/RenderContext.hpp"
+#include "core/resources/ResourceLoader.hpp"
 #include "core/resources/Spritesheet.hpp"
 #include "core/resources/TilemapData.hpp"
+#include "core/resources/TilemapStreamer.hpp"
 
 /**
  * This is a minimal implementation of a Tilemap
+ *
+ * The map is split into square chunks of CHUNK_SIZE x CHUNK_SIZE tiles. Each
+ * chunk is rendered once into its own target texture (at the resolution of the
+ * spritesheet), and only re-rendered when one of its tiles changes, so a frame
+ * draws one quad per chunk instead of one per tile.
  */
-class TilemapComponent : public Component
+class TilemapComponent : public Component, public ITilemapChangeListener
 {
 public:
     /**
      * Constructor for a tilemap
      */
-    TilemapComponent(std::shared_ptr<Spritesheet>& textureAtlas);
+    TilemapComponent(std::shared_ptr<Spritesheet> textureAtlas);
     /**
      * Destructor for a tilemap
      */
@@ -28,8 +35,23 @@ public:
 
     virtual void Render(RenderContext* ren) override;
 
+    /**
+     * Does no work in Update
+     * @return No access
+     */
+    virtual ComponentAccess GetAccess() const override
+    {
+        return ComponentAccess::None();
+    }
+
     void SetDisplayTileSize(Size2D size) { mTileDisplaySize = size; }
 
+    /**
+     * Sets the layer to draw on. Lower layers are drawn first.
+     * @param layer The render layer
+     */
+    inline void SetLayer(int layer) { mLayer = layer; }
+
     /**
      * Given a file, generates a tile map.
      *
@@ -37,6 +59,21 @@ public:
      */
     void GenerateMapFromFile(std::string filePath);
 
+    /**
+     * Stream the map from a world directory (see TilemapStreamer), loading
+     * the chunks around the view as it moves.
+     *
+     * @param worldDir the directory of the world
+     */
+    void StreamMapFromDirectory(std::string worldDir);
+
+    /**
+     * Gets the streamer, to configure streaming.
+     *
+     * @return the streamer, or null if the map is not streamed
+     */
+    TilemapStreamer* GetStreamer() { return mStreamer.get(); }
+
     /**
      * Converts the given world position to tile position in this tile map.
      *
@@ -45,6 +82,18 @@ public:
      */
     glm::vec2 WorldPosToTilePos(const glm::vec2& worldPos) const;
 
+    /**
+     * Get the range of tiles (clamped to the map) that overlap a world space
+     * rectangle. Shared by rendering (to cull the view) and collision.
+     *
+     * @param worldRect the rectangle in world space
+     * @param out_first set to the top left tile of the range
+     * @param out_last set to the bottom right tile of the range (inclusive)
+     * @return false if the rectangle does not overlap the map
+     */
+    bool GetTileRange(const FRect& worldRect, TileLoc* out_first,
+                      TileLoc* out_last) const;
+
     void GetTileDisplayRect(SDL_Rect* out_rect, RenderContext* ren,
                             TileLoc tile) const;
 
@@ -55,15 +104,92 @@ public:
      */
     std::shared_ptr<TilemapData> GetTileMapData();
 
+    /**
+     * Mark the chunk containing the tile for re-rendering.
+     * @param tileLoc The location of the tile that changed
+     */
+    virtual void HandleTileChanged(TileLoc tileLoc) override;
+
+    /**
+     * Throw away all chunks, since their layout no longer matches the map.
+     */
+    virtual void HandleTilemapResized() override;
+
+    /**
+     * Throw away the chunks in the area, since the area was loaded or
+     * unloaded as a whole.
+     * @param first The top left tile of the area
+     * @param size The size of the area, in tiles
+     */
+    virtual void HandleAreaChanged(TileLoc first, Size2D size) override;
+
+    /**
+     * Throw away the chunk textures, whose contents were lost, so they are
+     * rendered again.
+     */
+    virtual void HandleRenderTargetsReset() override { ReleaseChunks(); }
+
+    // The width and height of a render chunk, in tiles
+    static constexpr unsigned int CHUNK_SIZE = 32;
+
 private:
+    /**
+     * A block of tiles pre-rendered into a texture.
+     */
+    struct RenderChunk
+    {
+        // Counted in the texture memory (see TextureLoader::AdoptTexture)
+        std::shared_ptr<SDL_Texture> texture;
+        bool bDirty = true;
+    };
+
+    /**
+     * Get the number of tiles covered by the given chunk (edge chunks may be
+     * smaller than CHUNK_SIZE).
+     * @param chunkLoc The location of the chunk, in chunks
+     * @return The size of the chunk, in tiles
+     */
+    Size2D GetChunkTiles(TileLoc chunkLoc) const;
+
+    /**
+     * Render the tiles of a chunk into its texture.
+     * @param renderer The renderer, which must be safe to use on this thread
+     * @param atlasTexture The texture of the spritesheet (see
+     * Spritesheet::UseTexture)
+     * @param chunkLoc The location of the chunk, in chunks
+     */
+    void RebuildChunk(SDL_Renderer* renderer, SDL_Texture* atlasTexture,
+                      TileLoc chunkLoc);
+
+    /**
+     * Draw the tiles of a chunk directly, for when it has no texture.
+     * @param ren The render data
+     * @param chunkLoc The location of the chunk, in chunks
+     */
+    void DrawChunkTiles(RenderContext* ren, TileLoc chunkLoc);
+
+    /**
+     * Throw away all chunks, retiring their textures.
+     */
+    void ReleaseChunks();
+
     // How big each tile is in the world.
     Size2D mTileDisplaySize{0, 0};
+    int mLayer = 0;
     // Where our Tilemap is rendered
     // An SDL Surface contains pixel data to draw our Tilemap
-    std::shared_ptr<Spritesheet>& mTextureAtlas;
+    std::shared_ptr<Spritesheet> mTextureAtlas;
     std::string mTextureFilePath;
     // Stores our tile types
     std::shared_ptr<TilemapData> mMapData;
+    // The reference to mMapData in the tilemap loader, unless it is streamed
+    ResourceHandle<TilemapData> mMapHandle;
+    // Streams mMapData in around the view, if it is streamed
+    std::unique_ptr<TilemapStreamer> mStreamer;
+
+    // Pre-rendered chunks, row major
+    std::vector<RenderChunk> mChunks;
+    Size2D mChunkCount{0, 0};
 };
 
 #endif
@@ -1,12 +1,20 @@
 #ifndef TRANSFORMCOMPONENT_HPP
 #define TRANSFORMCOMPONENT_HPP
 
+#include <cstdint>
+#include <vector>
+
 #include <glm/vec2.hpp>
 #include "core/Component.hpp"
 
 /**
  * The component that holds information on where a game object
  * is in world position, which can be observed, and modified.
+ *
+ * Transforms can be parented to other transforms. The position of a child is
+ * stored relative to its parent, and the world position is cached. A transform
+ * is marked dirty (along with all of its descendants) when it moves, and the
+ * cache is refreshed by the TransformHierarchy once per frame.
  */
 class TransformComponent : public Component
 {
@@ -14,21 +22,91 @@ public:
     TransformComponent();
     virtual ~TransformComponent();
 
-    glm::vec2 GetPosition() const { return mPosition; }
+    virtual ComponentAccess GetAccess() const override
+    {
+        return ComponentAccess::None();
+    }
+
+    /**
+     * Get the world position of this transform.
+     * Uses the cached world position unless this transform is dirty.
+     * @return The world position
+     */
+    glm::vec2 GetPosition() const
+    {
+        if (!mbDirty) return mWorldPosition;
+        return mParent ? mParent->GetPosition() + mLocalPosition
+                       : mLocalPosition;
+    }
+
+    /**
+     * Get the position of this transform relative to its parent.
+     * @return The local position
+     */
+    glm::vec2 GetLocalPosition() const { return mLocalPosition; }
 
-    inline void SetPosition(float x, float y) { SetPosition(x, y); }
-    inline void SetPosition(glm::vec2 pos) { mPosition = pos; }
+    // NOTE: positions are local to the parent (world position for roots).
+    inline void SetPosition(float x, float y) { SetPosition({x, y}); }
+    inline void SetPosition(glm::vec2 pos)
+    {
+        mLocalPosition = pos;
+        MarkDirty();
+    }
     inline void TranslatePosition(float x, float y)
     {
         TranslatePosition({x, y});
     }
     inline void TranslatePosition(glm::vec2 translate)
     {
-        mPosition += translate;
+        mLocalPosition += translate;
+        MarkDirty();
     }
 
+    /**
+     * Attach this transform to a new parent (or detach it with nullptr).
+     * The world position is preserved, the local position is recomputed.
+     * @param parent The new parent transform
+     */
+    void SetParent(TransformComponent* parent);
+
+    TransformComponent* GetParent() const { return mParent; }
+    const std::vector<TransformComponent*>& GetChildren() const
+    {
+        return mChildren;
+    }
+
+    /**
+     * The number of ancestors above this transform (0 for roots).
+     */
+    unsigned int GetDepth() const { return mDepth; }
+
+    bool IsDirty() const { return mbDirty; }
+
 private:
-    glm::vec2 mPosition{0, 0};
+    /**
+     * Flag this transform and all of its descendants for recomputation.
+     * Early-outs on an already dirty transform, since dirty transforms always
+     * have dirty descendants.
+     */
+    void MarkDirty();
+
+    /**
+     * Recompute the depth of this transform and all of its descendants.
+     */
+    void UpdateDepth();
+
+    glm::vec2 mLocalPosition{0, 0};
+    glm::vec2 mWorldPosition{0, 0};
+    bool mbDirty = true;
+
+    unsigned int mDepth = 0;
+    // Where the transform is in the TransformHierarchy, if it is in one
+    size_t mHierarchyIndex = NOT_IN_HIERARCHY;
+    static constexpr size_t NOT_IN_HIERARCHY = SIZE_MAX;
+    TransformComponent* mParent = nullptr;
+    std::vector<TransformComponent*> mChildren;
+
+    friend class TransformHierarchy;
 };
 
 #endif
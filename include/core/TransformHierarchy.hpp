@@ -0,0 +1,69 @@
+#ifndef __TRANSFORMHIERARCHY_HPP__
+#define __TRANSFORMHIERARCHY_HPP__
+
+#include <cstddef>
+#include <vector>
+
+class TransformComponent;
+namespace util
+{
+class ScopeArena;
+}
+
+/**
+ * Keeps every transform in the scene in a flat array sorted by depth
+ * (parents always come before their children), so that world positions can be
+ * propagated breadth-first in a single linear pass.
+ *
+ * Only dirty transforms are recomputed; a dirty parent always has dirty
+ * children, so clean subtrees are skipped entirely.
+ *
+ * Each transform knows its index in the array, so removing one only leaves
+ * a gap, and the gaps are closed in one pass by the next propagation.
+ */
+class TransformHierarchy
+{
+public:
+    /**
+     * Start tracking the given transform.
+     * @param transform The transform to add
+     */
+    void Add(TransformComponent* transform);
+
+    /**
+     * Stop tracking the given transform, in constant time.
+     * @param transform The transform to remove
+     */
+    void Remove(TransformComponent* transform);
+
+    /**
+     * Stop tracking the transforms of every game object made in an arena, in
+     * one pass, so destroying them after is cheap.
+     * @param arena The arena of the game objects
+     */
+    void RemoveScope(const util::ScopeArena* arena);
+
+    /**
+     * Notify the hierarchy that a transform has changed parents, so the array
+     * must be re-sorted before the next propagation.
+     */
+    void MarkOrderDirty() { mbOrderDirty = true; }
+
+    /**
+     * Recompute the cached world position of every dirty transform.
+     */
+    void Propagate();
+
+private:
+    /**
+     * Store the index of every transform in it, after they moved.
+     */
+    void UpdateIndices();
+
+    // Null where a transform was removed since the last propagation
+    std::vector<TransformComponent*> mTransforms;
+    size_t mRemovedCount = 0;
+    bool mbOrderDirty = false;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define __UPDATECONTEXT_HPP__
 
 #include <glm/vec2.hpp>
+#include "core/util/FrameArena.hpp"
 
 #if defined(LINUX) || defined(MINGW)
 #include <SDL2/SDL.h>
@@ -18,7 +19,10 @@
 struct UpdateContext
 {
     glm::vec2 cameraCenter;
+    // Measured time since the previous frame started, in seconds
     float deltaTime;
+    // Scratch memory that is freed at the end of the frame
+    util::FrameArena* frameArena;
 };
 
 #endif
@@ -47,6 +47,15 @@ public:
      */
     virtual void SetIsTrigger(bool isTrigger);
 
+    /**
+     * Does no work in Update
+     * @return No access
+     */
+    virtual ComponentAccess GetAccess() const override
+    {
+        return ComponentAccess::None();
+    }
+
 #ifdef GIZMOS
     virtual void DrawGizmos(RenderContext* renderer,
                             util::Gizmos* util) override = 0;
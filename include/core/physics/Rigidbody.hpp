@@ -15,6 +15,11 @@ public:
 
     virtual void Start() override;
 
+    virtual ComponentAccess GetAccess() const override
+    {
+        return ComponentAccess::None();
+    }
+
 private:
     glm::vec2 mPos{0, 0};
     glm::vec2 mVel{0, 0};
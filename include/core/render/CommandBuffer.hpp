@@ -0,0 +1,117 @@
+#ifndef __COMMANDBUFFER_HPP__
+#define __COMMANDBUFFER_HPP__
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#if defined(LINUX) || defined(MINGW)
+#include <SDL2/SDL.h>
+#else  // This works for Mac
+#include <SDL.h>
+#endif
+
+namespace render
+{
+
+/**
+ * Counters for the draw work of a single frame.
+ */
+struct FrameStats
+{
+    // Quads recorded by components
+    unsigned int quads = 0;
+    // Draw calls issued to the renderer
+    unsigned int drawCalls = 0;
+    // Runs of consecutive quads (after sorting) that share a texture
+    unsigned int batches = 0;
+    // Quads in the largest batch
+    unsigned int largestBatch = 0;
+    // Game objects skipped because they were outside the view
+    unsigned int culledObjects = 0;
+    // Tiles skipped because they were outside the view
+    unsigned int culledTiles = 0;
+
+    float AverageBatchSize() const
+    {
+        return batches == 0 ? 0.0f : (float)quads / batches;
+    }
+};
+
+/**
+ * A textured (or solid color, when there is no texture) quad to draw.
+ */
+struct SpriteQuad
+{
+    SDL_Texture* texture;
+    // Quads are drawn in increasing key order, see SpriteBatch::MakeSortKey
+    uint64_t sortKey;
+    SDL_FRect dest;
+    // Normalized texture coordinates
+    SDL_FRect uv;
+    SDL_Color color;
+};
+
+/**
+ * Work that has to talk to the renderer directly.
+ */
+typedef std::function<void(SDL_Renderer*)> RenderCallback;
+
+/**
+ * Everything recorded for one frame, ready to be executed on the renderer.
+ *
+ * A command buffer is recorded on the main thread and may be executed on
+ * another one, so nothing in it may point into memory that only lives for
+ * the frame being recorded (such as the frame arena).
+ */
+class CommandBuffer
+{
+public:
+    /**
+     * Remove all commands and reset the stats, keeping the allocated memory.
+     */
+    void Clear();
+
+    /**
+     * Clear the screen, then draw the quads (sorted by key, one draw call per
+     * run of quads sharing a texture) and the overlays. Does not present.
+     * @param renderer The renderer to draw with, or null to only sort and
+     * count the draws (overlays are skipped)
+     */
+    void Execute(SDL_Renderer* renderer);
+
+    // The color the screen is cleared to
+    SDL_Color clearColor{0, 0, 0, 0xFF};
+    std::vector<SpriteQuad> quads;
+    // Drawn on top of the quads in the order they were recorded
+    std::vector<RenderCallback> overlays;
+    // Culling counters are filled in while recording, draw counters while
+    // executing
+    FrameStats stats;
+
+private:
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    /**
+     * Order the quads by key with a stable LSD radix sort, one byte per pass.
+     * Passes where every key has the same byte are skipped.
+     */
+    void SortQuads();
+
+    void SubmitRun(SDL_Renderer* renderer, size_t begin, size_t end);
+
+    // Reused between executions to avoid reallocating every frame
+    std::vector<SortEntry> mSortEntries;
+    std::vector<SortEntry> mSortScratch;
+    std::vector<SpriteQuad> mSortedQuads;
+    std::vector<SDL_Vertex> mVertices;
+    std::vector<int> mIndices;
+};
+
+}  // namespace render
+
+#endif  // __COMMANDBUFFER_HPP__
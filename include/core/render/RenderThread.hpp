@@ -0,0 +1,99 @@
+#ifndef __RENDERTHREAD_HPP__
+#define __RENDERTHREAD_HPP__
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "core/IGraphicsEngineRenderer.hpp"
+#include "core/render/CommandBuffer.hpp"
+
+namespace render
+{
+
+/**
+ * A thread that executes recorded command buffers on the renderer, so the
+ * main thread can update and record the next frame while the previous one
+ * is being drawn.
+ *
+ * At most one frame is in flight. The render thread is the only thread that
+ * may use the renderer: anything else that needs the renderer (creating or
+ * destroying textures, rendering into a texture) must go through Invoke.
+ *
+ * SDL only guarantees the render API works on the thread that created the
+ * renderer, so a renderer that was not created yet is created on the render
+ * thread (see IGraphicsEngineRenderer::CreateRenderer), and destroyed there
+ * when it stops. Backends that bind a context to a thread (e.g. OpenGL) then
+ * work too.
+ */
+class RenderThread
+{
+public:
+    /**
+     * Starts the render thread, and waits for it to create the renderer if
+     * it was not created yet
+     * @param renderer The renderer to draw and present with
+     */
+    explicit RenderThread(IGraphicsEngineRenderer* renderer);
+
+    /**
+     * Finishes the frame in flight and joins the thread. A renderer the
+     * thread created is destroyed on it first.
+     */
+    ~RenderThread();
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    /**
+     * Wait for the previous frame to finish, then start executing and
+     * presenting the given one. The buffer must not be touched until the
+     * next call to Submit (or WaitIdle) returns.
+     * @param buffer The recorded frame
+     * @return The stats of the previous frame
+     */
+    FrameStats Submit(CommandBuffer* buffer);
+
+    /**
+     * Run work on the render thread once the frame in flight is done, and
+     * block until it has run.
+     * @param work The work to run with the renderer
+     */
+    void Invoke(const RenderCallback& work);
+
+    /**
+     * Block until the frame in flight is done.
+     * @return The stats of the frame
+     */
+    FrameStats WaitIdle();
+
+private:
+    void ThreadLoop();
+
+    /**
+     * Whether nothing is queued or running. Must hold mMutex.
+     */
+    bool IsIdle() const { return !mPendingFrame && !mPendingWork; }
+
+    IGraphicsEngineRenderer* mRenderer;
+    // Whether the thread created the renderer, and so destroys it
+    bool mbOwnsRenderer = false;
+    // Set once the thread tried to create the renderer
+    bool mbStarted = false;
+    std::thread mThread;
+    std::mutex mMutex;
+    // Signaled when there is work for the render thread
+    std::condition_variable mWorkAvailable;
+    // Signaled when the render thread finishes its work
+    std::condition_variable mWorkDone;
+
+    CommandBuffer* mPendingFrame = nullptr;
+    const RenderCallback* mPendingWork = nullptr;
+    // Written by the render thread, only read with mMutex held
+    FrameStats mCompletedStats;
+    bool mbStopping = false;
+};
+
+}  // namespace render
+
+#endif  // __RENDERTHREAD_HPP__
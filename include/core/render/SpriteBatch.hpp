@@ -0,0 +1,112 @@
+#ifndef __SPRITEBATCH_HPP__
+#define __SPRITEBATCH_HPP__
+
+#if defined(LINUX) || defined(MINGW)
+#include <SDL2/SDL.h>
+#else  // This works for Mac
+#include <SDL.h>
+#endif
+
+#include <cstdint>
+#include <glm/vec2.hpp>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "core/render/CommandBuffer.hpp"
+
+namespace render
+{
+
+/**
+ * Records the quads drawn during a frame into a command buffer, which later
+ * submits them in as few draw calls as possible.
+ *
+ * Every quad gets a sort key of (layer, y, texture, depth), so the draw order
+ * does not depend on the order game objects were created in:
+ * - lower layers draw first
+ * - on y-sorted layers, quads whose bottom edge is higher on the screen draw
+ *   first (so things further down overlap things behind them)
+ * - quads are then grouped by texture to keep draw calls down
+ * - deeper quads (e.g. children in the transform hierarchy) draw on top
+ * Quads with equal keys keep the order they were recorded in, and each run of
+ * quads sharing a texture is submitted as a single vertex/index batch with
+ * SDL_RenderGeometry.
+ *
+ * NOTE: quads on the same layer (and y, if y-sorted) are reordered by
+ * texture, so overlapping sprites that must draw in a fixed order need
+ * different layers or depths.
+ */
+class SpriteBatch
+{
+public:
+    /**
+     * Set the command buffer to record into.
+     * @param buffer The command buffer of the frame being recorded
+     */
+    void SetTarget(CommandBuffer* buffer);
+
+    /**
+     * Set whether quads on a layer are ordered by their bottom edge.
+     * @param layer The layer
+     * @param bYSorted Whether to sort by y
+     */
+    void SetLayerYSorted(int layer, bool bYSorted);
+
+    /**
+     * Check whether quads on a layer are ordered by their bottom edge.
+     * @param layer The layer
+     * @return Whether the layer is sorted by y
+     */
+    bool IsLayerYSorted(int layer) const
+    {
+        return mYSortedLayers.count(layer) != 0;
+    }
+
+    /**
+     * Queue a textured quad.
+     * @param texture The texture to sample from
+     * @param textureSize The size of the texture in pixels
+     * @param src The source rect on the texture
+     * @param dest The destination rect on the screen
+     * @param layer The layer to draw on, lower layers draw first
+     * @param depth Draws above lower depths with the same layer, y and texture
+     */
+    void Draw(SDL_Texture* texture, glm::uvec2 textureSize,
+              const SDL_Rect& src, const SDL_Rect& dest, int layer = 0,
+              unsigned int depth = 0);
+
+    /**
+     * Queue a solid color quad.
+     * @param color The fill color
+     * @param dest The destination rect on the screen
+     * @param layer The layer to draw on, lower layers draw first
+     */
+    void Fill(SDL_Color color, const SDL_Rect& dest, int layer = 0);
+
+    /**
+     * Queue drawing that goes on top of all quads (e.g. debug gizmos).
+     * @param overlay Draws with the renderer. It may run on another thread
+     * after the frame has been recorded, so it must capture by value.
+     */
+    void DrawOverlay(RenderCallback overlay);
+
+    size_t GetQueuedCount() const { return mTarget->quads.size(); }
+
+private:
+    /**
+     * Pack the draw order of a quad into a key. From the most significant
+     * bits: layer (16), bottom edge y (24), texture id (16), depth (8).
+     * Values out of range are clamped.
+     */
+    uint64_t MakeSortKey(SDL_Texture* texture, const SDL_Rect& dest,
+                         int layer, unsigned int depth);
+
+    CommandBuffer* mTarget = nullptr;
+    std::unordered_set<int> mYSortedLayers;
+    // Small ids for the textures drawn this frame, in the order first seen
+    std::unordered_map<SDL_Texture*, uint16_t> mTextureIds;
+};
+
+}  // namespace render
+
+#endif  // __SPRITEBATCH_HPP__
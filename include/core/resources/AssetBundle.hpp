@@ -0,0 +1,212 @@
+#ifndef __ASSETBUNDLE_HPP__
+#define __ASSETBUNDLE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/util/MappedFile.hpp"
+
+#if defined(LINUX) || defined(MINGW)
+#include <SDL2/SDL.h>
+#else  // This works for Mac
+#include <SDL.h>
+#endif
+
+/**
+ * The kinds of asset a bundle holds.
+ *
+ * Texture: a BakedTextureHeader, then the rows of pixels, already in the
+ * pixel format the renderer uses.
+ * Tilemap: a binary tilemap file (see TilemapFormat), page aligned in the
+ * bundle so it can be used in place.
+ * Scene: a binary scene file (see SceneFormat).
+ */
+enum class AssetType : uint32_t
+{
+    None = 0,
+    Texture = 1,
+    Tilemap = 2,
+    Scene = 3
+};
+
+/**
+ * The start of an asset bundle file.
+ *
+ * A bundle is the header, the data of every asset, the index and then the
+ * paths of the assets. The index is a hash table of AssetBundleEntry, found
+ * by the hash of the path (see AssetBundle::HashPath) and probed linearly.
+ * Everything is in native byte order, like binary tilemaps.
+ */
+struct AssetBundleHeader
+{
+    static constexpr char MAGIC[4] = {'A', 'B', 'N', 'D'};
+    // Increase when the layout changes; older versions are not loaded
+    static constexpr uint16_t VERSION = 1;
+
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    // The number of buckets in the index, a power of two
+    uint32_t bucketCount;
+    uint32_t assetCount;
+    // Where the index and the paths start in the file
+    uint64_t indexOffset;
+    uint64_t pathsOffset;
+};
+
+/**
+ * A bucket of the index of an asset bundle.
+ */
+struct AssetBundleEntry
+{
+    // The hash of the path, 0 for an empty bucket
+    uint64_t pathHash;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+    // The path, to tell apart paths with the same hash
+    uint32_t pathOffset;
+    uint32_t pathLength;
+    AssetType type;
+    uint32_t reserved;
+};
+
+/**
+ * The start of a baked texture. The pixels follow it.
+ */
+struct BakedTextureHeader
+{
+    uint32_t width;
+    uint32_t height;
+    // The number of bytes in a row of pixels
+    uint32_t pitch;
+    // The SDL_PixelFormatEnum of the pixels
+    uint32_t pixelFormat;
+    // The sprite size of a spritesheet, or 0 x 0 if it was not given
+    uint32_t spriteWidth;
+    uint32_t spriteHeight;
+    // Whether the source image had alpha or a color key, so the texture is
+    // drawn with blending
+    uint32_t bBlend;
+    uint32_t reserved;
+};
+
+/**
+ * A bundle of baked assets, mapped into memory in one go. Made offline by the
+ * assetbake tool (see AssetBundleBuilder). The loaders look files up in the
+ * mounted bundle before going to the disk (see ResourceManager::MountBundle).
+ *
+ * Paths are looked up as they are given to the loaders, without a leading
+ * "./".
+ */
+class AssetBundle
+{
+public:
+    /**
+     * Map a bundle and check its index.
+     * @param bundleLoc The location of the bundle
+     * @throws std::invalid_argument if the file is not a bundle this version
+     * can read
+     */
+    explicit AssetBundle(const std::string& bundleLoc);
+
+    /**
+     * Find an asset.
+     * @param path The path the asset was baked from
+     * @param type The type of the asset
+     * @return The entry of the asset, or null if it is not in the bundle
+     */
+    const AssetBundleEntry* Find(const std::string& path,
+                                 AssetType type) const;
+
+    /**
+     * Find a baked texture.
+     * @param path The path the texture was baked from
+     * @return The header of the texture, followed by its pixels, or null if
+     * it is not in the bundle
+     */
+    const BakedTextureHeader* FindTexture(const std::string& path) const;
+
+    /**
+     * Make a surface of a baked texture's pixels, without copying them. The
+     * surface must be freed before the bundle.
+     * @param path The path the texture was baked from
+     * @return The surface, or null if the texture is not in the bundle
+     */
+    SDL_Surface* CreateSurface(const std::string& path) const;
+
+    /**
+     * The mapped bundle, shared with assets that are used in place
+     */
+    const std::shared_ptr<util::MappedFile>& GetFile() const { return mFile; }
+
+    unsigned int GetAssetCount() const { return mHeader.assetCount; }
+
+    /**
+     * Hash a path for the index. Never 0, which marks empty buckets.
+     * @param path The path, normalized (see NormalizePath)
+     */
+    static uint64_t HashPath(const std::string& path);
+
+    /**
+     * Drop the leading "./" of a path, so both spellings find the asset.
+     */
+    static std::string NormalizePath(const std::string& path);
+
+private:
+    std::shared_ptr<util::MappedFile> mFile;
+    AssetBundleHeader mHeader;
+    const AssetBundleEntry* mIndex = nullptr;
+    const char* mPaths = nullptr;
+};
+
+/**
+ * Collects assets and writes them out as a bundle.
+ */
+class AssetBundleBuilder
+{
+public:
+    /**
+     * Add an image as a texture, converting it to a pixel format first.
+     * @param path The path the texture is loaded by
+     * @param surface The image
+     * @param pixelFormat The SDL_PixelFormatEnum to store the pixels in
+     * @param spriteWidth The width of a sprite, or 0 if not a spritesheet
+     * @param spriteHeight The height of a sprite, or 0 if not a spritesheet
+     * @throws std::runtime_error if the image could not be converted
+     */
+    void AddTexture(const std::string& path, SDL_Surface* surface,
+                    uint32_t pixelFormat, uint32_t spriteWidth = 0,
+                    uint32_t spriteHeight = 0);
+
+    /**
+     * Add an asset that is already in its baked form.
+     * @param path The path the asset is loaded by
+     * @param type The type of the asset
+     * @param data The baked asset
+     */
+    void AddAsset(const std::string& path, AssetType type, std::string data);
+
+    /**
+     * Write the bundle. The file is replaced once it is fully written, so it
+     * is safe to write over a mounted bundle.
+     * @param bundleLoc The location of the bundle
+     */
+    void Write(const std::string& bundleLoc) const;
+
+    unsigned int GetAssetCount() const { return mAssets.size(); }
+
+private:
+    struct Asset
+    {
+        std::string path;
+        AssetType type;
+        std::string data;
+    };
+
+    std::vector<Asset> mAssets;
+};
+
+#endif  // __ASSETBUNDLE_HPP__
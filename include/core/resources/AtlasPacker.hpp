@@ -0,0 +1,74 @@
+#ifndef __ATLASPACKER_HPP__
+#define __ATLASPACKER_HPP__
+
+#include <glm/vec2.hpp>
+#include <vector>
+
+/**
+ * Packs rectangles into fixed size pages using shelves: rectangles are placed
+ * left to right in rows (shelves) as tall as the first rectangle of the row,
+ * and a new page is started when a rectangle fits on no shelf.
+ *
+ * Shelves waste little space when rectangles are inserted tallest first.
+ */
+class AtlasPacker
+{
+public:
+    /**
+     * Constructor
+     * @param pageSize The width and height of every page
+     * @param padding Empty pixels kept between rectangles, so sampling one
+     * never bleeds into its neighbors
+     */
+    AtlasPacker(glm::uvec2 pageSize, unsigned int padding = 1);
+
+    /**
+     * Find a place for a rectangle.
+     * @param size The size of the rectangle
+     * @param out_page Set to the page the rectangle was placed on
+     * @param out_origin Set to the top left corner of the rectangle on the
+     * page
+     * @return false if the rectangle is larger than a page
+     */
+    bool Insert(glm::uvec2 size, unsigned int* out_page,
+                glm::uvec2* out_origin);
+
+    /**
+     * The number of pages that have been started
+     */
+    unsigned int GetPageCount() const { return mPages.size(); }
+
+    /**
+     * The area of a page that has rectangles in it. Pages can be cropped to
+     * this when creating their textures.
+     * @param page The index of the page
+     * @return The used width and height
+     */
+    glm::uvec2 GetUsedSize(unsigned int page) const;
+
+private:
+    struct Shelf
+    {
+        unsigned int y;
+        unsigned int height;
+        // Where the next rectangle on this shelf goes
+        unsigned int x;
+    };
+
+    struct Page
+    {
+        std::vector<Shelf> shelves;
+        glm::uvec2 usedSize{0, 0};
+    };
+
+    /**
+     * Try to place a rectangle on an existing page.
+     */
+    bool InsertInto(Page& page, glm::uvec2 size, glm::uvec2* out_origin);
+
+    glm::uvec2 mPageSize;
+    unsigned int mPadding;
+    std::vector<Page> mPages;
+};
+
+#endif  // __ATLASPACKER_HPP__
@@ -1,21 +1,49 @@
 #ifndef __RESOURCE_LOADER_HPP__
 #define __RESOURCE_LOADER_HPP__
 
+#include <cstdint>
+#include <exception>
+#include <future>
 #include <memory>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <vector>
+
+/**
+ * A reference to a resource in its loader, taken with ResourceLoader::Acquire.
+ * The slot finds the resource without a lookup, and the generation tells
+ * whether the slot still holds the same resource, since slots are reused
+ * once a resource is freed.
+ * @tparam ResourceT The type of the resource
+ */
+template <typename ResourceT>
+struct ResourceHandle
+{
+    static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+    uint32_t slot = INVALID_SLOT;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return slot != INVALID_SLOT; }
+};
 
 /**
  * Abstract base class for all resource loaders.
  * Unifies the process of loading, retrieving, and freeing local resources from
  * disk.
+ *
+ * Resources live in a table of slots, found by file or by the pointer to the
+ * resource in constant time. Each slot counts the references taken with
+ * Acquire, and the resource is freed when the last one is released.
  * @tparam ResourceT The type of the resource
  */
 template <typename ResourceT>
 class ResourceLoader
 {
 public:
+    typedef ResourceHandle<ResourceT> Handle;
+
     /**
      * A destructor for Resource Loader
      */
@@ -29,6 +57,15 @@ public:
      */
     virtual void Load(std::string fileLoc) = 0;
 
+    /**
+     * Start loading the data from the file at fileLoc without waiting for
+     * it, if the loader supports it. Other loaders load it right away.
+     * @param fileLoc The location of the loaded file
+     * @return A future that is ready once Get returns the resource, holding
+     * the exception if it could not be loaded
+     */
+    virtual std::shared_future<void> LoadAsync(std::string fileLoc);
+
     /**
      * Save the data to the corresponding file (if implemented).
      * @param resource The place we are saving to
@@ -42,12 +79,79 @@ public:
      */
     std::shared_ptr<ResourceT> Get(std::string fileLoc);
 
+    /**
+     * Retrieve the resource a handle refers to.
+     * @param handle The handle of the resource
+     * @return The resource, or null if it has been freed since
+     */
+    std::shared_ptr<ResourceT> Get(Handle handle) const;
+
+    /**
+     * Whether the file has been loaded
+     * @param fileLoc The location of the file
+     */
+    bool IsLoaded(const std::string& fileLoc) const
+    {
+        return mSlotsByFile.count(fileLoc) != 0;
+    }
+
+    /**
+     * Take a reference to a loaded resource, which keeps it loaded until it
+     * is released.
+     * @param fileLoc The location of the file
+     * @return The handle of the resource, invalid if it is not loaded
+     */
+    Handle Acquire(const std::string& fileLoc);
+
+    /**
+     * Take a reference to a loaded resource, which keeps it loaded until it
+     * is released.
+     * @param resource The resource, as returned by Get
+     * @return The handle of the resource, invalid if it did not come from
+     * this loader
+     */
+    Handle Acquire(const std::shared_ptr<ResourceT>& resource);
+
+    /**
+     * Give up a reference taken with Acquire, freeing the resource if it was
+     * the last one. The handle is invalid afterwards.
+     * @param handle The handle of the resource
+     */
+    void Release(Handle& handle);
+
     /**
      * Free the loaded resource from memory.
-     * @param resource The resource we are destroying
+     * Gives up a reference taken with Acquire, or frees the resource right
+     * away if there are none.
+     * @param resource The resource we are destroying, reset afterwards
      */
     void Destroy(std::shared_ptr<ResourceT>& resource);
 
+    /**
+     * Free a loaded resource unless references are taken to it (see
+     * Acquire). Holders of the shared_ptr keep it alive until they let go.
+     * @param fileLoc The location of the file
+     * @return true if the resource was freed
+     */
+    bool FreeUnreferenced(const std::string& fileLoc);
+
+    /**
+     * The number of references taken to a resource
+     * @param handle The handle of the resource
+     */
+    unsigned int GetRefCount(Handle handle) const;
+
+    /**
+     * Add the location of every loaded file to a list.
+     * @param out The list to add to
+     */
+    void GetLoadedFiles(std::vector<std::string>& out) const;
+
+    /**
+     * The number of resources loaded so far, to tell when new ones were
+     */
+    size_t GetLoadCount() const { return mLoadCount; }
+
 protected:
     // Protected to emphasize abstract base class
     /**
@@ -55,14 +159,62 @@ protected:
      */
     ResourceLoader();
 
-    std::unordered_map<std::string, std::shared_ptr<ResourceT>> mResources;
+    /**
+     * A loaded resource, or a free slot if resource is null
+     */
+    struct ResourceSlot
+    {
+        std::string fileLoc;
+        std::shared_ptr<ResourceT> resource;
+        unsigned int refCount = 0;
+        // Bumped when the slot is freed, so old handles stop matching
+        uint32_t generation = 0;
+    };
+
+    /**
+     * Add a loaded resource to the table.
+     * @param fileLoc The location of the loaded file
+     * @param resource The resource, which must not be null
+     * @return The handle of the resource
+     */
+    Handle AddResource(const std::string& fileLoc,
+                       std::shared_ptr<ResourceT> resource);
+
+    /**
+     * Swap a new copy of a resource into the table, e.g. after its file
+     * changed. Handles to the old copy now get the new one. Adds the
+     * resource if it is not loaded.
+     * @param fileLoc The location of the loaded file
+     * @param resource The new copy, which must not be null
+     */
+    void ReplaceResource(const std::string& fileLoc,
+                         std::shared_ptr<ResourceT> resource);
+
+    /**
+     * Find the slot of a resource by the pointer
+     * @param resource The resource
+     * @return The slot, or null if the resource is not in the table
+     */
+    ResourceSlot* FindSlot(const std::shared_ptr<ResourceT>& resource);
+
+    /**
+     * Take the resource out of the table. Holders of the shared_ptr keep it
+     * alive, the deleter frees it once the last of them lets go.
+     * @param slotIndex The index of the slot
+     */
+    void FreeSlot(uint32_t slotIndex);
+
+    // Loaded resources and free slots, see ResourceHandle
+    std::vector<ResourceSlot> mSlots;
+    std::vector<uint32_t> mFreeSlots;
+    std::unordered_map<std::string, uint32_t> mSlotsByFile;
+    std::unordered_map<const ResourceT*, uint32_t> mSlotsByPtr;
+    size_t mLoadCount = 0;
 
     /**
-     * Find the resource in the map by the pointer
+     * A future for a load that is already done
      */
-    typename std::unordered_map<std::string,
-                                std::shared_ptr<ResourceT>>::iterator
-    FindByPtr(const std::shared_ptr<ResourceT>& resource);
+    static std::shared_future<void> MakeReadyFuture();
 };
 
 // Templated method definitions
@@ -79,6 +231,41 @@ void ResourceLoader<ResourceT>::Save(std::shared_ptr<ResourceT>& resource)
         "Save functionality has not been implemented for this resource type.");
 }
 
+/**
+ * Load the data right away, for loaders without asynchronous loading.
+ * @tparam ResourceT The type of the resource
+ * @param fileLoc The location of the loaded file
+ * @return A future that is already ready
+ */
+template <typename ResourceT>
+std::shared_future<void> ResourceLoader<ResourceT>::LoadAsync(
+    std::string fileLoc)
+{
+    std::promise<void> loaded;
+    try
+    {
+        Load(fileLoc);
+        loaded.set_value();
+    }
+    catch (...)
+    {
+        loaded.set_exception(std::current_exception());
+    }
+    return loaded.get_future().share();
+}
+
+/**
+ * A future for a load that is already done
+ * @tparam ResourceT The type of the resource
+ */
+template <typename ResourceT>
+std::shared_future<void> ResourceLoader<ResourceT>::MakeReadyFuture()
+{
+    std::promise<void> loaded;
+    loaded.set_value();
+    return loaded.get_future().share();
+}
+
 /**
  * Retrieve the saved copy of a local resource.
  * @tparam ResourceT The type of the resource
@@ -88,12 +275,28 @@ void ResourceLoader<ResourceT>::Save(std::shared_ptr<ResourceT>& resource)
 template <typename ResourceT>
 std::shared_ptr<ResourceT> ResourceLoader<ResourceT>::Get(std::string fileLoc)
 {
-    auto resourceIt = mResources.find(fileLoc);
-    if (resourceIt == mResources.end())
+    auto slotIt = mSlotsByFile.find(fileLoc);
+    if (slotIt == mSlotsByFile.end())
     {
         return nullptr;
     }
-    return resourceIt->second;
+    return mSlots[slotIt->second].resource;
+}
+
+/**
+ * Retrieve the resource a handle refers to.
+ * @tparam ResourceT The type of the resource
+ * @param handle The handle of the resource
+ * @return The resource, or null if it has been freed since
+ */
+template <typename ResourceT>
+std::shared_ptr<ResourceT> ResourceLoader<ResourceT>::Get(Handle handle) const
+{
+    if (handle.slot >= mSlots.size()) return nullptr;
+
+    const ResourceSlot& slot = mSlots[handle.slot];
+    if (slot.generation != handle.generation) return nullptr;
+    return slot.resource;
 }
 
 /**
@@ -112,69 +315,248 @@ ResourceLoader<ResourceT>::ResourceLoader()
 template <typename ResourceT>
 ResourceLoader<ResourceT>::~ResourceLoader()
 {
-    if (mResources.size() != 0)
+    if (mSlotsByFile.size() != 0)
     {
-        // std::cout << "There were " << m_resources.size() << " non-destroyed
+        // std::cout << "There were " << mSlotsByFile.size() << " non-destroyed
         // resources upon shutdown. Cleaning up...\n";
-        mResources.clear();
+        mSlotsByFile.clear();
+        mSlotsByPtr.clear();
+        mSlots.clear();
     }
 }
 
 /**
- * Free the loaded resource from memory.
+ * Take a reference to a loaded resource.
  * @tparam ResourceT The type of the resource
- * @param resource The resource we are destroying
+ * @param fileLoc The location of the file
+ * @return The handle of the resource, invalid if it is not loaded
  */
 template <typename ResourceT>
-void ResourceLoader<ResourceT>::Destroy(std::shared_ptr<ResourceT>& resource)
+ResourceHandle<ResourceT> ResourceLoader<ResourceT>::Acquire(
+    const std::string& fileLoc)
 {
-    if (resource.use_count() > 2)
+    auto slotIt = mSlotsByFile.find(fileLoc);
+    if (slotIt == mSlotsByFile.end()) return Handle();
+
+    ResourceSlot& slot = mSlots[slotIt->second];
+    slot.refCount++;
+    return Handle{slotIt->second, slot.generation};
+}
+
+/**
+ * Take a reference to a loaded resource.
+ * @tparam ResourceT The type of the resource
+ * @param resource The resource, as returned by Get
+ * @return The handle of the resource, invalid if it did not come from this
+ * loader
+ */
+template <typename ResourceT>
+ResourceHandle<ResourceT> ResourceLoader<ResourceT>::Acquire(
+    const std::shared_ptr<ResourceT>& resource)
+{
+    auto slotIt = mSlotsByPtr.find(resource.get());
+    if (!resource || slotIt == mSlotsByPtr.end()) return Handle();
+
+    ResourceSlot& slot = mSlots[slotIt->second];
+    slot.refCount++;
+    return Handle{slotIt->second, slot.generation};
+}
+
+/**
+ * Give up a reference taken with Acquire.
+ * @tparam ResourceT The type of the resource
+ * @param handle The handle of the resource
+ */
+template <typename ResourceT>
+void ResourceLoader<ResourceT>::Release(Handle& handle)
+{
+    if (Get(handle))
     {
-        resource.reset();
-        return;
+        ResourceSlot& slot = mSlots[handle.slot];
+        if (slot.refCount > 0) slot.refCount--;
+        if (slot.refCount == 0) FreeSlot(handle.slot);
     }
+    handle = Handle();
+}
 
+/**
+ * Free the loaded resource from memory.
+ * @tparam ResourceT The type of the resource
+ * @param resource The resource we are destroying
+ */
+template <typename ResourceT>
+void ResourceLoader<ResourceT>::Destroy(std::shared_ptr<ResourceT>& resource)
+{
     if (!resource)
     {
         // Pointer was already freed
         return;
     }
 
-    auto resourceIt = FindByPtr(resource);
-
-    if (resourceIt == mResources.end())
+    ResourceSlot* slot = FindSlot(resource);
+    resource.reset();
+    if (!slot)
     {
         // Resource has already been freed
         return;
     }
 
-    resource.reset();
-    // There are no more references to the resource; Free it
-
-    // There is no need to call this because the deleter passed to the
-    // shared_ptr will call it when the last reference is destroyed (it is
-    // removed from the map).
+    // There is no need to free the resource itself because the deleter
+    // passed to the shared_ptr will call it when the last reference is
+    // destroyed (it is removed from the table).
 
     // WARN: Will cause memory leak if you do not pass a deleter to the
     // shared_ptr
+    Handle handle{(uint32_t)(slot - mSlots.data()), slot->generation};
+    Release(handle);
+}
 
-    mResources.erase(resourceIt->first);
+/**
+ * Free a loaded resource unless references are taken to it.
+ * @tparam ResourceT The type of the resource
+ * @param fileLoc The location of the file
+ * @return true if the resource was freed
+ */
+template <typename ResourceT>
+bool ResourceLoader<ResourceT>::FreeUnreferenced(const std::string& fileLoc)
+{
+    auto slotIt = mSlotsByFile.find(fileLoc);
+    if (slotIt == mSlotsByFile.end() || mSlots[slotIt->second].refCount != 0)
+    {
+        return false;
+    }
+
+    FreeSlot(slotIt->second);
+    return true;
+}
+
+/**
+ * The number of references taken to a resource
+ * @tparam ResourceT The type of the resource
+ * @param handle The handle of the resource
+ */
+template <typename ResourceT>
+unsigned int ResourceLoader<ResourceT>::GetRefCount(Handle handle) const
+{
+    if (!Get(handle)) return 0;
+    return mSlots[handle.slot].refCount;
 }
 
 /**
- * Find the resource in the map by the pointer
+ * Add a loaded resource to the table.
  * @tparam ResourceT The type of the resource
+ * @param fileLoc The location of the loaded file
+ * @param resource The resource, which must not be null
+ * @return The handle of the resource
  */
 template <typename ResourceT>
-typename std::unordered_map<std::string, std::shared_ptr<ResourceT>>::iterator
-ResourceLoader<ResourceT>::FindByPtr(const std::shared_ptr<ResourceT>& resource)
+ResourceHandle<ResourceT> ResourceLoader<ResourceT>::AddResource(
+    const std::string& fileLoc, std::shared_ptr<ResourceT> resource)
 {
-    auto resourceIt = mResources.begin();
-    for (; resourceIt != mResources.end(); ++resourceIt)
+    if (!resource)
+    {
+        throw std::invalid_argument("Trying to add an invalid resource");
+    }
+    if (IsLoaded(fileLoc))
+    {
+        throw std::logic_error("Resource '" + fileLoc +
+                               "' is already loaded");
+    }
+
+    uint32_t slotIndex;
+    if (!mFreeSlots.empty())
+    {
+        slotIndex = mFreeSlots.back();
+        mFreeSlots.pop_back();
+    }
+    else
+    {
+        slotIndex = mSlots.size();
+        mSlots.emplace_back();
+    }
+
+    ResourceSlot& slot = mSlots[slotIndex];
+    slot.fileLoc = fileLoc;
+    slot.resource = std::move(resource);
+    slot.refCount = 0;
+    mSlotsByFile.emplace(fileLoc, slotIndex);
+    mSlotsByPtr.emplace(slot.resource.get(), slotIndex);
+    mLoadCount++;
+
+    return Handle{slotIndex, slot.generation};
+}
+
+/**
+ * Swap a new copy of a resource into the table.
+ * @tparam ResourceT The type of the resource
+ * @param fileLoc The location of the loaded file
+ * @param resource The new copy, which must not be null
+ */
+template <typename ResourceT>
+void ResourceLoader<ResourceT>::ReplaceResource(
+    const std::string& fileLoc, std::shared_ptr<ResourceT> resource)
+{
+    auto slotIt = mSlotsByFile.find(fileLoc);
+    if (slotIt == mSlotsByFile.end())
+    {
+        AddResource(fileLoc, std::move(resource));
+        return;
+    }
+    if (!resource)
     {
-        if (resourceIt->second == resource) break;
+        throw std::invalid_argument("Trying to add an invalid resource");
     }
-    return resourceIt;
+
+    ResourceSlot& slot = mSlots[slotIt->second];
+    mSlotsByPtr.erase(slot.resource.get());
+    slot.resource = std::move(resource);
+    mSlotsByPtr.emplace(slot.resource.get(), slotIt->second);
+}
+
+/**
+ * Add the location of every loaded file to a list.
+ * @tparam ResourceT The type of the resource
+ * @param out The list to add to
+ */
+template <typename ResourceT>
+void ResourceLoader<ResourceT>::GetLoadedFiles(
+    std::vector<std::string>& out) const
+{
+    for (const auto& file : mSlotsByFile) out.push_back(file.first);
+}
+
+/**
+ * Find the slot of a resource by the pointer
+ * @tparam ResourceT The type of the resource
+ * @param resource The resource
+ * @return The slot, or null if the resource is not in the table
+ */
+template <typename ResourceT>
+typename ResourceLoader<ResourceT>::ResourceSlot*
+ResourceLoader<ResourceT>::FindSlot(const std::shared_ptr<ResourceT>& resource)
+{
+    auto slotIt = mSlotsByPtr.find(resource.get());
+    if (!resource || slotIt == mSlotsByPtr.end()) return nullptr;
+    return &mSlots[slotIt->second];
+}
+
+/**
+ * Take the resource out of the table.
+ * @tparam ResourceT The type of the resource
+ * @param slotIndex The index of the slot
+ */
+template <typename ResourceT>
+void ResourceLoader<ResourceT>::FreeSlot(uint32_t slotIndex)
+{
+    ResourceSlot& slot = mSlots[slotIndex];
+    mSlotsByFile.erase(slot.fileLoc);
+    mSlotsByPtr.erase(slot.resource.get());
+
+    slot.fileLoc.clear();
+    slot.resource.reset();
+    slot.refCount = 0;
+    slot.generation++;
+    mFreeSlots.push_back(slotIndex);
 }
 
 #endif
@@ -0,0 +1,171 @@
+#ifndef __SCENEDATA_HPP__
+#define __SCENEDATA_HPP__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * A string of a scene, stored in the scene's string table.
+ */
+struct SceneString
+{
+    uint32_t offset;
+    uint32_t length;
+};
+
+/**
+ * The kinds of resource a scene refers to.
+ */
+enum class SceneResourceType : uint32_t
+{
+    Spritesheet = 1,
+    Tilemap = 2
+};
+
+/**
+ * A file the scene loads, referred to by its components by index.
+ */
+struct SceneResource
+{
+    SceneResourceType type;
+    // The name components use for it in a text scene
+    SceneString name;
+    SceneString fileLoc;
+    // The sprite size of a spritesheet, or 0 x 0 to keep it
+    uint32_t spriteWidth;
+    uint32_t spriteHeight;
+};
+
+/**
+ * A game object of a scene. Its components are a range of the scene's.
+ */
+struct SceneObject
+{
+    static constexpr int32_t NO_PARENT = -1;
+
+    SceneString name;
+    float x;
+    float y;
+    // The index of the parent object, or NO_PARENT
+    int32_t parent;
+    uint32_t firstComponent;
+    uint32_t componentCount;
+};
+
+/**
+ * The kinds of component a scene can create.
+ */
+enum class SceneComponentType : uint32_t
+{
+    Tilemap = 1,
+    TilemapCollider = 2,
+    Controller = 3,
+    Sprite = 4,
+    Animator = 5,
+    SpriteCollider = 6,
+    Rect = 7
+};
+
+/**
+ * A component of a scene. Only the fields its type uses are set.
+ */
+struct SceneComponent
+{
+    static constexpr uint32_t NO_RESOURCE = 0xFFFFFFFF;
+    // The collider only reports collisions, nothing is blocked by it
+    static constexpr uint32_t FLAG_TRIGGER = 1 << 0;
+
+    SceneComponentType type;
+    int32_t layer;
+    // Indices into the resources of the scene, or NO_RESOURCE
+    uint32_t spritesheet;
+    uint32_t tilemap;
+    // The size of a sprite or rect, or of a tile on the screen
+    float width;
+    float height;
+    uint32_t spriteIndex;
+    // The speed of a controller, or 0 to keep the default
+    float speed;
+    uint8_t color[4];
+    uint32_t flags;
+    // The animations of an animator, a range of the scene's
+    uint32_t firstAnimation;
+    uint32_t animationCount;
+};
+
+/**
+ * An animation of an animator component (see SpriteAnimator::SetAnimation).
+ */
+struct SceneAnimation
+{
+    SceneString name;
+    uint32_t spritesheetRow;
+    uint32_t frameCount;
+    float frameDuration;
+};
+
+/**
+ * A description of a scene: the resources it uses, and its game objects and
+ * their components (see Engine::LoadScene).
+ *
+ * Everything is kept in flat tables of plain records, which refer to each
+ * other by index, so a binary scene file is the tables as they are.
+ */
+class SceneData
+{
+public:
+    const std::vector<SceneResource>& GetResources() const
+    {
+        return mResources;
+    }
+    const std::vector<SceneObject>& GetObjects() const { return mObjects; }
+    const std::vector<SceneComponent>& GetComponents() const
+    {
+        return mComponents;
+    }
+    const std::vector<SceneAnimation>& GetAnimations() const
+    {
+        return mAnimations;
+    }
+    // The render layers that are sorted by y (see Engine::SetLayerYSorted)
+    const std::vector<int32_t>& GetYSortedLayers() const
+    {
+        return mYSortedLayers;
+    }
+
+    /**
+     * Get a string of the scene
+     * @param string The string, as stored in a record
+     */
+    std::string GetString(SceneString string) const
+    {
+        return mStrings.substr(string.offset, string.length);
+    }
+
+private:
+    // This class should only be instantiated by the SceneLoader.
+    SceneData();
+
+    /**
+     * Add a string to the string table.
+     */
+    SceneString AddString(const std::string& string);
+
+    /**
+     * Check that every index and string of the records is in range.
+     * @throws std::invalid_argument if one is not
+     */
+    void Validate() const;
+
+    std::vector<SceneResource> mResources;
+    std::vector<SceneObject> mObjects;
+    std::vector<SceneComponent> mComponents;
+    std::vector<SceneAnimation> mAnimations;
+    std::vector<int32_t> mYSortedLayers;
+    std::string mStrings;
+
+    friend class SceneLoader;
+};
+
+#endif  // __SCENEDATA_HPP__
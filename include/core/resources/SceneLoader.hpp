@@ -0,0 +1,139 @@
+#ifndef __SCENELOADER_HPP__
+#define __SCENELOADER_HPP__
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+#include "core/resources/ResourceLoader.hpp"
+#include "core/resources/SceneData.hpp"
+
+class AssetBundle;
+
+/**
+ * The formats a scene file can be in.
+ *
+ * Text: a line per resource, object or component, for authoring. Empty lines
+ * and lines starting with '#' are skipped. Components belong to the object
+ * above them, and animations to the animator above them.
+ *   spritesheet <name> <path> [<sprite width> <sprite height>]
+ *   map <name> <path>
+ *   ysort <layer>
+ *   object [<name>]
+ *   position <x> <y>
+ *   parent <object name>
+ *   tilemap <map> <spritesheet> <tile width> <tile height> [<layer>]
+ *   tilemap_collider
+ *   controller [<speed>]
+ *   sprite <spritesheet> <width> <height> [<layer> [<sprite index>]]
+ *   animator <spritesheet> <width> <height> [<layer>]
+ *   animation <name> <row> <frame count> [<seconds per frame>]
+ *   sprite_collider [trigger]
+ *   rect <width> <height> <r> <g> <b> [<a> [<layer>]]
+ *
+ * Binary: a SceneFileHeader, then the tables of SceneData one after another
+ * (resources, objects, components, animations, y sorted layers and the
+ * string table), in native byte order like binary tilemaps. Loading copies
+ * the tables as they are, for shipping.
+ */
+enum class SceneFormat
+{
+    Text,
+    Binary
+};
+
+/**
+ * The start of a binary scene file.
+ */
+struct SceneFileHeader
+{
+    static constexpr char MAGIC[4] = {'S', 'C', 'N', 'E'};
+    // Increase when the layout changes; older versions are not loaded
+    static constexpr uint16_t VERSION = 1;
+
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t resourceCount;
+    uint32_t objectCount;
+    uint32_t componentCount;
+    uint32_t animationCount;
+    uint32_t ySortedLayerCount;
+    // The size of the string table, in bytes
+    uint32_t stringsSize;
+};
+
+/**
+ * Load a scene from a file on the disk, in either SceneFormat, or from the
+ * mounted asset bundle. The scene is only a description, see
+ * Engine::LoadScene to create it.
+ */
+class SceneLoader : public ResourceLoader<SceneData>
+{
+public:
+    /**
+     * A destructor for Scene Loader
+     */
+    ~SceneLoader();
+
+    /**
+     * Load and parse the data from the file at fileLoc.
+     * @param fileLoc The location of the loaded file
+     */
+    virtual void Load(std::string fileLoc) override;
+
+    /**
+     * Write a scene to a file. The file is replaced once it is fully
+     * written.
+     * @param sceneData The scene to write
+     * @param fileLoc The location of the file
+     * @param format The format to write in
+     */
+    static void Write(const SceneData& sceneData, const std::string& fileLoc,
+                      SceneFormat format);
+
+    static void WriteText(const SceneData& sceneData, std::ostream& out);
+    static void WriteBinary(const SceneData& sceneData, std::ostream& out);
+
+    /**
+     * Read a scene file on the disk, in either format, without adding it as
+     * a resource. Safe on any thread.
+     * @param fileLoc The location of the file
+     * @param out_format Set to the format of the file
+     * @return The scene
+     * @throws std::invalid_argument if the file could not be read
+     */
+    static std::shared_ptr<SceneData> Read(const std::string& fileLoc,
+                                           SceneFormat* out_format);
+
+private:
+    // This class should only be instantiated by the ResourceManager.
+    /**
+     * Constructs a Scene Loader
+     */
+    SceneLoader();
+
+    /**
+     * Look files up in a bundle before the disk.
+     * @param bundle The bundle, or null for none
+     */
+    void SetBundle(const AssetBundle* bundle) { mBundle = bundle; }
+
+    static void LoadText(std::istream& in, SceneData& sceneData);
+
+    /**
+     * Copy the tables of a binary scene.
+     * @param data The scene file
+     * @param dataSize The size of the file, in bytes
+     * @param sceneData The scene to load into
+     */
+    static void LoadBinary(const char* data, size_t dataSize,
+                           SceneData& sceneData);
+
+    const AssetBundle* mBundle = nullptr;
+
+    friend class ResourceManager;
+};
+
+#endif  // __SCENELOADER_HPP__
@@ -0,0 +1,129 @@
+#ifndef __SCENERESOURCES_HPP__
+#define __SCENERESOURCES_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/resources/ResourceLoader.hpp"
+#include "core/resources/SceneData.hpp"
+
+struct SDL_Texture;
+class Spritesheet;
+class TilemapData;
+
+/**
+ * The resources of a scene: loads them in the background, then references
+ * them (see ResourceLoader::Acquire) for as long as the scene plays, so
+ * destroying it frees everything only that scene used at once. See
+ * Engine::LoadScene and Engine::PrefetchScene.
+ *
+ * Spritesheets are decoded and tilemaps read on the load workers. With a
+ * memory cap, loads are started one at a time, each only while the
+ * resources loaded so far are under the cap, so prefetching a scene stays
+ * out of the way of the one that plays. Resources that were already loaded
+ * are shared, and do not count towards the cap.
+ */
+class SceneResources
+{
+public:
+    /**
+     * Read a scene file and queue the loads of its resources. Scene files
+     * are small, so they are read right away.
+     * @param sceneLoc The location of the scene file
+     * @param memoryCap The most memory the loaded resources may take, in
+     * bytes, 0 for no cap
+     * @throws std::invalid_argument if the scene file could not be read
+     */
+    SceneResources(const std::string& sceneLoc, size_t memoryCap = 0);
+
+    /**
+     * Give up the references to the resources, freeing the ones no other
+     * scene holds. Must be called where the renderer may be used.
+     */
+    ~SceneResources();
+
+    SceneResources(const SceneResources&) = delete;
+    SceneResources& operator=(const SceneResources&) = delete;
+
+    /**
+     * Take the loads that finished, and start the next ones the cap allows.
+     * Textures loaded so far are marked as used, so they are not evicted
+     * before the scene is drawn. Called between frames.
+     * @param frameIdx The frame about to be drawn
+     * @param bIgnoreCap Whether to start every load that is left
+     */
+    void Update(int frameIdx, bool bIgnoreCap = false);
+
+    /**
+     * Whether every resource is loaded, or a load failed
+     */
+    bool IsDone() const
+    {
+        return !mError.empty() || mFinishedCount == mResources.size();
+    }
+
+    /**
+     * Why a load failed, empty unless one did
+     */
+    const std::string& GetError() const { return mError; }
+
+    /**
+     * The memory taken by the resources this scene loaded so far, in bytes
+     */
+    size_t GetMemoryUsage() const { return mMemoryUsage; }
+
+    const std::string& GetSceneLoc() const { return mSceneLoc; }
+    const SceneData& GetScene() const { return *mScene; }
+
+    /**
+     * Get a loaded spritesheet of the scene
+     * @param resourceIndex The index of the resource in the scene
+     * @return The spritesheet, or null if it is not loaded
+     */
+    std::shared_ptr<Spritesheet> GetSpritesheet(uint32_t resourceIndex) const;
+
+private:
+    /**
+     * A resource of the scene, and its load.
+     */
+    struct LoadedResource
+    {
+        SceneResourceType type;
+        std::string fileLoc;
+        std::shared_future<void> load;
+        bool bFinished = false;
+        // Whether it was loaded before this scene, and so is not counted
+        bool bShared = false;
+        ResourceHandle<Spritesheet> spritesheet;
+        ResourceHandle<TilemapData> tilemap;
+        // Not referenced, only marked as used until the scene is drawn
+        ResourceHandle<SDL_Texture> texture;
+    };
+
+    /**
+     * Start loading a resource.
+     */
+    void Start(LoadedResource& resource);
+
+    /**
+     * Take a finished load: reference the resource and count its memory.
+     */
+    void Finish(LoadedResource& resource);
+
+    std::string mSceneLoc;
+    std::shared_ptr<SceneData> mScene;
+    ResourceHandle<SceneData> mSceneHandle;
+    std::vector<LoadedResource> mResources;
+    // The index of the next load to start
+    size_t mNextLoad = 0;
+    size_t mFinishedCount = 0;
+    size_t mMemoryCap = 0;
+    size_t mMemoryUsage = 0;
+    std::string mError;
+};
+
+#endif  // __SCENERESOURCES_HPP__
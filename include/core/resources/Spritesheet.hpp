@@ -11,6 +11,7 @@
 #include <string>
 
 #include "core/RenderContext.hpp"
+#include "core/resources/TextureLoader.hpp"
 
 typedef glm::uvec2 Size2D;
 
@@ -22,11 +23,25 @@ typedef glm::uvec2 Size2D;
  *
  * It is currently assumed that the sprites all have the same
  * width height, and have no gaps with each other.
+ *
+ * The sheet may only be one region of its texture, after it has been packed
+ * into a shared atlas (see SpritesheetLoader::PackAtlas). Source rects always
+ * point into the texture it currently lives in.
+ *
+ * A sheet using the texture of its own file finds it in the TextureLoader
+ * by handle rather than holding it, so the texture can be evicted to stay
+ * within the memory budget. It is loaded again when the sheet is next drawn.
  */
 class Spritesheet
 {
 public:
     Spritesheet(std::shared_ptr<SDL_Texture> texture);
+    /**
+     * Make a spritesheet of the texture of a file
+     * @param textureLoader The loader of the texture
+     * @param fileLoc The location of the file, whose texture is loaded
+     */
+    Spritesheet(TextureLoader* textureLoader, const std::string& fileLoc);
     Spritesheet(Spritesheet&& other) noexcept;
     ~Spritesheet();
 
@@ -46,26 +61,111 @@ public:
      * @param tileIndex The index of the tile
      * @param dest The destination of the tile
      * @param hasCollider Does the tile have a collider?
+     * @param layer The layer to draw the tile on
+     * @param depth The draw order among tiles on the same layer and texture
      */
     void DrawTileAt(RenderContext* renderContext, unsigned int tileIndex,
-                    SDL_Rect& dest, bool hasCollider = false);
+                    SDL_Rect& dest, bool hasCollider = false, int layer = 0,
+                    unsigned int depth = 0);
+
+    /**
+     * Draws a region of the spritesheet's texture to the destination
+     * @param renderCtx The render data
+     * @param src The source rect on the texture (see GetSourceRect)
+     * @param dest The destination of the sprite
+     * @param layer The layer to draw the sprite on
+     * @param depth The draw order among sprites on the same layer and texture
+     */
+    void DrawRegionAt(RenderContext* renderCtx, const SDL_Rect& src,
+                      SDL_Rect& dest, int layer = 0, unsigned int depth = 0);
 
     /**
      * Draws a sprite to the destination
      * @param renderCtx The render data
      * @param spriteIndex The index of the sprite
      * @param dest The destination of the sprite
+     * @param layer The layer to draw the sprite on
+     * @param depth The draw order among sprites on the same layer and texture
      */
     void DrawSpriteAt(RenderContext* renderCtx, unsigned int spriteIndex,
-                      SDL_Rect& dest);
+                      SDL_Rect& dest, int layer = 0, unsigned int depth = 0);
 
     inline Size2D GetSize() { return mSize; }
+    inline Size2D GetSpriteSize() { return mSpriteSize; }
+    // The size of the whole texture, which may be shared with other sheets
+    inline Size2D GetTextureSize() { return mTextureSize; }
+    // The size of this sheet's region of the texture
+    inline Size2D GetRegionSize() { return mRegionSize; }
+
+    /**
+     * A count of the changes to where the sprites are on the texture, e.g.
+     * packing, reloading the file or changing the sprite size. Evicting and
+     * loading the texture again does not move them.
+     * @return The layout version, to compare with a cached one
+     */
+    inline unsigned int GetLayoutVersion() const { return mLayoutVersion; }
+
+    /**
+     * Get the texture without loading it. Safe on any thread that may read
+     * the sheet, since it never changes the loader.
+     * @return The texture, or null if it has been evicted (see UseTexture)
+     */
+    SDL_Texture* GetTexture();
+
+    /**
+     * Get the texture to draw in the current frame, loading it again on the
+     * renderer if it was evicted. Must be called on the main thread.
+     * @param renderContext The render data
+     */
+    SDL_Texture* UseTexture(RenderContext* renderContext);
+
+    /**
+     * Whether the sheet uses the texture of its own file, rather than a
+     * region of an atlas
+     */
+    inline bool UsesFileTexture() const { return mTextureLoader != nullptr; }
+
+    /**
+     * Move the sheet into a region of another texture. The sprite size and
+     * indices are kept.
+     * @param texture The texture that now holds the sheet
+     * @param textureSize The size of the whole texture
+     * @param origin The top left corner of the sheet on the texture
+     */
+    void MoveToTexture(std::shared_ptr<SDL_Texture> texture,
+                       Size2D textureSize, Size2D origin);
+
+    /**
+     * Use the whole texture of a file, e.g. after the file changed. The
+     * sprite size is kept, and the sprites are counted again. Must be called
+     * where the renderer may be used.
+     * @param textureLoader The loader of the texture
+     * @param fileLoc The location of the file
+     */
+    void UseFileTexture(TextureLoader* textureLoader,
+                        const std::string& fileLoc);
+
+    /**
+     * Get the rect of a sprite on the texture
+     * @param spriteIndex The index of the sprite
+     * @return The source rect of the sprite
+     */
+    SDL_Rect GetSourceRect(unsigned int spriteIndex);
 
 private:
+    // The texture, unless it is found in the loader
     std::shared_ptr<SDL_Texture> mTexture;
+    // The loader of the file's texture, while the sheet uses it
+    TextureLoader* mTextureLoader = nullptr;
+    std::string mFileLoc;
+    TextureLoader::Handle mTextureHandle;
     Size2D mTextureSize{0, 0};
+    // Where the sheet is on the texture
+    Size2D mOrigin{0, 0};
+    Size2D mRegionSize{0, 0};
     Size2D mSize{0, 0};
     Size2D mSpriteSize{0, 0};
+    unsigned int mLayoutVersion = 0;
 };
 
 #endif
@@ -1,8 +1,13 @@
 #ifndef __SPRITESHEETLOADER_HPP__
 #define __SPRITESHEETLOADER_HPP__
 
+#include <future>
+#include <string>
+#include <unordered_map>
+
 #include "core/resources/ResourceLoader.hpp"
 #include "core/resources/Spritesheet.hpp"
+#include "core/resources/TextureLoader.hpp"
 
 #if defined(LINUX) || defined(MINGW)
 #include <SDL2/SDL.h>
@@ -13,7 +18,8 @@
 /**
  * Load spritesheets from image files on the disk.
  *
- * Supports any image type that SDL_LoadBMP supports.
+ * Supports any image type that TextureLoader supports. Spritesheets in the
+ * mounted asset bundle get the sprite size they were baked with.
  */
 class SpritesheetLoader : public ResourceLoader<Spritesheet>
 {
@@ -29,20 +35,66 @@ public:
      */
     virtual void Load(std::string fileLoc) override;
 
+    /**
+     * Start loading the texture of a spritesheet on a worker thread (see
+     * TextureLoader::LoadAsync). The spritesheet is created along with the
+     * texture.
+     * @param fileLoc The location of the loaded file
+     * @return A future that is ready once Get returns the spritesheet
+     */
+    virtual std::shared_future<void> LoadAsync(std::string fileLoc) override;
+
+    /**
+     * Copy every loaded spritesheet that has not been packed yet into a few
+     * large atlas textures, so sprites from different sheets can be drawn in
+     * the same batch. The sheets are moved to their region of the atlas and
+     * their own textures are freed.
+     *
+     * Meant to be called at load time, once the sheets of a level are loaded.
+     * The images of the sheets are read again to build the pages, so the
+     * atlas is a static texture that survives render target resets. Sheets
+     * that do not fit on a page keep their own texture.
+     * @param renderer The renderer to create the atlas textures with
+     * @param pageSize The maximum width and height of an atlas texture
+     */
+    void PackAtlas(SDL_Renderer* renderer, unsigned int pageSize);
+
 private:
     // This class should only be instantiated by the ResourceManager.
     /**
      * Constructs a spritesheet loader with the given texture
      * @param textureLoader The texture we are loading for the spritesheet
      */
-    SpritesheetLoader(ResourceLoader<SDL_Texture>* textureLoader);
+    SpritesheetLoader(TextureLoader* textureLoader);
 
     /**
      * A constructor that we do not want to be implemented
      */
     SpritesheetLoader() = delete;
 
-    ResourceLoader<SDL_Texture>* mTextureLoader = NULL;
+    /**
+     * Look files up in a bundle before the disk.
+     * @param bundle The bundle, or null for none
+     */
+    void SetBundle(const AssetBundle* bundle) { mBundle = bundle; }
+
+    /**
+     * Move a spritesheet to the current texture of its file, after the
+     * texture was reloaded. A sheet packed into an atlas leaves it.
+     * @param fileLoc The location of the file
+     */
+    void RefreshTexture(const std::string& fileLoc);
+
+    /**
+     * Create the spritesheet for a loaded texture.
+     * @param fileLoc The location of the loaded file
+     */
+    void AddSpritesheet(const std::string& fileLoc);
+
+    TextureLoader* mTextureLoader = NULL;
+    const AssetBundle* mBundle = nullptr;
+    // Asynchronous loads that have not finished, by file
+    std::unordered_map<std::string, std::shared_future<void>> mPending;
 
     friend class ResourceManager;
 };
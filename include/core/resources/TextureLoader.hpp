@@ -1,7 +1,21 @@
 #ifndef __TEXTURELOADER_HPP__
 #define __TEXTURELOADER_HPP__
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "core/resources/ResourceLoader.hpp"
+#include "core/util/ThreadPool.hpp"
+
+class AssetBundle;
 
 #if defined(LINUX) || defined(MINGW)
 #include <SDL2/SDL.h>
@@ -12,11 +26,29 @@
 /**
  * Load textures from image files on the disk.
  *
- * Supports any image type that SDL_LoadBMP supports.
+ * Supports any image type that SDL_image supports (PNG, JPG, BMP, ...).
+ * Textures in the mounted asset bundle are made from its baked pixels
+ * instead, with no decoding.
+ *
+ * Asynchronous loads read and decode the file on a worker thread, then queue
+ * it for upload. ProcessUploads creates the queued textures, a few per frame,
+ * wherever the renderer may be used (see RenderContext::RunOnRenderer).
+ *
+ * The memory of every texture is counted. With a memory budget set, the
+ * textures drawn least recently are evicted between frames while the loader
+ * is over budget (see EvictTextures). Only textures nobody else holds are
+ * evicted; spritesheets find theirs by handle (see Use), and load them again
+ * the next time they are drawn.
  */
 class TextureLoader : public ResourceLoader<SDL_Texture>
 {
 public:
+    /**
+     * Called once an asynchronous load is done, with the exception if it
+     * failed (or null if it worked).
+     */
+    typedef std::function<void(std::exception_ptr)> LoadCallback;
+
     /**
      * A destructor for Texture Loader
      */
@@ -28,19 +60,270 @@ public:
      */
     virtual void Load(std::string fileLoc) override;
 
+    /**
+     * Start loading a texture on a worker thread. It is created in a later
+     * ProcessUploads.
+     * @param fileLoc The location of the loaded file
+     * @return A future that is ready once Get returns the texture
+     */
+    virtual std::shared_future<void> LoadAsync(std::string fileLoc) override;
+
+    /**
+     * Start loading a texture on a worker thread, and run a callback once it
+     * is done. The callback runs wherever ProcessUploads does, or right away
+     * if the texture is already loaded.
+     * @param fileLoc The location of the loaded file
+     * @param onLoaded The callback
+     * @return A future that is ready once Get returns the texture
+     */
+    std::shared_future<void> LoadAsync(std::string fileLoc,
+                                       LoadCallback onLoaded);
+
+    /**
+     * Create textures for the files that finished decoding, until the time
+     * budget runs out. At least one is created per call, so loading always
+     * makes progress. Must be called where the renderer may be used.
+     * @param budgetMs The time budget in milliseconds, negative for none
+     * @return The number of textures created
+     */
+    unsigned int ProcessUploads(double budgetMs);
+
+    /**
+     * Block until a decoded file is ready for ProcessUploads, or no
+     * asynchronous loads are left.
+     */
+    void WaitForDecodes();
+
+    /**
+     * Whether there are asynchronous loads that have not finished
+     */
+    bool HasPendingLoads() const { return !mPending.empty(); }
+
+    /**
+     * Get a loaded texture to draw, and mark it as drawn for eviction. Does
+     * not take a reference.
+     * @param handle The handle of the texture
+     * @param frameIdx The frame it is drawn in
+     * @return The texture, or null if it has been evicted or freed since
+     */
+    inline SDL_Texture* Use(Handle handle, int frameIdx)
+    {
+        if (handle.slot >= mSlots.size()) return nullptr;
+
+        ResourceSlot& slot = mSlots[handle.slot];
+        if (slot.generation != handle.generation) return nullptr;
+        mUsage[handle.slot].lastDrawFrame = frameIdx;
+        mLatestFrame = frameIdx;
+        return slot.resource.get();
+    }
+
+    /**
+     * Load a texture unless it is loaded (e.g. after it was evicted), and
+     * get its handle without taking a reference. Must be called where the
+     * renderer may be used.
+     * @param fileLoc The location of the file
+     * @return The handle, invalid if the texture could not be loaded
+     */
+    Handle LoadHandle(const std::string& fileLoc);
+
+    /**
+     * Set how much memory the textures may use before the ones drawn least
+     * recently are evicted.
+     * @param bytes The budget in bytes, 0 for no budget
+     */
+    void SetMemoryBudget(size_t bytes) { mMemoryBudget = bytes; }
+    size_t GetMemoryBudget() const { return mMemoryBudget; }
+
+    /**
+     * The memory used by the textures that are alive, in bytes. Includes
+     * textures that were freed by the loader but are still held elsewhere,
+     * and the ones made outside the loader (see AdoptTexture).
+     */
+    size_t GetMemoryUsage() const { return *mMemoryUsage; }
+
+    /**
+     * Count a texture made outside the loader, e.g. an atlas page or a
+     * render target, in the memory usage until it is destroyed.
+     * @param texture The texture, which the returned pointer now owns
+     * @param name What the texture is, for the log
+     * @return The texture, destroyed with the last reference, which must be
+     * let go of where the renderer may be used
+     */
+    std::shared_ptr<SDL_Texture> AdoptTexture(SDL_Texture* texture,
+                                              const std::string& name);
+
+    /**
+     * Keep a texture alive until the renderer is next free, for textures let
+     * go of where it may not be used (e.g. while a frame that draws them is
+     * in flight, or in a destructor).
+     * @param texture The texture
+     */
+    void RetireTexture(std::shared_ptr<SDL_Texture> texture)
+    {
+        if (texture) mRetiredTextures.push_back(std::move(texture));
+    }
+    bool HasRetiredTextures() const { return !mRetiredTextures.empty(); }
+
+    /**
+     * Let go of the retired textures, destroying the ones nobody else holds.
+     * Must be called between frames, where the renderer may be used.
+     */
+    void DestroyRetiredTextures() { mRetiredTextures.clear(); }
+
+    /**
+     * The memory used by one loaded texture, in bytes
+     * @param handle The handle of the texture
+     */
+    size_t GetMemoryUsage(Handle handle) const;
+
+    /**
+     * The number of textures evicted so far
+     */
+    unsigned int GetEvictionCount() const { return mEvictionCount; }
+
+    /**
+     * Whether EvictTextures should be called before the frame. After an
+     * eviction that could not get under budget, waits a while before trying
+     * again.
+     * @param frameIdx The frame about to be drawn
+     */
+    bool ShouldEvict(int frameIdx) const
+    {
+        return mMemoryBudget != 0 && GetMemoryUsage() > mMemoryBudget &&
+               frameIdx >= mNextEvictionFrame;
+    }
+
+    /**
+     * Free the textures drawn least recently until the loader is within its
+     * budget. Textures that were drawn in the last frame, that have
+     * references (see Acquire), or that are held elsewhere are kept. Must be
+     * called between frames, where the renderer may be used.
+     * @param frameIdx The frame about to be drawn
+     * @return The number of textures evicted
+     */
+    unsigned int EvictTextures(int frameIdx);
+
+    /**
+     * Read and decode an image file on the disk. Safe on any thread, once
+     * ResourceManager::Startup has initialized the decoders.
+     * @param fileLoc The location of the file
+     * @return The image, or null if it could not be loaded (see SDL_GetError)
+     */
+    static SDL_Surface* DecodeFile(const std::string& fileLoc);
+
+    /**
+     * Read the image of a file, from the bundle if it is in there. Safe on
+     * any thread, like DecodeFile.
+     * @param fileLoc The location of the file
+     * @return The image, or null if it could not be loaded; the caller frees
+     * it
+     */
+    SDL_Surface* ReadSurface(const std::string& fileLoc) const;
+
 private:
     // This class should only be instantiated by the ResourceManager.
     /**
      * Constructs a texture loader with the given renderer
      * @param renderer The renderer that is used to load the texture
+     * @param workers The threads to read and decode files on
      */
-    TextureLoader(SDL_Renderer* renderer);
+    TextureLoader(SDL_Renderer* renderer, util::ThreadPool* workers);
     /**
      * A constructor that we do not want to be implemented
      */
     TextureLoader() = delete;
 
+    /**
+     * An asynchronous load that has not finished.
+     */
+    struct PendingLoad
+    {
+        std::promise<void> promise;
+        std::shared_future<void> future;
+        std::vector<LoadCallback> callbacks;
+    };
+
+    /**
+     * A file decoded on a worker thread, waiting for its texture.
+     */
+    struct DecodedImage
+    {
+        std::string fileLoc;
+        // Null if the file could not be loaded
+        SDL_Surface* surface;
+        std::string error;
+    };
+
+    /**
+     * Look files up in a bundle before the disk.
+     * @param bundle The bundle, or null for none
+     */
+    void SetBundle(const AssetBundle* bundle) { mBundle = bundle; }
+
+    /**
+     * Read and decode a file, then queue it for upload. Runs on a worker.
+     */
+    void Decode(const std::string& fileLoc);
+
+    /**
+     * Create the texture for a decoded image and add it as a resource.
+     * @return false if the texture could not be created, in which case
+     * nothing is added
+     */
+    bool AddTexture(const std::string& fileLoc, SDL_Surface* surface);
+
+    /**
+     * Create a new texture for a file that changed, and swap it in for the
+     * loaded one (see ResourceManager::EnableHotReload).
+     * @return false if the texture could not be created, in which case the
+     * loaded one is kept
+     */
+    bool ReplaceTexture(const std::string& fileLoc, SDL_Surface* surface);
+
+    /**
+     * Create a texture that frees itself.
+     * @return The texture, or null if it could not be created
+     */
+    std::shared_ptr<SDL_Texture> CreateTexture(const std::string& fileLoc,
+                                               SDL_Surface* surface);
+
+    /**
+     * The memory of a loaded texture, and when it was last drawn
+     */
+    struct TextureUsage
+    {
+        size_t bytes = 0;
+        int lastDrawFrame = 0;
+    };
+
+    /**
+     * Track the usage of a texture that was just added or replaced.
+     */
+    void UpdateUsage(const std::string& fileLoc);
+
     SDL_Renderer* mRenderer = NULL;
+    util::ThreadPool* mWorkers = NULL;
+    const AssetBundle* mBundle = nullptr;
+
+    // The usage of each slot's texture, by slot
+    std::vector<TextureUsage> mUsage;
+    // Shared with the deleters of the textures, which may outlive the loader
+    std::shared_ptr<std::atomic<size_t>> mMemoryUsage =
+        std::make_shared<std::atomic<size_t>>(0);
+    size_t mMemoryBudget = 0;
+    int mLatestFrame = 0;
+    int mNextEvictionFrame = 0;
+    unsigned int mEvictionCount = 0;
+
+    // Loads that have started but not finished, by file
+    std::unordered_map<std::string, PendingLoad> mPending;
+    // Textures waiting to be destroyed on the renderer, see RetireTexture
+    std::vector<std::shared_ptr<SDL_Texture>> mRetiredTextures;
+
+    // Shared with the workers:
+    std::mutex mDecodedMutex;
+    std::condition_variable mDecodedReady;
+    std::deque<DecodedImage> mDecoded;
 
     friend class ResourceManager;
 };
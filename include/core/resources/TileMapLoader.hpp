@@ -1,13 +1,65 @@
 #ifndef __TILEMAPLOADER_HPP__
 #define __TILEMAPLOADER_HPP__
 
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
 #include "core/resources/ResourceLoader.hpp"
 #include "core/resources/TilemapData.hpp"
+#include "core/util/ThreadPool.hpp"
+
+class AssetBundle;
 
 /**
- * Load a tilemap from a file on the disk.
+ * The formats a tilemap file can be in.
  *
- * TODO: Document the file structure and extention of our tilemap file type.
+ * Text: a line per row of tiles, each tile written as its type followed by
+ * 'c' if it has a collider or '.' if not (e.g. "0c -1. 3."), separated by
+ * spaces. Slow to parse, but easy to edit by hand.
+ *
+ * Binary: a TilemapFileHeader, then a table with the index of every chunk's
+ * tiles (or EMPTY_CHUNK), then the tiles of the non-empty chunks, exactly as
+ * TilemapData stores them (see PackedTile). Everything is in native byte
+ * order, little endian on every platform we build for. Loading maps the file
+ * and uses the chunks where they are, without parsing or copying.
+ */
+enum class TilemapFormat
+{
+    Text,
+    Binary
+};
+
+/**
+ * The start of a binary tilemap file.
+ */
+struct TilemapFileHeader
+{
+    static constexpr char MAGIC[4] = {'T', 'M', 'A', 'P'};
+    // Increase when the layout changes; older versions are not loaded
+    static constexpr uint16_t VERSION = 1;
+    // Marks chunks with no tiles in the chunk table
+    static constexpr uint32_t EMPTY_CHUNK = 0xFFFFFFFF;
+
+    char magic[4];
+    uint16_t version;
+    // The width and height of a chunk, in tiles
+    uint16_t chunkSize;
+    // The size of the map, in tiles
+    uint32_t width;
+    uint32_t height;
+    // The number of chunks with tiles stored in the file
+    uint32_t storedChunks;
+    uint32_t reserved;
+};
+
+/**
+ * Load a tilemap from a file on the disk, in either TilemapFormat, or from
+ * the mounted asset bundle. Saving always writes the file on the disk.
  */
 class TilemapLoader : public ResourceLoader<TilemapData>
 {
@@ -24,17 +76,151 @@ public:
     virtual void Load(std::string fileLoc) override;
 
     /**
-     * Save the data to the corresponding file (if implemented).
+     * Start reading a tilemap on a worker thread. It is added in a later
+     * ProcessLoads. Maps in the asset bundle are loaded right away, since
+     * they are used where they are mapped.
+     * @param fileLoc The location of the loaded file
+     * @return A future that is ready once Get returns the map
+     */
+    virtual std::shared_future<void> LoadAsync(std::string fileLoc) override;
+
+    /**
+     * Add the maps that finished reading on the workers.
+     * @return The number of maps added
+     */
+    unsigned int ProcessLoads();
+
+    /**
+     * Block until a map is ready for ProcessLoads, or no asynchronous loads
+     * are left.
+     */
+    void WaitForReads();
+
+    /**
+     * Whether there are asynchronous loads that have not finished
+     */
+    bool HasPendingLoads() const { return !mPending.empty(); }
+
+    /**
+     * Save the data to the corresponding file, in the format it was loaded
+     * from.
      * @param resource The place we are saving to
      */
     virtual void Save(std::shared_ptr<TilemapData>& resource) override;
 
+    /**
+     * Save the data to the corresponding file in the given format, which is
+     * used for later saves as well.
+     * @param resource The place we are saving to
+     * @param format The format to save in
+     */
+    void Save(std::shared_ptr<TilemapData>& resource, TilemapFormat format);
+
+    /**
+     * Write a map to a file. The file is replaced once it is fully written,
+     * so it is safe to write over the file a map was loaded from.
+     * @param mapData The map to write
+     * @param fileLoc The location of the file
+     * @param format The format to write in
+     */
+    static void Write(const TilemapData& mapData, const std::string& fileLoc,
+                      TilemapFormat format);
+
+    static void WriteText(const TilemapData& mapData, std::ostream& out);
+    static void WriteBinary(const TilemapData& mapData, std::ostream& out);
+
+    /**
+     * Read a tilemap file on the disk, in either format, without adding it
+     * as a resource. Safe on any thread.
+     * @param fileLoc The location of the file
+     * @param out_format Set to the format of the file
+     * @return The map
+     */
+    static std::shared_ptr<TilemapData> Read(const std::string& fileLoc,
+                                             TilemapFormat* out_format);
+
 private:
     // This class should only be instantiated by the ResourceManager.
     /**
      * Constructs a Tile Map Loader
+     * @param workers The threads to read files on
+     */
+    TilemapLoader(util::ThreadPool* workers);
+    /**
+     * A constructor that we do not want to be implemented
+     */
+    TilemapLoader() = delete;
+
+    /**
+     * An asynchronous load that has not finished.
+     */
+    struct PendingLoad
+    {
+        std::promise<void> promise;
+        std::shared_future<void> future;
+    };
+
+    /**
+     * A file read on a worker thread, waiting to be added.
      */
-    TilemapLoader();
+    struct ReadMap
+    {
+        std::string fileLoc;
+        // Null if the file could not be read
+        std::shared_ptr<TilemapData> mapData;
+        TilemapFormat format = TilemapFormat::Text;
+        std::string error;
+    };
+
+    /**
+     * Look files up in a bundle before the disk.
+     * @param bundle The bundle, or null for none
+     */
+    void SetBundle(const AssetBundle* bundle) { mBundle = bundle; }
+
+    /**
+     * Swap the tiles of a file that changed into its loaded map, so
+     * everything holding the map sees them (see
+     * ResourceManager::EnableHotReload).
+     * @param fileLoc The location of the file
+     * @param mapData The new tiles, taken from it
+     * @param format The format of the file
+     */
+    void ReplaceTiles(const std::string& fileLoc, TilemapData& mapData,
+                      TilemapFormat format);
+
+    static void LoadText(const std::string& fileLoc, TilemapData& mapData);
+    static void LoadBinary(const std::string& fileLoc, TilemapData& mapData);
+
+    /**
+     * Use a binary tilemap in a mapped file where it is.
+     * @param file The mapped file, kept alive by the map
+     * @param offset Where the tilemap starts in the file, page aligned
+     * @param dataSize The size of the tilemap, in bytes
+     * @param mapData The map to load into
+     */
+    static void LoadBinary(std::shared_ptr<util::MappedFile> file,
+                           size_t offset, size_t dataSize,
+                           TilemapData& mapData);
+
+    /**
+     * Where the tiles of the first chunk start in a binary file, aligned so
+     * no chunk straddles a page.
+     * @param gridChunks The number of chunks in the chunk table
+     */
+    static size_t GetChunkDataOffset(size_t gridChunks);
+
+    // The format each map was loaded from or last saved in
+    std::unordered_map<std::string, TilemapFormat> mFormats;
+    const AssetBundle* mBundle = nullptr;
+
+    util::ThreadPool* mWorkers = nullptr;
+    // Asynchronous loads that have not finished, by file
+    std::unordered_map<std::string, PendingLoad> mPending;
+    // Shared with the workers:
+    std::mutex mReadMutex;
+    std::condition_variable mReadReady;
+    std::deque<ReadMap> mRead;
 
     friend class ResourceManager;
 };
@@ -1,12 +1,16 @@
 #ifndef __TILEMAPDATA_HPP__
 #define __TILEMAPDATA_HPP__
 
-#include <deque>
-#include <forward_list>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <set>
+#include <vector>
 
 #include <glm/vec2.hpp>
 
+#include "core/util/MappedFile.hpp"
+
 /**
  * Represents the tile index and whether
  * if it is a collider.
@@ -26,16 +30,74 @@ inline bool operator==(const TileData& lhs, const TileData& rhs);
 typedef glm::ivec2 TileLoc;
 typedef glm::uvec2 Size2D;
 
+/**
+ * An event listener interface for changes to a TilemapData.
+ */
+class ITilemapChangeListener
+{
+public:
+    /**
+     * Handle a tile being set (after the map has grown to fit it).
+     * @param tileLoc The location of the tile that changed
+     */
+    virtual void HandleTileChanged(TileLoc tileLoc) = 0;
+
+    /**
+     * Handle the map changing size or shifting its origin, which invalidates
+     * every previously known tile location.
+     */
+    virtual void HandleTilemapResized() = 0;
+
+    /**
+     * Handle a whole area of tiles changing at once, e.g. a chunk of a
+     * streamed map loading or unloading. Handles each tile by default.
+     * @param first The top left tile of the area
+     * @param size The size of the area, in tiles
+     */
+    virtual void HandleAreaChanged(TileLoc first, Size2D size)
+    {
+        TileLoc tileLoc;
+        for (tileLoc.y = first.y; tileLoc.y < first.y + size.y; ++tileLoc.y)
+        {
+            for (tileLoc.x = first.x; tileLoc.x < first.x + size.x; ++tileLoc.x)
+                HandleTileChanged(tileLoc);
+        }
+    }
+};
+
+/**
+ * A tile packed into 16 bits: the type + 1 (so empty tiles are 0) in the low
+ * 15 bits, and whether it has a collider in the top bit. Types above 32766
+ * can not be stored.
+ */
+typedef uint16_t PackedTile;
+
 /**
  * A dynamic data structure for storing a tile map.
+ *
+ * Tiles are packed (see PackedTile) and stored in square chunks of
+ * CHUNK_SIZE x CHUNK_SIZE, which are only allocated once a tile in them is
+ * set. The map is a window into a larger grid of chunks: the origin is the
+ * location of tile (0, 0) in the grid, so growing or shrinking the map on any
+ * side only moves the origin. When the map outgrows the grid, the grid
+ * doubles in that direction, moving chunk pointers but never tiles, so
+ * growth is amortized O(1) per tile added.
+ *
+ * The chunks of a map loaded from a binary tilemap file point straight into
+ * the mapped file (see TilemapLoader), which is read only. A mapped chunk is
+ * copied into memory the first time one of its tiles changes, so edits never
+ * reach the file, or later loads of the same map.
+ *
+ * A streamed map (see TilemapStreamer) has a fixed size and only some of its
+ * chunks loaded. Tiles in the other chunks read as the unloaded tile, and
+ * can not be set.
  */
 class TilemapData
 {
-private:
-    typedef std::deque<TileData> TileRow;
-    typedef std::deque<TileRow> TileGrid;
-
 public:
+    // The width and height of a storage chunk, in tiles
+    static constexpr unsigned int CHUNK_SIZE = 32;
+
     ~TilemapData();
 
     TileData GetTile(TileLoc loc) const noexcept;
@@ -43,12 +105,124 @@ public:
 
     inline Size2D GetSize() const { return mSize; }
 
+    /**
+     * The number of bytes used to store the tiles. Chunks in a mapped file
+     * are not counted, since the file backs them.
+     * @return The size of the chunks and the chunk grid, in bytes
+     */
+    size_t GetMemoryUsage() const;
+
+    /**
+     * Whether the map is streamed in by chunks
+     */
+    bool IsStreamed() const { return !mChunkLoaded.empty(); }
+
+    /**
+     * Whether a tile is on the map and in a loaded chunk
+     * @param tileLoc The location of the tile
+     */
+    bool IsTileLoaded(TileLoc tileLoc) const;
+
+    /**
+     * Set what tiles in chunks that are not loaded read as, for rendering and
+     * collision. By default they are not drawn, but have a collider, so
+     * nothing can move into an area before it has loaded.
+     * @param tile The tile to use for unloaded tiles
+     */
+    void SetUnloadedTile(TileData tile);
+    TileData GetUnloadedTile() const { return Unpack(mUnloadedTile); }
+
     void Print(std::ostream& out = std::cout) const;
 
+    /**
+     * Adds a change listener
+     * @param listener The listener we are adding
+     */
+    void AddChangeListener(ITilemapChangeListener* listener);
+
+    /**
+     * Removes a change listener
+     * @param listener The listener we are removing
+     */
+    void RemoveChangeListener(ITilemapChangeListener* listener);
+
 private:
-    TileGrid mData;
+    struct TileChunk
+    {
+        PackedTile tiles[CHUNK_SIZE * CHUNK_SIZE];
+    };
+
+    /**
+     * Frees chunks, unless they are in the mapped file.
+     */
+    struct ChunkDeleter
+    {
+        bool bMapped = false;
+        void operator()(TileChunk* chunk) const
+        {
+            if (!bMapped) delete chunk;
+        }
+    };
+    typedef std::unique_ptr<TileChunk, ChunkDeleter> ChunkPtr;
+
+    static PackedTile Pack(TileData tile);
+    static TileData Unpack(PackedTile tile);
+
+    /**
+     * Get the packed tile at a location, if its chunk has been allocated.
+     * @param tileLoc The location of the tile, which must be on the map
+     * @param allocate Whether to allocate the chunk if it does not exist
+     * @return The tile, or null if its chunk does not exist
+     */
+    PackedTile* FindTile(TileLoc tileLoc, bool allocate);
+
+    /**
+     * Get a chunk to change its tiles, copying it out of the mapped file
+     * first if it is mapped.
+     * @param chunk The chunk, which must not be null
+     * @return The chunk, now owned by the map
+     */
+    static TileChunk* GetWritableChunk(ChunkPtr& chunk);
+
+    /**
+     * Grow the chunk grid so the map can grow by some tiles on each side
+     * without moving. Each axis that grows at least doubles, which keeps
+     * growth amortized O(1) per tile.
+     * @param front The number of tiles needed before the map
+     * @param back The number of tiles needed after the map
+     */
+    void ReserveGrid(Size2D front, Size2D back);
+
+    /**
+     * Free the chunks that no longer overlap the map.
+     */
+    void ReleaseUnusedChunks();
+
+    /**
+     * Reset an area of the map to empty tiles.
+     * @param first The top left tile of the area
+     * @param size The size of the area, in tiles
+     */
+    void ClearArea(TileLoc first, Size2D size);
+
+    // The binary tilemap file (or asset bundle) the chunks were loaded from,
+    // if any
+    std::shared_ptr<util::MappedFile> mMappedFile;
+    // Chunks in row major order, null where every tile is empty
+    std::vector<ChunkPtr> mChunks;
+    // The size of the grid, in chunks
+    Size2D mGridSize{0, 0};
+    // Where tile (0, 0) is in the grid, in tiles
+    TileLoc mOrigin{0, 0};
     Size2D mSize{0, 0};
 
+    // Whether each chunk is loaded, only for streamed maps
+    std::vector<bool> mChunkLoaded;
+    // An empty tile with a collider
+    PackedTile mUnloadedTile = 0x8000;
+
+    std::set<ITilemapChangeListener*> mChangeListeners;
+
     /**
      * Create an empty TilemapData.
      *
@@ -57,13 +231,6 @@ private:
      *       or use the EmplaceRows/EmplaceCols methods to grow the TilemapData.
      */
     TilemapData();
-    /**
-     * Create a TilemapData from a preconstructed 2D array.
-     *
-     * WARN: Assumes that the 2D list is not jagged and has dimensions h x w
-     * (row major).
-     */
-    TilemapData(Size2D size, const TileGrid& tileData);
 
     void PopRowsFront(unsigned int count);
     void PopRowsBack(unsigned int count);
@@ -83,7 +250,40 @@ private:
      */
     void EnsureAtLeast1x1();
 
+    /**
+     * Make this an empty streamed map, with every chunk unloaded.
+     * @param size The size of the map, in tiles
+     */
+    void InitStreamed(Size2D size);
+
+    /**
+     * Load a chunk of a streamed map.
+     * @param chunkLoc The location of the chunk, in chunks
+     * @param chunk The tiles of the chunk, or null if they are all empty
+     */
+    void LoadChunk(TileLoc chunkLoc, std::unique_ptr<TileChunk> chunk);
+
+    /**
+     * Unload a chunk of a streamed map, freeing its tiles.
+     * @param chunkLoc The location of the chunk, in chunks
+     */
+    void UnloadChunk(TileLoc chunkLoc);
+
+    /**
+     * Take the tiles of another map, e.g. one read again from a changed
+     * file. The listeners stay, and see the map as resized.
+     * @param other The map to take the tiles from, left empty
+     */
+    void ReplaceTiles(TilemapData& other);
+
+    /**
+     * Tell the listeners that the tiles of a chunk changed.
+     * @param chunkLoc The location of the chunk, in chunks
+     */
+    void NotifyChunkChanged(TileLoc chunkLoc);
+
     friend class TilemapLoader;
+    friend class TilemapStreamer;
 };
 
 #endif
@@ -0,0 +1,164 @@
+#ifndef __TILEMAPSTREAMER_HPP__
+#define __TILEMAPSTREAMER_HPP__
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "core/resources/TilemapData.hpp"
+
+/**
+ * Streams a large tilemap from disk one chunk at a time, so only the part of
+ * the map around the camera is in memory.
+ *
+ * A streamed world is a directory with a "world" file holding the width and
+ * height of the map in tiles, and a file per chunk of
+ * TilemapData::CHUNK_SIZE x CHUNK_SIZE tiles named "<x>_<y>" (in chunks), in
+ * the same text format as a tilemap file. Chunks without a file are empty.
+ * WriteWorld splits a loaded map into this layout.
+ *
+ * Chunks are read on a background thread as the view comes within the load
+ * distance of them, nearest first, and handed to the map in Update. Until
+ * then their tiles read as the map's unloaded tile (see
+ * TilemapData::SetUnloadedTile). Chunks beyond the keep distance are
+ * unloaded, as are the least recently used ones while the loaded chunks take
+ * more than the memory budget. Chunks within the load distance are never
+ * unloaded for the budget.
+ */
+class TilemapStreamer
+{
+public:
+    /**
+     * Open a streamed world and start its loading thread. No chunks are
+     * loaded until Update.
+     * @param worldDir The directory of the world
+     */
+    explicit TilemapStreamer(const std::string& worldDir);
+
+    /**
+     * Stops the loading thread
+     */
+    ~TilemapStreamer();
+
+    TilemapStreamer(const TilemapStreamer&) = delete;
+    TilemapStreamer& operator=(const TilemapStreamer&) = delete;
+
+    /**
+     * The streamed map, the size of the whole world
+     */
+    std::shared_ptr<TilemapData> GetMapData() { return mMapData; }
+
+    /**
+     * Set how far from the view chunks are loaded and kept.
+     * @param loadDistance Chunks this many chunks from the view are loaded
+     * @param keepDistance Chunks further than this are unloaded
+     */
+    void SetStreamDistance(unsigned int loadDistance,
+                           unsigned int keepDistance);
+
+    /**
+     * Set how much memory the loaded chunks may take before the least
+     * recently used ones are unloaded.
+     * @param bytes The budget, in bytes
+     */
+    void SetMemoryBudget(size_t bytes) { mMemoryBudget = bytes; }
+
+    /**
+     * Load the chunks that arrived since the last update, request the ones
+     * that are now close to the view, and unload the ones that are not
+     * needed. Must be called on the thread that uses the map.
+     * @param firstVisible The top left visible tile
+     * @param lastVisible The bottom right visible tile (inclusive)
+     */
+    void Update(TileLoc firstVisible, TileLoc lastVisible);
+
+    /**
+     * The memory taken by the loaded chunks, in bytes
+     */
+    size_t GetLoadedBytes() const { return mLoadedBytes; }
+
+    /**
+     * The number of loaded chunks
+     */
+    unsigned int GetLoadedChunkCount() const { return mLastUsed.size(); }
+
+    /**
+     * The number of chunks requested but not loaded yet
+     */
+    unsigned int GetPendingChunkCount() const { return mRequested.size(); }
+
+    /**
+     * Split a map into chunk files that can be streamed. The directory must
+     * already exist.
+     * @param map The map to split
+     * @param worldDir The directory to write the world to
+     */
+    static void WriteWorld(const TilemapData& map, const std::string& worldDir);
+
+private:
+    struct LoadedChunk
+    {
+        TileLoc chunkLoc;
+        // Null if every tile is empty
+        std::unique_ptr<TilemapData::TileChunk> tiles;
+    };
+
+    void ThreadLoop();
+
+    /**
+     * Read the tiles of a chunk from its file.
+     * @param chunkLoc The location of the chunk, in chunks
+     * @return The tiles, or null if the chunk is empty or has no file
+     */
+    std::unique_ptr<TilemapData::TileChunk> ReadChunk(TileLoc chunkLoc) const;
+
+    /**
+     * How far a chunk is from the visible chunks, in chunks.
+     */
+    unsigned int GetDistance(TileLoc chunkLoc) const;
+
+    void UnloadChunk(unsigned int chunkIndex);
+
+    TileLoc GetChunkLoc(unsigned int chunkIndex) const
+    {
+        return TileLoc(chunkIndex % mGridSize.x, chunkIndex / mGridSize.x);
+    }
+
+    std::string mWorldDir;
+    std::shared_ptr<TilemapData> mMapData;
+    // The size of the map, in chunks
+    Size2D mGridSize{0, 0};
+
+    unsigned int mLoadDistance = 1;
+    unsigned int mKeepDistance = 2;
+    size_t mMemoryBudget = 16 * 1024 * 1024;
+
+    // The visible chunks, as of the last update
+    TileLoc mFirstVisibleChunk{0, 0};
+    TileLoc mLastVisibleChunk{0, 0};
+    uint64_t mUpdateCount = 0;
+
+    // Only used on the map's thread:
+    // The last update each loaded chunk was near the view, by chunk index
+    std::unordered_map<unsigned int, uint64_t> mLastUsed;
+    // Chunks requested from the loading thread and not yet loaded
+    std::unordered_set<unsigned int> mRequested;
+    size_t mLoadedBytes = 0;
+
+    // Shared with the loading thread:
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mRequestAvailable;
+    std::deque<TileLoc> mRequests;
+    std::vector<LoadedChunk> mLoaded;
+    bool mbStopping = false;
+};
+
+#endif  // __TILEMAPSTREAMER_HPP__
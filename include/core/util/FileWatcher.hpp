@@ -0,0 +1,91 @@
+#ifndef __FILEWATCHER_HPP__
+#define __FILEWATCHER_HPP__
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace util
+{
+
+/**
+ * Watches files for changes on a background thread, with inotify. Only
+ * supported on Linux; elsewhere nothing is ever reported.
+ *
+ * The directories of the files are watched rather than the files, so files
+ * that are replaced (as most editors save) are still seen. A file is only
+ * reported once it has not changed for the debounce time, so a save that
+ * takes several writes is reported once, after the last of them.
+ */
+class FileWatcher
+{
+public:
+    /**
+     * Start the watching thread.
+     * @param debounceMs How long a file must go unchanged before it is
+     * reported, in milliseconds
+     */
+    explicit FileWatcher(unsigned int debounceMs = 100);
+
+    /**
+     * Stops the watching thread
+     */
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /**
+     * Whether changes can be watched on this platform
+     */
+    bool IsSupported() const;
+
+    /**
+     * Start watching a file. Watching a file twice does nothing.
+     * @param fileLoc The location of the file, as it will be reported
+     * @return false if the directory of the file could not be watched
+     */
+    bool Watch(const std::string& fileLoc);
+
+    /**
+     * Take the files that changed since the last call.
+     * @param out Filled with the locations of the files, as given to Watch
+     */
+    void TakeChanges(std::vector<std::string>& out);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    void ThreadLoop();
+
+    /**
+     * Report the files that have been quiet for the debounce time.
+     * @return How long until the next one may be, or -1 if none are waiting
+     */
+    int PromoteQuietFiles();
+
+    std::chrono::milliseconds mDebounce;
+    int mInotifyFd = -1;
+    // Written to, to wake the thread up to stop
+    int mWakePipe[2] = {-1, -1};
+    std::thread mThread;
+
+    // Shared with the watching thread:
+    std::mutex mMutex;
+    // The prefix of files in each watched directory, by watch descriptor
+    std::unordered_map<int, std::string> mDirs;
+    std::unordered_set<std::string> mWatchedDirs;
+    std::unordered_set<std::string> mFiles;
+    // Files that changed, by when they last did
+    std::unordered_map<std::string, Clock::time_point> mChanged;
+    // Files that have been quiet for the debounce time
+    std::vector<std::string> mReady;
+};
+
+}  // namespace util
+
+#endif  // __FILEWATCHER_HPP__
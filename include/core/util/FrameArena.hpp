@@ -0,0 +1,157 @@
+#ifndef __FRAMEARENA_HPP__
+#define __FRAMEARENA_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace util
+{
+
+/**
+ * A linear (bump) allocator for data that only lives for a single frame.
+ *
+ * Allocations are a single atomic add, so the arena can be shared by
+ * components updating in parallel. Nothing is freed individually; the Engine
+ * resets the whole arena at the end of every frame.
+ * If the arena runs out of space, allocations fall back to the heap until the
+ * next reset.
+ *
+ * WARN: destructors are never run for objects placed in the arena.
+ */
+class FrameArena
+{
+public:
+    /**
+     * Constructor
+     * @param capacity The size of the arena in bytes
+     */
+    explicit FrameArena(size_t capacity = 1 << 20);
+    /**
+     * Destructor
+     */
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    /**
+     * Allocate uninitialized memory that is valid until the next Reset.
+     * @param size The number of bytes
+     * @param alignment The alignment of the allocation (power of two)
+     * @return The allocated memory
+     */
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    /**
+     * Construct an object in the arena.
+     * @tparam T The type of the object, must be trivially destructible
+     * @param args The constructor arguments
+     * @return The new object, valid until the next Reset
+     */
+    template <typename T, typename... Args>
+    T* New(Args&&... args)
+    {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "Frame arena objects are never destroyed.");
+        return new (Allocate(sizeof(T), alignof(T)))
+            T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * Allocate an uninitialized array in the arena.
+     * @tparam T The type of the elements, must be trivially destructible
+     * @param count The number of elements
+     * @return The array, valid until the next Reset
+     */
+    template <typename T>
+    T* NewArray(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "Frame arena objects are never destroyed.");
+        return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    /**
+     * Free every allocation at once.
+     */
+    void Reset();
+
+    /**
+     * Bytes allocated since the last reset (including heap overflow).
+     */
+    size_t GetUsed() const
+    {
+        return mOffset.load(std::memory_order_relaxed) + mOverflowBytes;
+    }
+
+    /**
+     * Bytes used by the previous frame, right before its reset.
+     */
+    size_t GetLastFrameUsage() const { return mLastFrameUsage; }
+
+    /**
+     * The most bytes used by any frame so far.
+     */
+    size_t GetPeakUsage() const { return mPeakUsage; }
+
+    size_t GetCapacity() const { return mCapacity; }
+
+private:
+    char* mBuffer = nullptr;
+    size_t mCapacity = 0;
+    std::atomic<size_t> mOffset{0};
+
+    // Heap allocations (and their alignment) made after the arena filled up
+    std::mutex mOverflowMutex;
+    std::vector<std::pair<void*, size_t>> mOverflow;
+    size_t mOverflowBytes = 0;
+
+    size_t mLastFrameUsage = 0;
+    size_t mPeakUsage = 0;
+};
+
+/**
+ * An STL allocator that places containers in a frame arena, for scratch
+ * buffers that are thrown away at the end of the frame.
+ * @tparam T The type of the elements
+ */
+template <typename T>
+struct FrameAllocator
+{
+    typedef T value_type;
+
+    FrameAllocator(FrameArena* arena) noexcept : arena(arena) {}
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>& other) noexcept
+        : arena(other.arena)
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(arena->Allocate(sizeof(T) * count, alignof(T)));
+    }
+    void deallocate(T*, size_t) noexcept {}
+
+    template <typename U>
+    bool operator==(const FrameAllocator<U>& other) const noexcept
+    {
+        return arena == other.arena;
+    }
+    template <typename U>
+    bool operator!=(const FrameAllocator<U>& other) const noexcept
+    {
+        return arena != other.arena;
+    }
+
+    FrameArena* arena;
+};
+
+}  // namespace util
+
+#endif  // __FRAMEARENA_HPP__
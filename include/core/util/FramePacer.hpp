@@ -0,0 +1,103 @@
+#ifndef __FRAMEPACER_HPP__
+#define __FRAMEPACER_HPP__
+
+#include <vector>
+
+#if defined(LINUX) || defined(MINGW)
+#include <SDL2/SDL.h>
+#else  // This works for Mac
+#include <SDL.h>
+#endif
+
+namespace util
+{
+
+/**
+ * How long a frame took, in seconds.
+ */
+struct FrameTiming
+{
+    // From the start of the frame to the start of the next one
+    float frameTime = 0;
+    // Time spent on the frame itself, before waiting for the next one
+    float workTime = 0;
+};
+
+/**
+ * Keeps frames to a target rate using the high resolution performance
+ * counter, and measures how long each frame really took.
+ *
+ * Waiting sleeps until shortly before the deadline (the OS may oversleep by a
+ * millisecond or two), then spins for the rest, so frames start on time
+ * without burning a core for the whole wait.
+ */
+class FramePacer
+{
+public:
+    // The number of frames kept in the timing history
+    static constexpr unsigned int HISTORY_SIZE = 240;
+    // Longer frames (e.g. after a breakpoint) report this as their delta, so
+    // the simulation does not jump
+    static constexpr float MAX_DELTA_TIME = 0.25f;
+
+    /**
+     * Constructor
+     * @param targetFrameRate Frames per second to pace to, 0 to not wait
+     */
+    explicit FramePacer(double targetFrameRate = 60.0);
+
+    /**
+     * Set the rate to pace to.
+     * @param targetFrameRate Frames per second, or 0 to not wait at all (e.g.
+     * when presenting already waits for vsync)
+     */
+    void SetTargetFrameRate(double targetFrameRate);
+    double GetTargetFrameRate() const { return mTargetFrameRate; }
+
+    /**
+     * Wait until the next frame is due and start it.
+     * @return The measured time since the previous frame started, in seconds
+     */
+    float WaitForNextFrame();
+
+    /**
+     * Get the timings of recent frames.
+     * @param out Set to the timings, oldest first
+     */
+    void GetHistory(std::vector<FrameTiming>& out) const;
+
+    /**
+     * The average timing over the history
+     */
+    FrameTiming GetAverage() const;
+
+    /**
+     * The standard deviation of the frame time over the history, in seconds
+     */
+    float GetJitter() const;
+
+    /**
+     * The longest frame time in the history, in seconds
+     */
+    float GetLongestFrameTime() const;
+
+private:
+    // Sleep only while at least this far from the deadline
+    static constexpr double SPIN_THRESHOLD_MS = 2.0;
+
+    double mTargetFrameRate;
+    Uint64 mFrequency;
+    // 0 when not pacing
+    Uint64 mTargetTicks = 0;
+    // 0 before the first frame
+    Uint64 mFrameStart = 0;
+
+    // Ring buffer of recent frames
+    FrameTiming mHistory[HISTORY_SIZE];
+    unsigned int mHistoryCount = 0;
+    unsigned int mHistoryNext = 0;
+};
+
+}  // namespace util
+
+#endif  // __FRAMEPACER_HPP__
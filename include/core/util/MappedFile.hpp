@@ -0,0 +1,51 @@
+#ifndef __MAPPEDFILE_HPP__
+#define __MAPPEDFILE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace util
+{
+
+/**
+ * The contents of a whole file, mapped into memory so nothing is read until
+ * it is used. Where the platform can not map files (MINGW), the file is read
+ * into memory instead.
+ */
+class MappedFile
+{
+public:
+    /**
+     * Map a file.
+     * @param path The path of the file
+     * @param bWritable Whether the memory may be written to. Writes are
+     * private to this mapping (copy on write) and never reach the file.
+     * @throws std::runtime_error if the file could not be opened or mapped
+     */
+    explicit MappedFile(const std::string& path, bool bWritable = false);
+
+    /**
+     * Unmaps the file
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    uint8_t* GetData() { return mData; }
+    const uint8_t* GetData() const { return mData; }
+    size_t GetSize() const { return mSize; }
+
+private:
+    uint8_t* mData = nullptr;
+    size_t mSize = 0;
+#ifdef MINGW
+    std::vector<uint8_t> mBuffer;
+#endif
+};
+
+}  // namespace util
+
+#endif  // __MAPPEDFILE_HPP__
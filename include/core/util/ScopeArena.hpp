@@ -0,0 +1,221 @@
+#ifndef __SCOPEARENA_HPP__
+#define __SCOPEARENA_HPP__
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace util
+{
+
+/**
+ * A linear (bump) allocator for data that lives as long as a scope, such as
+ * a level, so tearing the scope down is a single Reset instead of a free per
+ * object.
+ *
+ * Memory comes from large blocks, and grows by another block when one fills
+ * up. Objects made with New that have destructors are chained together, and
+ * Reset destroys them in the reverse order they were made, then rewinds the
+ * arena. Nothing else is freed individually.
+ *
+ * WARN: not thread safe. Only allocate from the main thread, or between
+ * frames.
+ */
+class ScopeArena
+{
+public:
+    /**
+     * Constructor
+     * @param blockSize The size of each block of the arena in bytes
+     */
+    explicit ScopeArena(size_t blockSize = 1 << 20);
+    /**
+     * Destructor, which resets the arena
+     */
+    ~ScopeArena();
+
+    ScopeArena(const ScopeArena&) = delete;
+    ScopeArena& operator=(const ScopeArena&) = delete;
+
+    /**
+     * Allocate uninitialized memory that is valid until the next Reset.
+     * @param size The number of bytes
+     * @param alignment The alignment of the allocation (power of two)
+     * @return The allocated memory
+     */
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    /**
+     * Construct an object in the arena. Its destructor runs on Reset, unless
+     * it is destroyed earlier with Delete.
+     * @tparam T The type of the object
+     * @param args The constructor arguments
+     * @return The new object, valid until the next Reset
+     */
+    template <typename T, typename... Args>
+    T* New(Args&&... args)
+    {
+        if constexpr (std::is_trivially_destructible<T>::value)
+        {
+            return new (Allocate(sizeof(T), alignof(T)))
+                T(std::forward<Args>(args)...);
+        }
+        else
+        {
+            void* memory = AllocateFinalized(sizeof(T), alignof(T));
+            T* object = new (memory) T(std::forward<Args>(args)...);
+            // Only chained once constructed, in case the constructor throws
+            AddFinalizer(memory, [](void* ptr) { static_cast<T*>(ptr)->~T(); });
+            return object;
+        }
+    }
+
+    /**
+     * Destroy an object made with New before the arena is reset. Its memory
+     * is only reused after the reset.
+     * @param object The object, or a base of it if its type is polymorphic
+     */
+    template <typename T>
+    void Delete(T* object)
+    {
+        if constexpr (!std::is_trivially_destructible<T>::value)
+        {
+            if (!object) return;
+
+            // The finalizer is in front of the whole object
+            void* start;
+            if constexpr (std::is_polymorphic<T>::value)
+                start = dynamic_cast<void*>(object);
+            else
+                start = object;
+            RunFinalizer(start);
+        }
+    }
+
+    /**
+     * Destroy every object made with New, newest first, then free every
+     * allocation at once. All blocks but the first are given back.
+     * WARN: destructors must not allocate in the arena.
+     */
+    void Reset();
+
+    /**
+     * Bytes allocated since the last reset
+     */
+    size_t GetUsed() const { return mUsed; }
+
+    /**
+     * The size of all the blocks of the arena in bytes
+     */
+    size_t GetCapacity() const { return mCapacity; }
+
+    /**
+     * The number of objects Reset will destroy
+     */
+    size_t GetFinalizerCount() const { return mFinalizerCount; }
+
+private:
+    /**
+     * Put in front of each object made with New that has a destructor.
+     */
+    struct Finalizer
+    {
+        // Null once the object has been destroyed
+        void (*destroy)(void*);
+        Finalizer* previous;
+    };
+
+    /**
+     * A block of memory the arena allocates from.
+     */
+    struct Block
+    {
+        char* memory;
+        size_t size;
+    };
+
+    /**
+     * Allocate memory for an object with room for a Finalizer in front.
+     */
+    void* AllocateFinalized(size_t size, size_t alignment);
+
+    /**
+     * Chain the finalizer in front of an object constructed in memory from
+     * AllocateFinalized.
+     */
+    void AddFinalizer(void* object, void (*destroy)(void*));
+
+    /**
+     * Destroy an object made with New, if it has not been already.
+     */
+    void RunFinalizer(void* object);
+
+    /**
+     * Add a block with room for at least the given number of bytes.
+     */
+    void AddBlock(size_t minSize);
+
+    size_t mBlockSize;
+    std::vector<Block> mBlocks;
+    // The block being allocated from, and the offset into it
+    size_t mBlockIdx = 0;
+    size_t mOffset = 0;
+    // The newest object with a destructor
+    Finalizer* mLastFinalizer = nullptr;
+    size_t mFinalizerCount = 0;
+
+    size_t mUsed = 0;
+    size_t mCapacity = 0;
+};
+
+/**
+ * An STL allocator that places containers in a scope arena, or on the heap
+ * without one. Memory in an arena is only freed when it is reset, so
+ * containers should be sized up front.
+ * @tparam T The type of the elements
+ */
+template <typename T>
+struct ScopeAllocator
+{
+    typedef T value_type;
+
+    ScopeAllocator(ScopeArena* arena = nullptr) noexcept : arena(arena) {}
+    template <typename U>
+    ScopeAllocator(const ScopeAllocator<U>& other) noexcept
+        : arena(other.arena)
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+        if (arena)
+        {
+            return static_cast<T*>(
+                arena->Allocate(sizeof(T) * count, alignof(T)));
+        }
+        return static_cast<T*>(::operator new(sizeof(T) * count));
+    }
+    void deallocate(T* memory, size_t) noexcept
+    {
+        if (!arena) ::operator delete(memory);
+    }
+
+    template <typename U>
+    bool operator==(const ScopeAllocator<U>& other) const noexcept
+    {
+        return arena == other.arena;
+    }
+    template <typename U>
+    bool operator!=(const ScopeAllocator<U>& other) const noexcept
+    {
+        return arena != other.arena;
+    }
+
+    ScopeArena* arena;
+};
+
+}  // namespace util
+
+#endif  // __SCOPEARENA_HPP__
@@ -0,0 +1,121 @@
+#ifndef __SPATIALGRID_HPP__
+#define __SPATIALGRID_HPP__
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "core/util/SDLConversions.hpp"
+
+namespace util
+{
+
+/**
+ * A uniform grid that buckets rectangles by the cells they overlap, for
+ * quickly finding everything near a region of the world.
+ *
+ * Entries are identified by an id chosen by the caller (e.g. an index into
+ * an array). Entries without bounds are returned by every query.
+ */
+class SpatialGrid
+{
+public:
+    /**
+     * Constructor
+     * @param cellSize The width and height of a cell in world units
+     */
+    explicit SpatialGrid(float cellSize = 256.0f) : mCellSize(cellSize) {}
+
+    /**
+     * Remove all entries (keeps allocated cells for reuse).
+     */
+    void Clear();
+
+    /**
+     * Add an entry that covers the given rectangle.
+     * @param id The id of the entry
+     * @param bounds The world space bounds of the entry
+     */
+    void Insert(unsigned int id, const FRect& bounds);
+
+    /**
+     * Add an entry without bounds, which every query returns.
+     * @param id The id of the entry
+     */
+    void InsertUnbounded(unsigned int id);
+
+    /**
+     * Find all entries that overlap the rectangle.
+     * @tparam Allocator The allocator of the output, e.g. a FrameAllocator
+     * for scratch queries
+     * @param rect The world space region to search
+     * @param out The ids that were found, sorted and without duplicates
+     */
+    template <typename Allocator>
+    void Query(const FRect& rect,
+               std::vector<unsigned int, Allocator>& out) const
+    {
+        out.clear();
+        out.insert(out.end(), mUnbounded.begin(), mUnbounded.end());
+
+        int minX = std::floor(rect.x / mCellSize);
+        int minY = std::floor(rect.y / mCellSize);
+        int maxX = std::floor((rect.x + rect.w) / mCellSize);
+        int maxY = std::floor((rect.y + rect.h) / mCellSize);
+
+        for (int y = minY; y <= maxY; ++y)
+        {
+            for (int x = minX; x <= maxX; ++x)
+            {
+                auto cellIt = mCells.find(CellKey(x, y));
+                if (cellIt == mCells.end()) continue;
+
+                for (const Entry& entry : cellIt->second)
+                {
+                    if (HasIntersection(entry.bounds, rect))
+                        out.push_back(entry.id);
+                }
+            }
+        }
+
+        // Entries spanning several cells are found more than once
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+    /**
+     * The number of entries with bounds
+     */
+    size_t GetBoundedCount() const { return mBoundedCount; }
+
+    /**
+     * The number of entries without bounds
+     */
+    size_t GetUnboundedCount() const { return mUnbounded.size(); }
+
+private:
+    struct Entry
+    {
+        unsigned int id;
+        FRect bounds;
+    };
+
+    /**
+     * Pack the coordinates of a cell into a single key.
+     */
+    static int64_t CellKey(int x, int y)
+    {
+        return ((int64_t)x << 32) | (uint32_t)y;
+    }
+
+    float mCellSize;
+    std::unordered_map<int64_t, std::vector<Entry>> mCells;
+    std::vector<unsigned int> mUnbounded;
+    size_t mBoundedCount = 0;
+};
+
+}  // namespace util
+
+#endif  // __SPATIALGRID_HPP__
@@ -0,0 +1,75 @@
+#ifndef __THREADPOOL_HPP__
+#define __THREADPOOL_HPP__
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace util
+{
+
+/**
+ * A fixed set of worker threads that execute submitted tasks in FIFO order.
+ *
+ * A pool with zero workers is valid; every task is then run inline on the
+ * calling thread.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * Spawns the worker threads
+     * @param workerCount The number of worker threads to spawn
+     */
+    explicit ThreadPool(unsigned int workerCount);
+
+    /**
+     * Finishes all queued tasks and joins the worker threads
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Queue a task to be run on a worker thread
+     * @param task The task to run
+     * @return A future that is ready once the task has run
+     */
+    std::future<void> Submit(std::function<void()> task);
+
+    /**
+     * Run all of the given tasks and block until they are done.
+     * The calling thread runs tasks as well instead of idling.
+     * @param tasks The tasks to run
+     */
+    void RunAll(std::vector<std::function<void()>>& tasks);
+
+    /**
+     * The number of worker threads (not including the calling thread)
+     */
+    unsigned int GetWorkerCount() const { return mWorkers.size(); }
+
+    /**
+     * The number of workers to use by default, one less than the number of
+     * hardware threads to leave room for the main thread.
+     */
+    static unsigned int DefaultWorkerCount();
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> mWorkers;
+    std::queue<std::packaged_task<void()>> mTasks;
+    std::mutex mMutex;
+    std::condition_variable mTaskAvailable;
+    bool mbStopping = false;
+};
+
+}  // namespace util
+
+#endif  // __THREADPOOL_HPP__
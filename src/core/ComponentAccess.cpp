@@ -0,0 +1,29 @@
+#include "core/ComponentAccess.hpp"
+
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+ComponentMask ComponentTypeMask(const std::string& type)
+{
+    static std::mutex registryMutex;
+    static std::unordered_map<std::string, unsigned int> registry;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    auto typeIt = registry.find(type);
+    if (typeIt != registry.end())
+    {
+        return ComponentMask(1) << typeIt->second;
+    }
+
+    if (registry.size() >= sizeof(ComponentMask) * 8)
+    {
+        throw std::length_error(
+            "Too many component types to track access for.");
+    }
+
+    unsigned int bit = registry.size();
+    registry.emplace(type, bit);
+    return ComponentMask(1) << bit;
+}
@@ -9,21 +9,37 @@
 #include <glm/vec2.hpp>
 #include <iostream>
 
-ControllerComponent::ControllerComponent() : Component("controller") {}
+ControllerComponent::ControllerComponent()
+    : Component("controller"),
+      mMoveRight(InputState::GetActionId(InputState::MOVE_RIGHT)),
+      mMoveLeft(InputState::GetActionId(InputState::MOVE_LEFT)),
+      mMoveUp(InputState::GetActionId(InputState::MOVE_UP)),
+      mMoveDown(InputState::GetActionId(InputState::MOVE_DOWN))
+{
+}
 
 ControllerComponent::~ControllerComponent() {}
 
+ComponentAccess ControllerComponent::GetAccess() const
+{
+    static const ComponentAccess access =
+        ComponentAccess()
+            .Reads({"input", "transform", "collider"})
+            .Writes({"transform", "camera", "collider", "messages"});
+    return access;
+}
+
 void ControllerComponent::Update(UpdateContext* update)
 {
     TransformComponent& transform = mGameObject->GetTransform();
 
-    int horizontal = InputManager::State->GetAxis("D", "A");
-    int vertical = -InputManager::State->GetAxis("W", "S");
+    int horizontal = InputManager::State->GetAxis(mMoveRight, mMoveLeft);
+    int vertical = -InputManager::State->GetAxis(mMoveUp, mMoveDown);
 
     if (horizontal == 0 && vertical == 0)
     {
         // idle
-        mGameObject->BroadcastMessage("idle");
+        mGameObject->PostMessage("idle");
         update->cameraCenter = transform.GetPosition();
         return;
     }
@@ -31,22 +47,22 @@ void ControllerComponent::Update(UpdateContext* update)
     if (horizontal == 1)
     {
         // moving right
-        mGameObject->BroadcastMessage("move_right");
+        mGameObject->PostMessage("move_right");
     }
     else if (horizontal == -1)
     {
         // moving left
-        mGameObject->BroadcastMessage("move_left");
+        mGameObject->PostMessage("move_left");
     }
     else if (vertical == 1)
     {
         // moving down
-        mGameObject->BroadcastMessage("move_down");
+        mGameObject->PostMessage("move_down");
     }
     else if (vertical == -1)
     {
         // moving up
-        mGameObject->BroadcastMessage("move_up");
+        mGameObject->PostMessage("move_up");
     }
 
     glm::vec2 move(horizontal, vertical);
@@ -1,27 +1,157 @@
+// #define PROFILE_UPDATE
+// #define FRAME_ARENA_STATS
+// #define LOG_FRAME_STATS
+// #define LOG_FRAME_TIMING
+
 #include "core/Engine.hpp"
 #include "core/Component.hpp"
+#include "core/ControllerComponent.hpp"
 #include "core/GameObject.hpp"
 #include "core/IGraphicsEngineRenderer.hpp"
 #include "core/InputManager.hpp"
+#include "core/RectComponent.hpp"
 #include "core/RenderContext.hpp"
 #include "core/ResourceManager.hpp"
+#include "core/SpriteAnimator.hpp"
+#include "core/SpriteRenderer.hpp"
+#include "core/TilemapComponent.hpp"
+#include "core/TransformComponent.hpp"
 #include "core/UpdateContext.hpp"
+#include "core/collision/SpriteColliderComponent.hpp"
+#include "core/collision/TilemapColliderComponent.hpp"
+#include "core/resources/SceneData.hpp"
+#include "core/resources/SceneResources.hpp"
 
+#include <algorithm>
+#include <exception>
+#include <functional>
 #include <iterator>
 #include <map>
 #include <memory>
 #include <string>
 
+#ifdef PROFILE_UPDATE
+#include <chrono>
+#endif
+
 #if defined(LINUX) || defined(MINGW)
 #include <SDL2/SDL.h>
 #else  // This works for Mac
 #include <SDL.h>
 #endif
 
+namespace
+{
+double MsSince(Uint64 start)
+{
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+           SDL_GetPerformanceFrequency();
+}
+
+/**
+ * Create a component of a scene on its game object.
+ */
+void CreateSceneComponent(Engine& engine, GameObject& gameObject,
+                          const SceneData& scene,
+                          const SceneComponent& component,
+                          const SceneResources& resources)
+{
+    const std::vector<SceneResource>& sceneResources = scene.GetResources();
+    Size2D size((unsigned int)component.width,
+                (unsigned int)component.height);
+    switch (component.type)
+    {
+        case SceneComponentType::Tilemap:
+        {
+            std::shared_ptr<Spritesheet> spritesheet =
+                resources.GetSpritesheet(component.spritesheet);
+            TilemapComponent* tilemap =
+                engine.InstantiateComponent<TilemapComponent>(gameObject,
+                                                              spritesheet);
+            tilemap->SetDisplayTileSize(size);
+            tilemap->SetLayer(component.layer);
+            tilemap->GenerateMapFromFile(
+                scene.GetString(sceneResources[component.tilemap].fileLoc));
+            break;
+        }
+        case SceneComponentType::TilemapCollider:
+            engine.InstantiateComponent<TilemapColliderComponent>(gameObject);
+            break;
+        case SceneComponentType::Controller:
+        {
+            ControllerComponent* controller =
+                engine.InstantiateComponent<ControllerComponent>(gameObject);
+            if (component.speed != 0) controller->SetSpeed(component.speed);
+            break;
+        }
+        case SceneComponentType::Sprite:
+        {
+            SpriteRenderer* sprite =
+                engine.InstantiateComponent<SpriteRenderer>(gameObject);
+            sprite->UseSpritesheet(
+                resources.GetSpritesheet(component.spritesheet));
+            sprite->SetSize(size);
+            sprite->SetLayer(component.layer);
+            sprite->SetSpriteIndex(component.spriteIndex);
+            break;
+        }
+        case SceneComponentType::Animator:
+        {
+            SpriteAnimator* animator =
+                engine.InstantiateComponent<SpriteAnimator>(gameObject);
+            animator->UseSpritesheet(
+                resources.GetSpritesheet(component.spritesheet));
+            animator->SetSize(size);
+            animator->SetLayer(component.layer);
+            const std::vector<SceneAnimation>& animations =
+                scene.GetAnimations();
+            for (uint32_t i = 0; i < component.animationCount; ++i)
+            {
+                const SceneAnimation& animation =
+                    animations[component.firstAnimation + i];
+                animator->SetAnimation(scene.GetString(animation.name),
+                                       animation.spritesheetRow,
+                                       animation.frameCount,
+                                       animation.frameDuration);
+            }
+            break;
+        }
+        case SceneComponentType::SpriteCollider:
+        {
+            SpriteColliderComponent* collider =
+                engine.InstantiateComponent<SpriteColliderComponent>(
+                    gameObject);
+            if (component.flags & SceneComponent::FLAG_TRIGGER)
+            {
+                collider->SetIsTrigger(true);
+            }
+            break;
+        }
+        case SceneComponentType::Rect:
+        {
+            RectComponent* rect =
+                engine.InstantiateComponent<RectComponent>(gameObject);
+            rect->SetSize({component.width, component.height});
+            rect->SetColor(component.color[0], component.color[1],
+                           component.color[2], component.color[3]);
+            rect->SetLayer(component.layer);
+            break;
+        }
+    }
+}
+}  // namespace
+
 // Initialization function
 // Returns a true or false value based on successful completion of setup.
 // Takes in dimensions of window.
-Engine::Engine() {}
+Engine::Engine()
+{
+    mUpdateCtx.frameArena = &mFrameArena;
+    mRenderCtx.frameArena = &mFrameArena;
+    mRenderCtx.spriteBatch = &mSpriteBatch;
+    mRenderCtx.renderer = nullptr;
+    mRenderCtx.renderThread = nullptr;
+}
 
 // Proper shutdown and destroy initialized objects
 Engine::~Engine() {}
@@ -32,6 +162,8 @@ void Engine::Input(bool* quit)
     // Event handler that handles various events in SDL
     // that are related to input and output
     SDL_Event e;
+    // Presses and releases are relative to the last frame
+    if (mInput) mInput->BeginFrame();
     // Enable text input
     SDL_StartTextInput();
     // Handle events on queue
@@ -41,51 +173,304 @@ void Engine::Input(bool* quit)
         // An example is hitting the "x" in the corner of the window.
         if (e.type == SDL_QUIT)
             *quit = true;
+        // Textures that are render targets lose their contents on these,
+        // with Direct3D
+        else if (e.type == SDL_RENDER_TARGETS_RESET ||
+                 e.type == SDL_RENDER_DEVICE_RESET)
+            HandleRenderTargetsReset();
         else if (mInput)
             mInput->HandleEvent(e);
     }
 }
 
-void Engine::Update()
+void Engine::HandleRenderTargetsReset()
+{
+    std::cerr << "The renderer lost its render targets, redrawing them\n";
+    for (GameObject* pGO : mGameObjects)
+    {
+        for (Component* component : pGO->GetComponents())
+        {
+            component->HandleRenderTargetsReset();
+        }
+    }
+}
+
+unsigned int Engine::BuildUpdateSystems()
+{
+    for (UpdateSystem& system : mUpdateSystems)
+    {
+        system.components.clear();
+    }
+
+    for (GameObject* pGO : mGameObjects)
+    {
+        if (!pGO->IsActive()) continue;
+
+        for (Component* component : pGO->GetComponents())
+        {
+            std::type_index type(typeid(*component));
+            auto systemIt = mUpdateSystemIndex.find(type);
+            if (systemIt == mUpdateSystemIndex.end())
+            {
+                systemIt =
+                    mUpdateSystemIndex.emplace(type, mUpdateSystems.size())
+                        .first;
+                mUpdateSystems.emplace_back();
+                mUpdateSystems.back().access = component->GetAccess();
+            }
+            mUpdateSystems[systemIt->second].components.push_back(component);
+        }
+    }
+
+    // Moving a parent marks its children dirty, and children read their
+    // parent's position, so objects with a parent or children are not
+    // object-local even if their components are
+    for (UpdateSystem& system : mUpdateSystems)
+    {
+        if (!system.access.bObjectLocal) continue;
+
+        auto isAlone = [](const Component* component)
+        {
+            TransformComponent& transform =
+                component->GetGameObject()->GetTransform();
+            return !transform.GetParent() && transform.GetChildren().empty();
+        };
+        system.splitCount =
+            std::stable_partition(system.components.begin(),
+                                  system.components.end(), isAlone) -
+            system.components.begin();
+    }
+
+    // Each system runs one wave after the latest earlier system it conflicts
+    // with, which keeps the original ordering between conflicting systems.
+    unsigned int waveCount = 0;
+    for (size_t i = 0; i < mUpdateSystems.size(); ++i)
+    {
+        UpdateSystem& system = mUpdateSystems[i];
+        if (system.components.empty() || system.access.IsNone()) continue;
+
+        system.wave = 0;
+        for (size_t j = 0; j < i; ++j)
+        {
+            const UpdateSystem& earlier = mUpdateSystems[j];
+            if (earlier.components.empty() || earlier.access.IsNone())
+                continue;
+
+            if (system.access.ConflictsWith(earlier.access))
+                system.wave = std::max(system.wave, earlier.wave + 1);
+        }
+        waveCount = std::max(waveCount, system.wave + 1);
+    }
+
+    return waveCount;
+}
+
+void Engine::Update(float deltaTime)
 {
+    // Everything allocated during the previous frame is now garbage
+    mFrameArena.Reset();
+#ifdef FRAME_ARENA_STATS
+    std::cout << "Frame " << mRenderCtx.frameIdx - 1 << " arena usage: "
+              << mFrameArena.GetLastFrameUsage() << "/"
+              << mFrameArena.GetCapacity() << " bytes";
+    if (mFrameArena.GetLastFrameUsage() > mFrameArena.GetCapacity())
+        std::cout << " (overflowed to heap)";
+    std::cout << ", peak " << mFrameArena.GetPeakUsage() << " bytes\n";
+#endif
+
+    mUpdateCtx.deltaTime = deltaTime;
+
+#ifdef PROFILE_UPDATE
+    auto updateStart = std::chrono::steady_clock::now();
+#endif
+
+    RebuildSpatialGrid();
+
+    unsigned int waveCount = BuildUpdateSystems();
+    unsigned int threadCount = mJobs ? mJobs->GetWorkerCount() + 1 : 1;
+
+    std::vector<std::function<void()>> tasks;
+    for (unsigned int wave = 0; wave < waveCount; ++wave)
+    {
+        tasks.clear();
+        for (UpdateSystem& system : mUpdateSystems)
+        {
+            if (system.components.empty() || system.access.IsNone()) continue;
+            if (system.wave != wave) continue;
+
+            auto addRange = [this, &system, &tasks](size_t begin, size_t end)
+            {
+                tasks.push_back(
+                    [this, &system, begin, end]()
+                    {
+                        for (size_t i = begin; i < end; ++i)
+                        {
+                            Component* component = system.components[i];
+                            // A previous system may have deactivated it
+                            if (!component->GetGameObject()->IsActive())
+                                continue;
+                            component->Update(&mUpdateCtx);
+                        }
+                    });
+            };
+
+            // Object-local systems are split into one range per thread,
+            // except for the components in a transform hierarchy
+            size_t count = system.components.size();
+            size_t splitCount =
+                system.access.bObjectLocal ? system.splitCount : 0;
+            size_t rangeSize = std::max<size_t>(
+                1, (splitCount + threadCount - 1) / threadCount);
+            for (size_t begin = 0; begin < splitCount; begin += rangeSize)
+            {
+                addRange(begin, std::min(splitCount, begin + rangeSize));
+            }
+            if (splitCount < count) addRange(splitCount, count);
+        }
+
+        if (mJobs)
+        {
+            mJobs->RunAll(tasks);
+        }
+        else
+        {
+            for (std::function<void()>& task : tasks) task();
+        }
+    }
+
+    // Nothing updates in parallel anymore, so messages posted during the
+    // update can reach any component
     for (GameObject* pGO : mGameObjects)
     {
+        pGO->DeliverPostedMessages();
+    }
+
+    // Refresh cached world positions of anything that moved this frame
+    mTransformHierarchy.Propagate();
+
+#ifdef PROFILE_UPDATE
+    static double totalMs = 0;
+    static int frames = 0;
+    totalMs += std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - updateStart)
+                   .count();
+    if (++frames == 300)
+    {
+        std::cout << "Update: " << totalMs / frames << "ms avg over " << frames
+                  << " frames with " << threadCount << " thread(s)\n";
+        totalMs = 0;
+        frames = 0;
+    }
+#endif
+}
+
+void Engine::RebuildSpatialGrid()
+{
+    mSpatialGrid.Clear();
+    mMovingObjects.clear();
+    mGridObjectCount = mGameObjects.size();
+
+    FRect bounds({0, 0}, {0, 0});
+    for (unsigned int i = 0; i < mGameObjects.size(); ++i)
+    {
+        GameObject* pGO = mGameObjects[i];
         if (!pGO->IsActive()) continue;
-        pGO->Update(&mUpdateCtx);
+
+        // Its bounds now may not be where it ends up this frame
+        if (CanMove(pGO))
+            mMovingObjects.push_back(i);
+        else if (pGO->GetBounds(&bounds))
+            mSpatialGrid.Insert(i, bounds);
+        else
+            mSpatialGrid.InsertUnbounded(i);
+    }
+}
+
+bool Engine::CanMove(GameObject* pGO)
+{
+    static const ComponentMask transformMask = ComponentTypeMask("transform");
+
+    for (; pGO; pGO = pGO->GetParent())
+    {
+        for (Component* component : pGO->GetComponents())
+        {
+            if (component->GetAccess().writes & transformMask) return true;
+        }
     }
+    return false;
+}
+
+template <typename Allocator>
+void Engine::QueryObjects(const FRect& rect,
+                          std::vector<unsigned int, Allocator>& out) const
+{
+    mSpatialGrid.Query(rect, out);
+    size_t gridCount = out.size();
+
+    FRect bounds({0, 0}, {0, 0});
+    auto addIfOverlaps = [this, &rect, &bounds, &out](unsigned int i)
+    {
+        GameObject* pGO = mGameObjects[i];
+        if (!pGO->IsActive()) return;
+        if (!pGO->GetBounds(&bounds) || HasIntersection(bounds, rect))
+            out.push_back(i);
+    };
+    for (unsigned int i : mMovingObjects) addIfOverlaps(i);
+    for (size_t i = mGridObjectCount; i < mGameObjects.size(); ++i)
+        addIfOverlaps(i);
+
+    if (out.size() > gridCount) std::sort(out.begin(), out.end());
 }
 
 void Engine::Render()
 {
-    // Set the color of the empty framebuffer
-    mRenderer->SetRenderDrawColor(0, 0, 0, 0xFF);
-    // Clear the screen to the color of the empty framebuffer
-    mRenderer->RenderClear();
-
-    // NOTE: We have to dynamic_cast here, because we do not exactly know the
-    // type
-    //       of the renderer that is going to 'render' our character.
-    //       Polymorphism is being used for our renderer, and we need to thus
-    //       determine using dynamic_cast if we can make a successful cast to
-    //       find a matching member function that can retrieve a 'renderer'
-    //       suitable.
-    // NOTE: The very fact that I am storing an SDL_Renderer* below completely
-    //       defeats the purpose of using the dynamic_cast.
-    //       The whole point of the dynamic_cast is so that at run-time we can
-    //       retrieve a renderer to draw our characters. That said, it's just
-    //       more readable for you to see the dynamic cast here.
-    // NOTE: If dynamic_cast fails, you can check at run-time and handle through
-    // either an
-    //       assertion or exception the behavior.
-    SDL_Renderer* renderer =
-        dynamic_cast<SDLGraphicsEngineRenderer*>(mRenderer)->GetRenderer();
+    SDL_Renderer* renderer = mRenderer->GetRenderer();
 
     mRenderCtx.renderer = renderer;
     mRenderCtx.worldToCamera = mUpdateCtx.cameraCenter - mScreenCenter;
+    mRenderCtx.screenSize = mScreenSize;
 
-    // Render each of the character(s)
-    for (GameObject* pGO : mGameObjects)
+    // Upload some of the textures that finished loading in the background
+    if (ResourceManager::instance().HasPendingLoads())
+    {
+        double budgetMs = mLoadBudgetMs;
+        mRenderCtx.RunOnRenderer(
+            [budgetMs](SDL_Renderer*)
+            { ResourceManager::instance().ProcessUploads(budgetMs); });
+    }
+    // Nothing is recorded yet, and the frame in flight is done by the time
+    // the renderer runs this
+    TextureLoader* textures = ResourceManager::instance().Textures();
+    if (textures->HasRetiredTextures())
+    {
+        mRenderCtx.RunOnRenderer([textures](SDL_Renderer*)
+                                 { textures->DestroyRetiredTextures(); });
+    }
+    int frameIdx = mRenderCtx.frameIdx;
+    if (ResourceManager::instance().ShouldEvictTextures(frameIdx))
     {
+        mRenderCtx.RunOnRenderer(
+            [frameIdx](SDL_Renderer*)
+            { ResourceManager::instance().EvictTextures(frameIdx); });
+    }
+
+    // The other buffer may still be drawing on the render thread
+    render::CommandBuffer& commands = mCommandBuffers[mRecordingBuffer];
+    commands.Clear();
+    // Set the color of the empty framebuffer
+    commands.clearColor = {0, 0, 0, 0xFF};
+    mSpriteBatch.SetTarget(&commands);
+    mRenderCtx.stats = &commands.stats;
+
+    // Render each of the character(s) that can be seen, in scene order
+    QueryObjects(mRenderCtx.GetViewRect(), mVisibleObjects);
+    commands.stats.culledObjects =
+        mSpatialGrid.GetBoundedCount() + mSpatialGrid.GetUnboundedCount() +
+        mMovingObjects.size() + (mGameObjects.size() - mGridObjectCount) -
+        mVisibleObjects.size();
+    for (unsigned int objectIdx : mVisibleObjects)
+    {
+        GameObject* pGO = mGameObjects[objectIdx];
         if (!pGO->IsActive()) continue;
         pGO->Render(&mRenderCtx);
     }
@@ -103,16 +488,48 @@ void Engine::Render()
     }
 #endif
 
-    // Flip the buffer to render
-    mRenderer->RenderPresent();
+    if (mRenderThread)
+    {
+        // Draw this frame while the next one is updated
+        mFrameStats = mRenderThread->Submit(&commands);
+        mRecordingBuffer = 1 - mRecordingBuffer;
+    }
+    else
+    {
+        // Draw everything in as few batches as possible, then flip the buffer
+        commands.Execute(mRenderer->DiscardsDraws() ? nullptr : renderer);
+        mRenderer->RenderPresent();
+        mFrameStats = commands.stats;
+    }
+
+#ifdef LOG_FRAME_STATS
+    if (mRenderCtx.frameIdx % 300 == 0)
+    {
+        std::cout << "Frame " << mRenderCtx.frameIdx << ": "
+                  << mFrameStats.quads << " quads in "
+                  << mFrameStats.drawCalls << " draw calls (avg batch "
+                  << mFrameStats.AverageBatchSize() << ", largest "
+                  << mFrameStats.largestBatch << "), culled "
+                  << mFrameStats.culledObjects << " objects and "
+                  << mFrameStats.culledTiles << " tiles, "
+                  << ResourceManager::instance().Textures()->GetMemoryUsage()
+                  << " bytes of textures\n";
+    }
+#endif
 }
 
 // check if colliding
 bool Engine::IsColliding(ColliderComponent* collider, FRect* rectangle)
 {
-    // loop through gameobjects
-    for (GameObject* object : mGameObjects)
+    // Called by many components each frame, so the results are scratch
+    std::vector<unsigned int, util::FrameAllocator<unsigned int>>
+        nearbyObjects(&mFrameArena);
+    QueryObjects(*rectangle, nearbyObjects);
+
+    // loop through nearby gameobjects
+    for (unsigned int objectIdx : nearbyObjects)
     {
+        GameObject* object = mGameObjects[objectIdx];
         if (!object->IsActive()) continue;
 
         if (object->IsColliding(collider, rectangle))
@@ -130,22 +547,60 @@ void Engine::RunGameLoop()
     // If this is quit = 'true' then the program terminates.
     bool quit = false;
     int frameIdx = 0;
+    Uint64 loopStart = SDL_GetPerformanceCounter();
     // While application is running
     while (!quit)
     {
+        // Wait for the next frame, measuring how long the last one took
+        float deltaTime = mFramePacer.WaitForNextFrame();
+        // Swap in assets that changed on the disk, between frames
+        ResourceManager& resources = ResourceManager::instance();
+        resources.PollReloads();
+        if (resources.HasReloads())
+        {
+            mRenderCtx.RunOnRenderer([&resources](SDL_Renderer*)
+                                     { resources.ApplyReloads(); });
+        }
+        // Load the next scene in the background, and switch to it once the
+        // frame that asked is over
+        mRenderCtx.frameIdx = frameIdx;
+        if (mPrefetch) UpdatePrefetch(frameIdx);
+        if (mbSwitchScene)
+        {
+            mbSwitchScene = false;
+            SwitchScene();
+        }
         // Get user input
         Input(&quit);
-        // If you have time, implement your frame capping code here
-        // Otherwise, this is a cheap hack for this lab.
-        SDL_Delay(16);
         // Update our scene with the context
-        mUpdateCtx.deltaTime = 0.016f;
-        Update();
+        Update(deltaTime);
         // Render using OpenGL
         mRenderCtx.frameIdx = frameIdx;
         Render();
         frameIdx++;
+        if (mFrameLimit != 0 && frameIdx >= mFrameLimit) quit = true;
+#ifdef LOG_FRAME_TIMING
+        if (frameIdx % util::FramePacer::HISTORY_SIZE == 0)
+        {
+            util::FrameTiming average = mFramePacer.GetAverage();
+            std::cout << "Frame time: " << average.frameTime * 1000
+                      << "ms avg (" << average.workTime * 1000
+                      << "ms working), " << mFramePacer.GetJitter() * 1000
+                      << "ms jitter, "
+                      << mFramePacer.GetLongestFrameTime() * 1000
+                      << "ms longest\n";
+        }
+#endif
+    }
+
+    if (mFrameLimit != 0)
+    {
+        double seconds = (double)(SDL_GetPerformanceCounter() - loopStart) /
+                         SDL_GetPerformanceFrequency();
+        std::cout << "Ran " << frameIdx << " frames in " << seconds << "s ("
+                  << seconds * 1000 / frameIdx << "ms per frame)\n";
     }
+
     // Disable text input
     SDL_StopTextInput();
 }
@@ -162,24 +617,44 @@ void Engine::Startup()
         std::cout << "No Graphics Subsystem initialized\n";
     }
 
-    SDLGraphicsEngineRenderer* graphicsEngine =
-        dynamic_cast<SDLGraphicsEngineRenderer*>(mRenderer);
-    SDL_Renderer* renderer = graphicsEngine->GetRenderer();
-    ResourceManager::instance().Startup(renderer);
+    mRenderCtx.renderer = mRenderer->GetRenderer();
+    ResourceManager::instance().Startup(mRenderer->GetRenderer());
 
-    if (mInput)
+    // Headless renderers have no window to take input from
+    if (mInput && mRenderer->GetWindow())
     {
-        Uint32 windowId = SDL_GetWindowID(graphicsEngine->GetWindow());
+        Uint32 windowId = SDL_GetWindowID(mRenderer->GetWindow());
         mInput->SetMainWindow(windowId);
     }
 }
 
 void Engine::Shutdown()
 {
-    // Destroy all game objects
+    // Destroy all game objects, then the resources of their scenes. Their
+    // textures are destroyed on the renderer, after the last frame is drawn.
+    UnloadLevel();
+    mRenderCtx.RunOnRenderer([this](SDL_Renderer*)
+                             { mPersistentArena.Reset(); });
     mGameObjects.clear();
+    CancelPrefetch();
+    mRenderCtx.RunOnRenderer(
+        [this](SDL_Renderer*)
+        {
+            for (SceneResources* resources : mSceneResources)
+            {
+                delete resources;
+            }
+            ResourceManager::instance().Shutdown();
+        });
+    mSceneResources.clear();
 
-    ResourceManager::instance().Shutdown();
+    // Destroys the renderer it created
+    if (nullptr != mRenderThread)
+    {
+        delete mRenderThread;
+        mRenderThread = nullptr;
+        mRenderCtx.renderThread = nullptr;
+    }
 
     // Shut down our Graphics Subsystem
     if (nullptr != mRenderer)
@@ -192,14 +667,21 @@ void Engine::Shutdown()
     {
         delete mInput;
     }
+
+    // Shut down our worker threads
+    if (nullptr != mJobs)
+    {
+        delete mJobs;
+    }
 }
 
-void Engine::InitializeGraphicsSubSystem()
+void Engine::InitializeGraphicsSubSystem(bool bRenderThread)
 {
     // Setup our Renderer
     mScreenSize = glm::vec2(1280, 720);
     mScreenCenter = mScreenSize * 0.5f;
-    mRenderer = new SDLGraphicsEngineRenderer(mScreenSize.x, mScreenSize.y);
+    mRenderer = new SDLGraphicsEngineRenderer(mScreenSize.x, mScreenSize.y,
+                                              bRenderThread);
     if (nullptr == mRenderer)
     {
         exit(1);  // Terminate program if renderer
@@ -209,6 +691,42 @@ void Engine::InitializeGraphicsSubSystem()
                   //                    reinitialize the engine
                   //                    with a different render
     }
+    if (bRenderThread) StartRenderThread();
+}
+
+void Engine::InitializeHeadlessGraphicsSubSystem(bool discardDraws,
+                                                 bool bRenderThread)
+{
+    mScreenSize = glm::vec2(1280, 720);
+    mScreenCenter = mScreenSize * 0.5f;
+    mRenderer = new HeadlessGraphicsEngineRenderer(
+        mScreenSize.x, mScreenSize.y, discardDraws, bRenderThread);
+    // There is no display to wait for
+    mFramePacer.SetTargetFrameRate(0);
+    if (bRenderThread) StartRenderThread();
+}
+
+void Engine::SetTargetFrameRate(double framesPerSecond)
+{
+    mFramePacer.SetTargetFrameRate(framesPerSecond);
+}
+
+void Engine::SetVSync(bool bEnabled, double fallbackFrameRate)
+{
+    bool bVSync = false;
+    if (mRenderer)
+    {
+        IGraphicsEngineRenderer* renderer = mRenderer;
+        mRenderCtx.RunOnRenderer(
+            [renderer, bEnabled, &bVSync](SDL_Renderer*)
+            {
+                bVSync = bEnabled && renderer->SetVSync(true);
+                if (!bVSync) renderer->SetVSync(false);
+            });
+    }
+
+    // Presenting already waits for the display
+    mFramePacer.SetTargetFrameRate(bVSync ? 0 : fallbackFrameRate);
 }
 
 InputState* Engine::InitializeInputSystem()
@@ -218,8 +736,295 @@ InputState* Engine::InitializeInputSystem()
     return mInput;
 }
 
-GameObject& Engine::InstantiateGameObject()
+void Engine::InitializeJobSystem(unsigned int workerCount)
+{
+    std::cout << "Starting " << workerCount << " worker thread(s)\n";
+    mJobs = new util::ThreadPool(workerCount);
+}
+
+void Engine::StartRenderThread()
+{
+    std::cout << "Starting render thread\n";
+    mRenderThread = new render::RenderThread(mRenderer);
+    if (mRenderer->GetRenderer())
+    {
+        mRenderCtx.renderThread = mRenderThread;
+        return;
+    }
+
+    std::cerr << "Could not create the renderer on the render thread, "
+                 "drawing on the main thread\n";
+    delete mRenderThread;
+    mRenderThread = nullptr;
+    if (!mRenderer->CreateRenderer())
+    {
+        exit(1);
+    }
+}
+
+void Engine::WaitForLoads()
+{
+    ResourceManager& resources = ResourceManager::instance();
+    while (resources.HasPendingLoads())
+    {
+        resources.WaitForDecodes();
+        mRenderCtx.RunOnRenderer([&resources](SDL_Renderer*)
+                                 { resources.ProcessUploads(-1); });
+    }
+}
+
+GameObject& Engine::InstantiateGameObject(Scope scope)
 {
-    mGameObjects.push_back(new GameObject(this));
+    util::ScopeArena& arena = GetArena(scope);
+    mGameObjects.push_back(arena.New<GameObject>(this, &arena));
     return *mGameObjects.back();
 }
+
+void Engine::UnloadLevel()
+{
+    // Nothing may point into the level arena once it is reset, so the level
+    // objects are forgotten first. The persistent ones keep their order
+    util::ScopeArena* persistent = &mPersistentArena;
+    auto inLevel = [persistent](const GameObject* pGO)
+    { return pGO->GetArena() != persistent; };
+    mGameObjects.erase(
+        std::remove_if(mGameObjects.begin(), mGameObjects.end(), inLevel),
+        mGameObjects.end());
+    mSpatialGrid.Clear();
+    mMovingObjects.clear();
+    mGridObjectCount = 0;
+    mVisibleObjects.clear();
+    for (UpdateSystem& system : mUpdateSystems)
+    {
+        system.components.clear();
+    }
+    // Only the layers the scene turned on, others may be used by persistent
+    // objects
+    for (int layer : mSceneYSortedLayers)
+    {
+        mSpriteBatch.SetLayerYSorted(layer, false);
+    }
+    mSceneYSortedLayers.clear();
+
+    // Dropping every level transform at once spares each game object a
+    // search of the whole hierarchy
+    mTransformHierarchy.RemoveScope(&mLevelArena);
+    mRenderCtx.RunOnRenderer([this](SDL_Renderer*) { mLevelArena.Reset(); });
+}
+
+int Engine::LoadScene(const std::string& fileLoc, SceneLoadTimes* out_times)
+{
+    SceneLoadTimes times;
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    SceneResources* resources = nullptr;
+    try
+    {
+        resources = new SceneResources(fileLoc);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Could not load scene '" << fileLoc << "': " << e.what()
+                  << "\n";
+        return -1;
+    }
+    times.readMs = MsSince(start);
+
+    // Spritesheets are decoded and tilemaps read on the load workers, all
+    // at once
+    Uint64 phaseStart = SDL_GetPerformanceCounter();
+    FinishSceneLoads(*resources);
+    if (!resources->GetError().empty())
+    {
+        std::cerr << "Could not load scene '" << fileLoc
+                  << "': " << resources->GetError() << "\n";
+        mRenderCtx.RunOnRenderer([resources](SDL_Renderer*)
+                                 { delete resources; });
+        return -1;
+    }
+    times.resourcesMs = MsSince(phaseStart);
+
+    phaseStart = SDL_GetPerformanceCounter();
+    InstantiateScene(*resources);
+    mSceneResources.push_back(resources);
+    times.instantiateMs = MsSince(phaseStart);
+    times.totalMs = MsSince(start);
+
+    const SceneData& scene = resources->GetScene();
+    std::cout << "Loaded scene '" << fileLoc << "' ("
+              << scene.GetObjects().size() << " objects, "
+              << scene.GetComponents().size() << " components) in "
+              << times.totalMs << "ms: read " << times.readMs
+              << "ms, resources " << times.resourcesMs << "ms, instantiate "
+              << times.instantiateMs << "ms\n";
+    if (out_times) *out_times = times;
+    return 0;
+}
+
+int Engine::PrefetchScene(const std::string& fileLoc, size_t memoryCap)
+{
+    CancelPrefetch();
+    try
+    {
+        mPrefetch = new SceneResources(fileLoc, memoryCap);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Could not prefetch scene '" << fileLoc
+                  << "': " << e.what() << "\n";
+        return -1;
+    }
+    mbPrefetchPacked = false;
+    return 0;
+}
+
+bool Engine::IsScenePrefetched() const
+{
+    return mPrefetch && mPrefetch->IsDone() && mPrefetch->GetError().empty();
+}
+
+void Engine::UpdatePrefetch(int frameIdx)
+{
+    mPrefetch->Update(frameIdx);
+    if (!mPrefetch->IsDone() || mbPrefetchPacked) return;
+
+    if (!mPrefetch->GetError().empty())
+    {
+        std::cerr << "Could not prefetch scene '" << mPrefetch->GetSceneLoc()
+                  << "': " << mPrefetch->GetError() << "\n";
+        CancelPrefetch();
+        return;
+    }
+    // Packed now rather than when switching, to keep the switch short
+    PackSpritesheets();
+    mbPrefetchPacked = true;
+}
+
+void Engine::PackSpritesheets()
+{
+    mRenderCtx.RunOnRenderer(
+        [](SDL_Renderer*) { ResourceManager::instance().PackSpritesheets(); });
+}
+
+void Engine::CancelPrefetch()
+{
+    if (!mPrefetch) return;
+
+    SceneResources* prefetch = mPrefetch;
+    mRenderCtx.RunOnRenderer([prefetch](SDL_Renderer*) { delete prefetch; });
+    mPrefetch = nullptr;
+}
+
+int Engine::SwitchScene(SceneLoadTimes* out_times)
+{
+    if (!mPrefetch)
+    {
+        std::cerr << "There is no prefetched scene to switch to\n";
+        return -1;
+    }
+
+    SceneLoadTimes times;
+    Uint64 start = SDL_GetPerformanceCounter();
+    std::string fileLoc = mPrefetch->GetSceneLoc();
+
+    // Load whatever the memory cap held back; the old scene keeps playing if
+    // something cannot be
+    FinishSceneLoads(*mPrefetch);
+    if (!mPrefetch->GetError().empty())
+    {
+        std::cerr << "Could not switch to scene '" << fileLoc
+                  << "': " << mPrefetch->GetError() << "\n";
+        CancelPrefetch();
+        return -1;
+    }
+    times.resourcesMs = MsSince(start);
+
+    // Objects go first, since they hold on to the resources of their scene
+    Uint64 phaseStart = SDL_GetPerformanceCounter();
+    UnloadLevel();
+    mRenderCtx.RunOnRenderer(
+        [this](SDL_Renderer*)
+        {
+            for (SceneResources* resources : mSceneResources)
+            {
+                delete resources;
+            }
+        });
+    mSceneResources.clear();
+    times.unloadMs = MsSince(phaseStart);
+
+    phaseStart = SDL_GetPerformanceCounter();
+    InstantiateScene(*mPrefetch);
+    mSceneResources.push_back(mPrefetch);
+    mPrefetch = nullptr;
+    times.instantiateMs = MsSince(phaseStart);
+    times.totalMs = MsSince(start);
+
+    std::cout << "Switched to scene '" << fileLoc << "' in " << times.totalMs
+              << "ms: resources " << times.resourcesMs << "ms, unload "
+              << times.unloadMs << "ms, instantiate " << times.instantiateMs
+              << "ms\n";
+    if (out_times) *out_times = times;
+    return 0;
+}
+
+void Engine::FinishSceneLoads(SceneResources& resources)
+{
+    while (true)
+    {
+        resources.Update(mRenderCtx.frameIdx, true);
+        if (resources.IsDone()) break;
+        WaitForLoads();
+    }
+}
+
+void Engine::InstantiateScene(const SceneResources& resources)
+{
+    const SceneData& scene = resources.GetScene();
+    const std::vector<SceneResource>& sceneResources = scene.GetResources();
+    for (uint32_t i = 0; i < sceneResources.size(); ++i)
+    {
+        const SceneResource& resource = sceneResources[i];
+        if (resource.type != SceneResourceType::Spritesheet ||
+            resource.spriteWidth == 0 || resource.spriteHeight == 0)
+        {
+            continue;
+        }
+        resources.GetSpritesheet(i)->SetSpriteSize(
+            {resource.spriteWidth, resource.spriteHeight});
+    }
+
+    for (int32_t layer : scene.GetYSortedLayers())
+    {
+        // Layers that were already sorted stay sorted after the level
+        if (mSpriteBatch.IsLayerYSorted(layer)) continue;
+        SetLayerYSorted(layer, true);
+        mSceneYSortedLayers.push_back(layer);
+    }
+
+    // Create every object and its components, then parent them, since
+    // parenting keeps the world position of the child
+    const std::vector<SceneObject>& objects = scene.GetObjects();
+    const std::vector<SceneComponent>& components = scene.GetComponents();
+    size_t firstObject = mGameObjects.size();
+    mGameObjects.reserve(firstObject + objects.size());
+    for (const SceneObject& object : objects)
+    {
+        GameObject& gameObject = InstantiateGameObject();
+        gameObject.GetTransform().SetPosition(object.x, object.y);
+        gameObject.ReserveComponents(object.componentCount);
+        for (uint32_t i = 0; i < object.componentCount; ++i)
+        {
+            CreateSceneComponent(*this, gameObject, scene,
+                                 components[object.firstComponent + i],
+                                 resources);
+        }
+    }
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        if (objects[i].parent == SceneObject::NO_PARENT) continue;
+        mGameObjects[firstObject + i]->SetParent(
+            mGameObjects[firstObject + objects[i].parent]);
+    }
+}
+
@@ -1,4 +1,9 @@
+#include <mutex>
+#include <shared_mutex>
 #include <stdexcept>
+#include <unordered_set>
+
+#include <glm/common.hpp>
 
 #include "core/Engine.hpp"
 #include "core/GameObject.hpp"
@@ -11,16 +16,30 @@
 #include "core/util/Gizmos.hpp"
 #endif
 
-GameObject::GameObject(Engine* engine) : mEngine(engine)
+GameObject::GameObject(Engine* engine, util::ScopeArena* arena)
+    : mEngine(engine), mArena(arena), mComponents(arena)
 {
-    mTransform = new TransformComponent();
+    if (mArena)
+    {
+        mTransform = new (mArena->Allocate(sizeof(TransformComponent),
+                                           alignof(TransformComponent)))
+            TransformComponent();
+    }
+    else
+    {
+        mTransform = new TransformComponent();
+    }
+    mTransform->mGameObject = this;
+    if (mEngine) mEngine->GetTransformHierarchy().Add(mTransform);
 }
 GameObject::GameObject(GameObject&& from) noexcept
 {
     mEngine = from.mEngine;
     from.mEngine = nullptr;
+    mArena = from.mArena;
     mTransform = from.mTransform;
     from.mTransform = nullptr;
+    if (mTransform) mTransform->mGameObject = this;
     mComponents = std::move(from.mComponents);
     for (Component* component : mComponents)
     {
@@ -32,15 +51,25 @@ GameObject::~GameObject()
 {
     for (Component* pC : mComponents)
     {
-        delete pC;
+        DestroyComponent(pC);
     }
 
     if (mTransform)
     {
-        delete mTransform;
+        if (mEngine) mEngine->GetTransformHierarchy().Remove(mTransform);
+        DestroyComponent(mTransform);
     }
 }
 
+void GameObject::DestroyComponent(Component* component)
+{
+    // The arena frees the memory when it is reset
+    if (mArena)
+        component->~Component();
+    else
+        delete component;
+}
+
 void GameObject::Update(UpdateContext* update)
 {
     for (Component* component : mComponents)
@@ -139,6 +168,41 @@ Component* GameObject::GetComponent(const std::string& typeName)
 
 TransformComponent& GameObject::GetTransform() { return *mTransform; }
 
+void GameObject::SetParent(GameObject* parent)
+{
+    mTransform->SetParent(parent ? parent->mTransform : nullptr);
+    if (mEngine) mEngine->GetTransformHierarchy().MarkOrderDirty();
+}
+
+GameObject* GameObject::GetParent() const
+{
+    TransformComponent* parent = mTransform->GetParent();
+    return parent ? parent->GetGameObject() : nullptr;
+}
+
+bool GameObject::GetBounds(FRect* bounds)
+{
+    bool hasBounds = false;
+    FRect componentBounds({0, 0}, {0, 0});
+    for (Component* component : mComponents)
+    {
+        if (!component->GetBounds(&componentBounds)) continue;
+
+        if (!hasBounds)
+        {
+            *bounds = componentBounds;
+            hasBounds = true;
+            continue;
+        }
+
+        glm::vec2 min = glm::min(bounds->pos, componentBounds.pos);
+        glm::vec2 max = glm::max(bounds->pos + bounds->size,
+                                 componentBounds.pos + componentBounds.size);
+        *bounds = FRect(min, max - min);
+    }
+    return hasBounds;
+}
+
 void GameObject::BroadcastMessage(const std::string& message) const
 {
     for (Component* c : mComponents)
@@ -146,3 +210,31 @@ void GameObject::BroadcastMessage(const std::string& message) const
         c->Receive(message);
     }
 }
+
+void GameObject::DeliverPostedMessages()
+{
+    if (mPostedMessages.empty()) return;
+
+    mDeliveredMessages.swap(mPostedMessages);
+    for (const std::string* message : mDeliveredMessages)
+    {
+        BroadcastMessage(*message);
+    }
+    mDeliveredMessages.clear();
+}
+
+const std::string* GameObject::InternMessage(const std::string& message)
+{
+    // Messages are posted from update threads, and almost always found
+    static std::shared_mutex mutex;
+    static std::unordered_set<std::string> messages;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto found = messages.find(message);
+        if (found != messages.end()) return &*found;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    // Elements of an unordered_set do not move when it grows
+    return &*messages.insert(message).first;
+}
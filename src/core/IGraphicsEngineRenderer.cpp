@@ -12,10 +12,92 @@
 
 // ...
 
+///////////////////////////////////////////////////////////////////
+/// HeadlessGraphicsEngineRenderer Implementation
+//////////////////////////////////////////////////////////////////
+HeadlessGraphicsEngineRenderer::HeadlessGraphicsEngineRenderer(
+    int w, int h, bool discardDraws, bool bDeferRenderer)
+    : IGraphicsEngineRenderer(w, h), mbDiscardDraws(discardDraws)
+{
+    // Initialize random number generation.
+    srand(time(nullptr));
+
+    // Only events are needed, there is no display to open
+    if (SDL_Init(SDL_INIT_EVENTS) < 0)
+    {
+        std::cerr << "SDL could not initialize! SDL Error: " << SDL_GetError()
+                  << "\n";
+        exit(1);
+    }
+
+    mSurface = SDL_CreateRGBSurfaceWithFormat(0, mScreenWidth, mScreenHeight,
+                                              32, SDL_PIXELFORMAT_RGBA32);
+    if (nullptr == mSurface)
+    {
+        std::cerr << "Offscreen surface could not be created! SDL Error: "
+                  << SDL_GetError() << "\n";
+        exit(1);
+    }
+
+    if (!bDeferRenderer && !CreateRenderer())
+    {
+        exit(1);
+    }
+
+    std::cout << "Running headless"
+              << (mbDiscardDraws ? ", discarding draws" : "") << "\n\n";
+}
+
+HeadlessGraphicsEngineRenderer::~HeadlessGraphicsEngineRenderer()
+{
+    DestroyRenderer();
+    SDL_FreeSurface(mSurface);
+    mSurface = nullptr;
+
+    SDL_Quit();
+}
+
+bool HeadlessGraphicsEngineRenderer::CreateRenderer()
+{
+    mRenderer = SDL_CreateSoftwareRenderer(mSurface);
+    if (nullptr == mRenderer)
+    {
+        std::cerr << "Renderer could not be created! SDL Error: "
+                  << SDL_GetError() << "\n";
+        return false;
+    }
+    return true;
+}
+
+void HeadlessGraphicsEngineRenderer::DestroyRenderer()
+{
+    if (nullptr == mRenderer) return;
+    SDL_DestroyRenderer(mRenderer);
+    mRenderer = nullptr;
+}
+
+void HeadlessGraphicsEngineRenderer::SetRenderDrawColor(int r, int g, int b,
+                                                        int a)
+{
+    SDL_SetRenderDrawColor(mRenderer, r, g, b, a);
+}
+
+void HeadlessGraphicsEngineRenderer::RenderClear()
+{
+    if (!mbDiscardDraws) SDL_RenderClear(mRenderer);
+}
+
+void HeadlessGraphicsEngineRenderer::RenderPresent()
+{
+    // The frame is already in the surface
+    if (!mbDiscardDraws) SDL_RenderPresent(mRenderer);
+}
+
 ///////////////////////////////////////////////////////////////////
 /// SDLGraphicsEngineRenderer Implementation
 //////////////////////////////////////////////////////////////////
-SDLGraphicsEngineRenderer::SDLGraphicsEngineRenderer(int w, int h)
+SDLGraphicsEngineRenderer::SDLGraphicsEngineRenderer(int w, int h,
+                                                     bool bDeferRenderer)
     : IGraphicsEngineRenderer(w, h)
 {
     // Initialize random number generation.
@@ -42,14 +124,9 @@ SDLGraphicsEngineRenderer::SDLGraphicsEngineRenderer(int w, int h)
         exit(1);
     }
 
-    // Create a Renderer to draw on
-    mRenderer = SDL_CreateRenderer(mWindow, -1, SDL_RENDERER_ACCELERATED);
-
-    // Check if Renderer did not create.
-    if (nullptr == mRenderer)
+    // Create a Renderer to draw on, unless the thread that draws does
+    if (!bDeferRenderer && !CreateRenderer())
     {
-        std::cerr << "Renderer could not be created! SDL Error: "
-                  << SDL_GetError() << "\n";
         exit(1);
     }
 
@@ -59,17 +136,37 @@ SDLGraphicsEngineRenderer::SDLGraphicsEngineRenderer(int w, int h)
 
 SDLGraphicsEngineRenderer::~SDLGraphicsEngineRenderer()
 {
-    // Destroy Renderer
-    SDL_DestroyRenderer(mRenderer);
+    // Destroy Renderer, if its thread did not already
+    DestroyRenderer();
     // Destroy window
     SDL_DestroyWindow(mWindow);
-    mRenderer = nullptr;
     mWindow = nullptr;
 
     // Quit SDL subsystems
     SDL_Quit();
 }
 
+bool SDLGraphicsEngineRenderer::CreateRenderer()
+{
+    mRenderer = SDL_CreateRenderer(mWindow, -1, SDL_RENDERER_ACCELERATED);
+
+    // Check if Renderer did not create.
+    if (nullptr == mRenderer)
+    {
+        std::cerr << "Renderer could not be created! SDL Error: "
+                  << SDL_GetError() << "\n";
+        return false;
+    }
+    return true;
+}
+
+void SDLGraphicsEngineRenderer::DestroyRenderer()
+{
+    if (nullptr == mRenderer) return;
+    SDL_DestroyRenderer(mRenderer);
+    mRenderer = nullptr;
+}
+
 void SDLGraphicsEngineRenderer::SetRenderDrawColor(int r, int g, int b, int a)
 {
     SDL_SetRenderDrawColor(mRenderer, r, g, b, a);
@@ -82,6 +179,11 @@ void SDLGraphicsEngineRenderer::RenderPresent()
     SDL_RenderPresent(mRenderer);
 }
 
+bool SDLGraphicsEngineRenderer::SetVSync(bool bEnabled)
+{
+    return SDL_RenderSetVSync(mRenderer, bEnabled ? 1 : 0) == 0;
+}
+
 // Get Pointer to Window
 SDL_Window* SDLGraphicsEngineRenderer::GetWindow() { return mWindow; }
 
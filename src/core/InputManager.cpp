@@ -15,9 +15,45 @@ inline std::string InputManager::SDL_GetKeyNameFromScancode(
     return SDL_GetKeyName(SDL_GetKeyFromScancode(scancode));
 }
 
+inline SDL_Scancode InputManager::SDL_GetScancodeFromKeyName(
+    const std::string& keyName)
+{
+    // Key names are of the key on the current layout, as in
+    // SDL_GetKeyNameFromScancode
+    return SDL_GetScancodeFromKey(SDL_GetKeyFromName(keyName.c_str()));
+}
+
+int InputState::GetActionId(const std::string& actionName)
+{
+    static std::unordered_map<std::string, int> actionIds;
+
+    auto action = actionIds.find(actionName);
+    if (action != actionIds.end()) return action->second;
+
+    int actionId = (int)actionIds.size();
+    actionIds[actionName] = actionId;
+    return actionId;
+}
+
 InputState* InputManager::State = nullptr;
 
-InputManager::InputManager() { State = this; }
+InputManager::InputManager()
+{
+    State = this;
+
+    int right = GetActionId(MOVE_RIGHT);
+    BindAction(right, SDL_SCANCODE_D);
+    BindAction(right, SDL_SCANCODE_RIGHT);
+    int left = GetActionId(MOVE_LEFT);
+    BindAction(left, SDL_SCANCODE_A);
+    BindAction(left, SDL_SCANCODE_LEFT);
+    int up = GetActionId(MOVE_UP);
+    BindAction(up, SDL_SCANCODE_W);
+    BindAction(up, SDL_SCANCODE_UP);
+    int down = GetActionId(MOVE_DOWN);
+    BindAction(down, SDL_SCANCODE_S);
+    BindAction(down, SDL_SCANCODE_DOWN);
+}
 InputManager::~InputManager() { State = nullptr; }
 
 void InputManager::HandleEvent(SDL_Event evt)
@@ -26,23 +62,23 @@ void InputManager::HandleEvent(SDL_Event evt)
     {
         case SDL_KEYDOWN:
         {
-            std::string key =
-                SDL_GetKeyNameFromScancode(evt.key.keysym.scancode);
+            SDL_Scancode scancode = evt.key.keysym.scancode;
 #ifdef LOG_KEY_EVENTS
-            std::cout << "Pressed key: " << key << std::endl;
+            std::cout << "Pressed key: " << SDL_GetKeyNameFromScancode(scancode)
+                      << std::endl;
 #endif
-            PressKey(key);
+            PressKey(scancode);
             break;
         }
 
         case SDL_KEYUP:
         {
-            std::string key =
-                SDL_GetKeyNameFromScancode(evt.key.keysym.scancode);
+            SDL_Scancode scancode = evt.key.keysym.scancode;
 #ifdef LOG_KEY_EVENTS
-            std::cout << "Released key: " << key << std::endl;
+            std::cout << "Released key: "
+                      << SDL_GetKeyNameFromScancode(scancode) << std::endl;
 #endif
-            ReleaseKey(key);
+            ReleaseKey(scancode);
             break;
         }
 
@@ -87,28 +123,98 @@ void InputManager::HandleEvent(SDL_Event evt)
     }
 }
 
-bool InputManager::IsKeyPressed(const std::string& keyName)
+bool InputManager::IsKeyPressed(const std::string& keyName) const
+{
+    return IsKeyDown(SDL_GetScancodeFromKeyName(keyName));
+}
+
+int InputManager::GetAxis(const std::string& positive,
+                          const std::string& negative) const
+{
+    int axis = 0;
+    if (IsKeyPressed(positive)) axis += 1;
+    if (IsKeyPressed(negative)) axis -= 1;
+    return axis;
+}
+
+bool InputManager::IsKeyDown(SDL_Scancode scancode) const
+{
+    if (scancode <= SDL_SCANCODE_UNKNOWN || scancode >= SDL_NUM_SCANCODES)
+        return false;
+
+    return mKeyboardState[scancode];
+}
+
+bool InputManager::WasKeyPressed(SDL_Scancode scancode) const
+{
+    return IsKeyDown(scancode) && !mPreviousKeyboardState[scancode];
+}
+
+bool InputManager::WasKeyReleased(SDL_Scancode scancode) const
 {
-    auto input = mKeyboardState.find(keyName);
+    if (scancode <= SDL_SCANCODE_UNKNOWN || scancode >= SDL_NUM_SCANCODES)
+        return false;
 
-    if (input != mKeyboardState.end())
+    return mPreviousKeyboardState[scancode] && !mKeyboardState[scancode];
+}
+
+inline bool InputManager::IsActionDown(
+    int actionId, const std::bitset<SDL_NUM_SCANCODES>& keyboardState) const
+{
+    if (actionId < 0 || actionId >= (int)mActionBindings.size()) return false;
+
+    for (SDL_Scancode scancode : mActionBindings[actionId])
     {
-        return input->second;
+        if (keyboardState[scancode]) return true;
     }
-
-    mKeyboardState[keyName] = false;
     return false;
 }
 
-int InputManager::GetAxis(const std::string& positive,
-                          const std::string& negative)
+bool InputManager::IsActionDown(int actionId) const
+{
+    return IsActionDown(actionId, mKeyboardState);
+}
+
+bool InputManager::WasActionPressed(int actionId) const
+{
+    return IsActionDown(actionId, mKeyboardState) &&
+           !IsActionDown(actionId, mPreviousKeyboardState);
+}
+
+bool InputManager::WasActionReleased(int actionId) const
+{
+    return IsActionDown(actionId, mPreviousKeyboardState) &&
+           !IsActionDown(actionId, mKeyboardState);
+}
+
+int InputManager::GetAxis(int positive, int negative) const
 {
     int axis = 0;
-    if (IsKeyPressed(positive)) axis += 1;
-    if (IsKeyPressed(negative)) axis -= 1;
+    if (IsActionDown(positive)) axis += 1;
+    if (IsActionDown(negative)) axis -= 1;
     return axis;
 }
 
+void InputManager::BindAction(int actionId, SDL_Scancode scancode)
+{
+    if (actionId < 0) return;
+    if (scancode <= SDL_SCANCODE_UNKNOWN || scancode >= SDL_NUM_SCANCODES)
+        return;
+
+    if (actionId >= (int)mActionBindings.size())
+    {
+        mActionBindings.resize(actionId + 1);
+    }
+    mActionBindings[actionId].push_back(scancode);
+}
+
+void InputManager::UnbindAction(int actionId)
+{
+    if (actionId < 0 || actionId >= (int)mActionBindings.size()) return;
+
+    mActionBindings[actionId].clear();
+}
+
 void InputManager::AddKeyEventListener(IKeyEventListener* listener)
 {
     if (mKeyEventListeners.count(listener)) return;
@@ -158,10 +264,16 @@ bool InputManager::IsMouseButtonPressed(int mouseButtonNumber)
     return mMouseButtonsState[mouseButtonNumber - 1];
 }
 
-inline void InputManager::PressKey(std::string& keyName)
+inline void InputManager::PressKey(SDL_Scancode scancode)
 {
-    mKeyboardState[keyName] = true;
+    if (scancode <= SDL_SCANCODE_UNKNOWN || scancode >= SDL_NUM_SCANCODES)
+        return;
+
+    mKeyboardState[scancode] = true;
 
+    // Listeners still get key names, so only look it up for them
+    if (mKeyEventListeners.empty()) return;
+    std::string keyName = SDL_GetKeyNameFromScancode(scancode);
     for (IKeyEventListener* listener : mKeyEventListeners)
     {
         // Trigger key down event
@@ -169,10 +281,15 @@ inline void InputManager::PressKey(std::string& keyName)
     }
 }
 
-inline void InputManager::ReleaseKey(std::string& keyName)
+inline void InputManager::ReleaseKey(SDL_Scancode scancode)
 {
-    mKeyboardState[keyName] = false;
+    if (scancode <= SDL_SCANCODE_UNKNOWN || scancode >= SDL_NUM_SCANCODES)
+        return;
+
+    mKeyboardState[scancode] = false;
 
+    if (mKeyEventListeners.empty()) return;
+    std::string keyName = SDL_GetKeyNameFromScancode(scancode);
     for (IKeyEventListener* listener : mKeyEventListeners)
     {
         // Trigger key up event
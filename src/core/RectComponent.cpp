@@ -12,11 +12,24 @@ void RectComponent::Render(RenderContext* renderer)
     const auto& pos = mGameObject->GetTransform().GetPosition();
     SDL_Rect fillRect = {(int)pos.x, (int)pos.y, (int)mSize.x, (int)mSize.y};
 
+    if (renderer->spriteBatch)
+    {
+        SDL_Color color{mColor[0], mColor[1], mColor[2], mColor[3]};
+        renderer->spriteBatch->Fill(color, fillRect, mLayer);
+        return;
+    }
+
     SDL_SetRenderDrawColor(renderer->renderer, mColor[0], mColor[1], mColor[2],
                            mColor[3]);
     SDL_RenderFillRect(renderer->renderer, &fillRect);
 }
 
+bool RectComponent::GetBounds(FRect* bounds)
+{
+    *bounds = FRect(mGameObject->GetTransform().GetPosition(), mSize);
+    return true;
+}
+
 bool RectComponent::Intersects(const RectComponent& rect) const
 {
     const auto& thisPos = mGameObject->GetTransform().GetPosition();
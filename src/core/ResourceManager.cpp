@@ -1,10 +1,19 @@
 #include "core/ResourceManager.hpp"
+#include "core/resources/SceneLoader.hpp"
 #include "core/resources/Spritesheet.hpp"
 #include "core/resources/SpritesheetLoader.hpp"
 #include "core/resources/TextureLoader.hpp"
 #include "core/resources/TilemapLoader.hpp"
 
+#include <exception>
 #include <iostream>
+#include <utility>
+
+#if defined(LINUX) || defined(MINGW)
+#include <SDL2/SDL_image.h>
+#else  // This works for Mac
+#include <SDL_image.h>
+#endif
 
 ResourceManager::ResourceManager() {}
 
@@ -19,10 +28,32 @@ ResourceManager& ResourceManager::instance()
 int ResourceManager::Startup(SDL_Renderer* renderer)
 {
     mRenderer = renderer;
+
+    // Load the decoders up front, since the load workers would otherwise
+    // race to load them on first use
+    int decoders = IMG_INIT_PNG | IMG_INIT_JPG;
+    if ((IMG_Init(decoders) & decoders) != decoders)
+    {
+        std::cerr << "Could not initialize image decoders: " << IMG_GetError()
+                  << "\n";
+    }
     return 0;
 }
 int ResourceManager::Shutdown()
 {
+    mFileWatcher.reset();
+
+    // Finish the loads in flight, which need the loaders
+    if (mLoadWorkers)
+    {
+        delete mLoadWorkers;
+    }
+    for (ReloadedFile& file : mReloaded)
+    {
+        if (file.surface) SDL_FreeSurface(file.surface);
+    }
+    mReloaded.clear();
+
     // Free any instantiated loaders
 
     if (mTextureLoader)
@@ -40,33 +71,268 @@ int ResourceManager::Shutdown()
         delete mSpritesheetLoader;
     }
 
+    if (mSceneLoader)
+    {
+        delete mSceneLoader;
+    }
+
+    // Maps loaded from the bundle keep its file mapped
+    mBundle.reset();
+
+    IMG_Quit();
+
+    return 0;
+}
+
+int ResourceManager::MountBundle(const std::string& bundleLoc)
+{
+    std::unique_ptr<AssetBundle> bundle;
+    try
+    {
+        bundle.reset(new AssetBundle(bundleLoc));
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Could not mount asset bundle '" << bundleLoc
+                  << "': " << e.what() << "\n";
+        return -1;
+    }
+
+    if (mTextureLoader) mTextureLoader->SetBundle(bundle.get());
+    if (mTilemapLoader) mTilemapLoader->SetBundle(bundle.get());
+    if (mSpritesheetLoader) mSpritesheetLoader->SetBundle(bundle.get());
+    if (mSceneLoader) mSceneLoader->SetBundle(bundle.get());
+    mBundle = std::move(bundle);
+
+    std::cout << "Mounted asset bundle '" << bundleLoc << "' with "
+              << mBundle->GetAssetCount() << " asset(s)\n";
     return 0;
 }
 
-ResourceLoader<SDL_Texture>* ResourceManager::Textures()
+TextureLoader* ResourceManager::Textures()
 {
     if (!mTextureLoader)
     {
-        mTextureLoader = new TextureLoader(mRenderer);
+        mTextureLoader = new TextureLoader(mRenderer, LoadWorkers());
+        mTextureLoader->SetBundle(mBundle.get());
     }
 
     return mTextureLoader;
 }
-ResourceLoader<TilemapData>* ResourceManager::Tilemaps()
+TilemapLoader* ResourceManager::Tilemaps()
 {
     if (!mTilemapLoader)
     {
-        mTilemapLoader = new TilemapLoader();
+        mTilemapLoader = new TilemapLoader(LoadWorkers());
+        mTilemapLoader->SetBundle(mBundle.get());
     }
 
     return mTilemapLoader;
 }
-ResourceLoader<Spritesheet>* ResourceManager::Spritesheets()
+SpritesheetLoader* ResourceManager::Spritesheets()
 {
     if (!mSpritesheetLoader)
     {
         mSpritesheetLoader = new SpritesheetLoader(Textures());
+        mSpritesheetLoader->SetBundle(mBundle.get());
     }
 
     return mSpritesheetLoader;
 }
+SceneLoader* ResourceManager::Scenes()
+{
+    if (!mSceneLoader)
+    {
+        mSceneLoader = new SceneLoader();
+        mSceneLoader->SetBundle(mBundle.get());
+    }
+
+    return mSceneLoader;
+}
+
+void ResourceManager::PackSpritesheets(unsigned int pageSize)
+{
+    if (!mSpritesheetLoader) return;
+
+    mSpritesheetLoader->PackAtlas(mRenderer, pageSize);
+}
+
+void ResourceManager::ProcessUploads(double budgetMs)
+{
+    // Maps only need adding to their table, so they are not budgeted
+    if (mTilemapLoader) mTilemapLoader->ProcessLoads();
+    if (!mTextureLoader) return;
+
+    mTextureLoader->ProcessUploads(budgetMs);
+}
+
+void ResourceManager::WaitForDecodes()
+{
+    // Maps are read much faster than images are decoded, so wait on them
+    // first
+    if (mTilemapLoader && mTilemapLoader->HasPendingLoads())
+    {
+        mTilemapLoader->WaitForReads();
+        return;
+    }
+    if (!mTextureLoader) return;
+
+    mTextureLoader->WaitForDecodes();
+}
+
+bool ResourceManager::HasPendingLoads() const
+{
+    return (mTextureLoader && mTextureLoader->HasPendingLoads()) ||
+           (mTilemapLoader && mTilemapLoader->HasPendingLoads());
+}
+
+bool ResourceManager::ShouldEvictTextures(int frameIdx) const
+{
+    return mTextureLoader && mTextureLoader->ShouldEvict(frameIdx);
+}
+
+void ResourceManager::EvictTextures(int frameIdx)
+{
+    if (!mTextureLoader) return;
+
+    mTextureLoader->EvictTextures(frameIdx);
+}
+
+util::ThreadPool* ResourceManager::LoadWorkers()
+{
+    if (!mLoadWorkers)
+    {
+        mLoadWorkers = new util::ThreadPool(LOAD_WORKER_COUNT);
+    }
+
+    return mLoadWorkers;
+}
+
+int ResourceManager::EnableHotReload(bool bEnabled)
+{
+    if (!bEnabled)
+    {
+        mFileWatcher.reset();
+        return 0;
+    }
+    if (mFileWatcher) return 0;
+
+    std::unique_ptr<util::FileWatcher> watcher(new util::FileWatcher());
+    if (!watcher->IsSupported())
+    {
+        std::cerr << "Hot reload is not supported on this platform\n";
+        return -1;
+    }
+
+    mFileWatcher = std::move(watcher);
+    // Watch everything loaded so far
+    mWatchedLoadCount = 0;
+    WatchLoadedFiles();
+    std::cout << "Hot reload enabled\n";
+    return 0;
+}
+
+void ResourceManager::WatchLoadedFiles()
+{
+    size_t loadCount = 0;
+    if (mTextureLoader) loadCount += mTextureLoader->GetLoadCount();
+    if (mTilemapLoader) loadCount += mTilemapLoader->GetLoadCount();
+    if (mSpritesheetLoader) loadCount += mSpritesheetLoader->GetLoadCount();
+    if (loadCount == mWatchedLoadCount) return;
+    mWatchedLoadCount = loadCount;
+
+    std::vector<std::string> files;
+    if (mTextureLoader) mTextureLoader->GetLoadedFiles(files);
+    if (mTilemapLoader) mTilemapLoader->GetLoadedFiles(files);
+    if (mSpritesheetLoader) mSpritesheetLoader->GetLoadedFiles(files);
+    for (const std::string& fileLoc : files)
+    {
+        mFileWatcher->Watch(fileLoc);
+    }
+}
+
+void ResourceManager::PollReloads()
+{
+    if (!mFileWatcher) return;
+
+    WatchLoadedFiles();
+    mFileWatcher->TakeChanges(mChangedFiles);
+    for (const std::string& fileLoc : mChangedFiles)
+    {
+        // Packed spritesheets have given up the texture of their file
+        bool bTexture =
+            (mTextureLoader && mTextureLoader->IsLoaded(fileLoc)) ||
+            (mSpritesheetLoader && mSpritesheetLoader->IsLoaded(fileLoc));
+        bool bTilemap = mTilemapLoader && mTilemapLoader->IsLoaded(fileLoc);
+        if (!bTexture && !bTilemap) continue;
+
+        LoadWorkers()->Submit(
+            [this, fileLoc, bTexture, bTilemap]
+            {
+                ReloadedFile file;
+                file.fileLoc = fileLoc;
+                try
+                {
+                    if (bTexture)
+                    {
+                        file.surface = TextureLoader::DecodeFile(fileLoc);
+                        if (!file.surface) file.error = SDL_GetError();
+                    }
+                    if (bTilemap)
+                    {
+                        file.mapData =
+                            TilemapLoader::Read(fileLoc, &file.mapFormat);
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    file.error = e.what();
+                }
+
+                std::lock_guard<std::mutex> lock(mReloadedMutex);
+                mReloaded.push_back(std::move(file));
+            });
+    }
+}
+
+bool ResourceManager::HasReloads()
+{
+    std::lock_guard<std::mutex> lock(mReloadedMutex);
+    return !mReloaded.empty();
+}
+
+void ResourceManager::ApplyReloads()
+{
+    std::vector<ReloadedFile> reloaded;
+    {
+        std::lock_guard<std::mutex> lock(mReloadedMutex);
+        reloaded.swap(mReloaded);
+    }
+
+    for (ReloadedFile& file : reloaded)
+    {
+        if (!file.error.empty())
+        {
+            // Often a file caught halfway through saving, the next save
+            // will reload it
+            std::cerr << "Could not reload '" << file.fileLoc
+                      << "': " << file.error << "\n";
+        }
+        else
+        {
+            if (file.surface &&
+                Textures()->ReplaceTexture(file.fileLoc, file.surface))
+            {
+                Spritesheets()->RefreshTexture(file.fileLoc);
+            }
+            if (file.mapData)
+            {
+                Tilemaps()->ReplaceTiles(file.fileLoc, *file.mapData,
+                                         file.mapFormat);
+            }
+            std::cout << "Reloaded '" << file.fileLoc << "'\n";
+        }
+
+        if (file.surface) SDL_FreeSurface(file.surface);
+    }
+}
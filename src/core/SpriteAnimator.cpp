@@ -1,6 +1,8 @@
 #include "core/SpriteAnimator.hpp"
 #include <iostream>
+#include <stdexcept>
 #include "core/SpriteRenderer.hpp"
+#include "core/UpdateContext.hpp"
 
 SpriteAnimator::SpriteAnimator() : SpriteRenderer() {}
 
@@ -8,30 +10,104 @@ SpriteAnimator::~SpriteAnimator() {}
 
 void SpriteAnimator::Receive(const std::string& message)
 {
-    if (mAnimations.count(message) > 0)
-    {
-        mActiveAnimation = mAnimations[message];
-    }
+    // The same message usually arrives every frame, so check the active
+    // animation before looking up the name
+    if (!mClips.empty() && mClips[mActiveClip].name == message) return;
+
+    unsigned int clipId;
+    if (FindAnimation(message, &clipId)) Play(clipId);
+}
+
+ComponentAccess SpriteAnimator::GetAccess() const
+{
+    static const ComponentAccess access =
+        ComponentAccess().Reads({"sprite"}).Writes({"sprite"}).ObjectLocal();
+    return access;
+}
+
+void SpriteAnimator::Update(UpdateContext* update)
+{
+    if (mClips.empty() || !mSpritesheet) return;
+
+    if (!AreFrameTablesCurrent()) BuildFrameTables();
+
+    const AnimationClip& clip = mClips[mActiveClip];
+    mFrameTime += update->deltaTime;
+    if (mFrameTime < clip.frameDuration) return;
+
+    // Skip as many frames as have passed
+    unsigned int steps = mFrameTime / clip.frameDuration;
+    mFrameTime -= steps * clip.frameDuration;
+    mFrame = (mFrame + steps) % clip.frameCount;
 }
 
-void SpriteAnimator::Render(RenderContext* renderer)
+SDL_Rect SpriteAnimator::GetSourceRect()
 {
-    int spriteIndex =
-        mActiveAnimation.spritesheetRow * mSpritesheet->GetSize().x +
-        (renderer->frameIdx / 12) % mActiveAnimation.frameCount;
-    SetSpriteIndex(spriteIndex);
-    SpriteRenderer::Render(renderer);
+    if (mClips.empty()) return SpriteRenderer::GetSourceRect();
+
+    // Not updated since the spritesheet was set or moved
+    if (!AreFrameTablesCurrent()) BuildFrameTables();
+
+    return mClips[mActiveClip].frames[mFrame];
 }
 
-void SpriteAnimator::SetAnimation(const std::string& animName,
-                                  unsigned int spritesheetRow,
-                                  unsigned int frameCount)
+unsigned int SpriteAnimator::SetAnimation(const std::string& animName,
+                                          unsigned int spritesheetRow,
+                                          unsigned int frameCount,
+                                          float frameDuration)
 {
-    if (mAnimations.count(animName) > 0)
+    if (mClipIds.count(animName) > 0)
     {
         throw std::invalid_argument(
             "SpriteAnimator already has animation with that name");
     }
+    if (frameCount == 0 || frameDuration <= 0)
+    {
+        throw std::invalid_argument(
+            "Animations need at least one frame and a positive duration");
+    }
+
+    unsigned int clipId = mClips.size();
+    mClips.push_back(
+        AnimationClip{animName, spritesheetRow, frameCount, frameDuration, {}});
+    mClipIds[animName] = clipId;
+
+    // Build the table for the new clip too
+    mTableSheet = nullptr;
+    return clipId;
+}
+
+bool SpriteAnimator::FindAnimation(const std::string& animName,
+                                   unsigned int* out_clipId) const
+{
+    auto clipIt = mClipIds.find(animName);
+    if (clipIt == mClipIds.end()) return false;
+
+    *out_clipId = clipIt->second;
+    return true;
+}
 
-    mAnimations[animName] = {spritesheetRow, frameCount};
+void SpriteAnimator::Play(unsigned int clipId)
+{
+    if (clipId >= mClips.size() || clipId == mActiveClip) return;
+
+    mActiveClip = clipId;
+    mFrame = 0;
+    mFrameTime = 0;
+}
+
+void SpriteAnimator::BuildFrameTables()
+{
+    unsigned int columns = mSpritesheet->GetSize().x;
+    for (AnimationClip& clip : mClips)
+    {
+        clip.frames.resize(clip.frameCount);
+        for (unsigned int frame = 0; frame < clip.frameCount; ++frame)
+        {
+            clip.frames[frame] = mSpritesheet->GetSourceRect(
+                clip.spritesheetRow * columns + frame);
+        }
+    }
+    mTableSheet = mSpritesheet.get();
+    mTableVersion = mSpritesheet->GetLayoutVersion();
 }
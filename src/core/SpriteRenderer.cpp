@@ -14,8 +14,7 @@ SpriteRenderer::SpriteRenderer() : Component("sprite") {}
 
 SpriteRenderer::~SpriteRenderer()
 {
-    if (mSpritesheet)
-        ResourceManager::instance().Spritesheets()->Destroy(mSpritesheet);
+    ResourceManager::instance().Spritesheets()->Release(mSpritesheetHandle);
 }
 
 void SpriteRenderer::Render(RenderContext* ren)
@@ -25,14 +24,31 @@ void SpriteRenderer::Render(RenderContext* ren)
         throw std::runtime_error(
             "SpriteRenderer does not have an assigned Spritesheet.");
     }
-    const glm::vec2& pos = mGameObject->GetTransform().GetPosition();
+    const TransformComponent& transform = mGameObject->GetTransform();
+    const glm::vec2& pos = transform.GetPosition();
     mDest.x = pos.x - ren->worldToCamera.x;
     mDest.y = pos.y - ren->worldToCamera.y;
-    mSpritesheet->DrawSpriteAt(ren, mSpriteIndex, mDest);
+    // Children draw over their parents
+    mSpritesheet->DrawRegionAt(ren, GetSourceRect(), mDest, mLayer,
+                               transform.GetDepth());
+}
+
+bool SpriteRenderer::GetBounds(FRect* bounds)
+{
+    *bounds = FRect(mGameObject->GetTransform().GetPosition(),
+                    glm::vec2(mDest.w, mDest.h));
+    return true;
 }
 
 void SpriteRenderer::UseSpritesheet(std::shared_ptr<Spritesheet> spritesheet)
 {
+    SpritesheetLoader* spritesheets =
+        ResourceManager::instance().Spritesheets();
+    // Acquire first, in case it is the same spritesheet
+    ResourceHandle<Spritesheet> handle = spritesheets->Acquire(spritesheet);
+    spritesheets->Release(mSpritesheetHandle);
+    mSpritesheetHandle = handle;
+
     mSpritesheet = spritesheet;
     mSpriteIndex %= mSpritesheet->Count();
 }
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <fstream>
+#include <glm/common.hpp>
 #include <glm/vec2.hpp>
 #include <iomanip>
 #include <iostream>
@@ -29,7 +31,7 @@
 // _mapX, and _mapY are the size of the tilemap. This is the actual
 // number of tiles in the game that the player sees, not how many tiles
 // are in the actual sprite sheet file loaded.
-TilemapComponent::TilemapComponent(std::shared_ptr<Spritesheet>& textureAtlas)
+TilemapComponent::TilemapComponent(std::shared_ptr<Spritesheet> textureAtlas)
     : Component("tile_map"), mTextureAtlas(textureAtlas)
 {
 }
@@ -37,7 +39,11 @@ TilemapComponent::TilemapComponent(std::shared_ptr<Spritesheet>& textureAtlas)
 // Destructor
 TilemapComponent::~TilemapComponent()
 {
-    ResourceManager::instance().Tilemaps()->Destroy(mMapData);
+    // Components may be destroyed while a frame is drawing, so the chunk
+    // textures are destroyed on the renderer later
+    ReleaseChunks();
+    if (mMapData) mMapData->RemoveChangeListener(this);
+    ResourceManager::instance().Tilemaps()->Release(mMapHandle);
 }
 
 // render TilemapComponent
@@ -55,32 +61,259 @@ void TilemapComponent::Render(RenderContext* ren)
         return;
     }
 
-    SDL_Rect Dest;
     Size2D mapSize = mMapData->GetSize();
+    Size2D chunkCount{(mapSize.x + CHUNK_SIZE - 1) / CHUNK_SIZE,
+                      (mapSize.y + CHUNK_SIZE - 1) / CHUNK_SIZE};
+    if (chunkCount != mChunkCount)
+    {
+        ReleaseChunks();
+        mChunkCount = chunkCount;
+        mChunks.resize(mChunkCount.x * mChunkCount.y);
+    }
+
+    Size2D spriteSize = mTextureAtlas->GetSpriteSize();
+
+    // Only the chunks that overlap the view are drawn
+    unsigned int drawnTiles = 0;
+    TileLoc firstVisible, lastVisible;
+    if (!GetTileRange(ren->GetViewRect(), &firstVisible, &lastVisible))
+    {
+        if (ren->stats) ren->stats->culledTiles += mapSize.x * mapSize.y;
+        return;
+    }
+    // Chunks that load now are drawn this frame
+    if (mStreamer) mStreamer->Update(firstVisible, lastVisible);
+    TileLoc firstChunk = firstVisible / (int)CHUNK_SIZE;
+    TileLoc lastChunk = lastVisible / (int)CHUNK_SIZE;
+
+    // Rebuilding needs the renderer right away, so all visible dirty chunks
+    // (and old textures) are handled at once
+    TileLoc chunkLoc;
+    // Visible chunks to rebuild this frame
+    std::vector<TileLoc, util::FrameAllocator<TileLoc>> dirtyChunks(
+        ren->frameArena);
+    for (chunkLoc.y = firstChunk.y; chunkLoc.y <= lastChunk.y; chunkLoc.y++)
+    {
+        for (chunkLoc.x = firstChunk.x; chunkLoc.x <= lastChunk.x; chunkLoc.x++)
+        {
+            if (mChunks[chunkLoc.y * mChunkCount.x + chunkLoc.x].bDirty)
+                dirtyChunks.push_back(chunkLoc);
+        }
+    }
+    if (!dirtyChunks.empty())
+    {
+        // Loaded again first if it was evicted
+        SDL_Texture* atlasTexture = mTextureAtlas->UseTexture(ren);
+        ren->RunOnRenderer(
+            [this, &dirtyChunks, atlasTexture](SDL_Renderer* renderer)
+            {
+                for (TileLoc dirtyLoc : dirtyChunks)
+                    RebuildChunk(renderer, atlasTexture, dirtyLoc);
+            });
+    }
+
+    for (chunkLoc.y = firstChunk.y; chunkLoc.y <= lastChunk.y; chunkLoc.y++)
+    {
+        for (chunkLoc.x = firstChunk.x; chunkLoc.x <= lastChunk.x; chunkLoc.x++)
+        {
+            RenderChunk& chunk =
+                mChunks[chunkLoc.y * mChunkCount.x + chunkLoc.x];
+
+            Size2D chunkTiles = GetChunkTiles(chunkLoc);
+            drawnTiles += chunkTiles.x * chunkTiles.y;
+
+            if (!chunk.texture)
+            {
+                DrawChunkTiles(ren, chunkLoc);
+                continue;
+            }
+
+            SDL_Rect src{0, 0, (int)(chunkTiles.x * spriteSize.x),
+                         (int)(chunkTiles.y * spriteSize.y)};
+            SDL_Rect dest;
+            GetTileDisplayRect(&dest, ren, chunkLoc * (int)CHUNK_SIZE);
+            dest.w *= chunkTiles.x;
+            dest.h *= chunkTiles.y;
+
+            if (ren->spriteBatch)
+            {
+                ren->spriteBatch->Draw(chunk.texture.get(),
+                                       Size2D(src.w, src.h), src, dest,
+                                       mLayer);
+            }
+            else
+            {
+                SDL_RenderCopy(ren->renderer, chunk.texture.get(), &src,
+                               &dest);
+            }
+        }
+    }
+
+    if (ren->stats)
+        ren->stats->culledTiles += mapSize.x * mapSize.y - drawnTiles;
+}
+
+Size2D TilemapComponent::GetChunkTiles(TileLoc chunkLoc) const
+{
+    Size2D mapSize = mMapData->GetSize();
+    Size2D firstTile = Size2D(chunkLoc) * CHUNK_SIZE;
+    return Size2D{std::min(CHUNK_SIZE, mapSize.x - firstTile.x),
+                  std::min(CHUNK_SIZE, mapSize.y - firstTile.y)};
+}
+
+void TilemapComponent::RebuildChunk(SDL_Renderer* renderer,
+                                    SDL_Texture* atlasTexture,
+                                    TileLoc chunkLoc)
+{
+    RenderChunk& chunk = mChunks[chunkLoc.y * mChunkCount.x + chunkLoc.x];
+    chunk.bDirty = false;
+
+    Size2D spriteSize = mTextureAtlas->GetSpriteSize();
+    Size2D chunkTiles = GetChunkTiles(chunkLoc);
+
+    if (!chunk.texture)
+    {
+        SDL_Texture* texture = SDL_CreateTexture(
+            renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+            CHUNK_SIZE * spriteSize.x, CHUNK_SIZE * spriteSize.y);
+        if (!texture)
+        {
+            // Render targets are not supported, draw tile by tile instead
+            SDL_Log("Could not create tilemap chunk texture: %s",
+                    SDL_GetError());
+            return;
+        }
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        chunk.texture = ResourceManager::instance().Textures()->AdoptTexture(
+            texture, "tilemap chunk");
+    }
+
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, chunk.texture.get());
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+
+    TileLoc firstTile = chunkLoc * (int)CHUNK_SIZE;
+    TileLoc offset;
+    for (offset.y = 0; offset.y < chunkTiles.y; offset.y++)
+    {
+        for (offset.x = 0; offset.x < chunkTiles.x; offset.x++)
+        {
+            const TileData tile = mMapData->GetTile(firstTile + offset);
+            if (tile.type < 0) continue;
+
+            SDL_Rect src = mTextureAtlas->GetSourceRect(tile.type);
+            SDL_Rect dest{(int)(offset.x * spriteSize.x),
+                          (int)(offset.y * spriteSize.y), (int)spriteSize.x,
+                          (int)spriteSize.y};
+            SDL_RenderCopy(renderer, atlasTexture, &src, &dest);
+        }
+    }
+
+    SDL_SetRenderTarget(renderer, previousTarget);
+}
+
+void TilemapComponent::DrawChunkTiles(RenderContext* ren, TileLoc chunkLoc)
+{
+    SDL_Rect Dest;
+    Size2D chunkTiles = GetChunkTiles(chunkLoc);
+    TileLoc firstTile = chunkLoc * (int)CHUNK_SIZE;
 
     TileLoc tileLoc;
-    for (tileLoc.y = 0; tileLoc.y < mapSize.y; tileLoc.y++)
+    for (tileLoc.y = firstTile.y; tileLoc.y < firstTile.y + chunkTiles.y;
+         tileLoc.y++)
     {
-        for (tileLoc.x = 0; tileLoc.x < mapSize.x; tileLoc.x++)
+        for (tileLoc.x = firstTile.x; tileLoc.x < firstTile.x + chunkTiles.x;
+             tileLoc.x++)
         {
             // Select our Tile
             const TileData tile = mMapData->GetTile(tileLoc);
             if (tile.type < 0) continue;
 
             GetTileDisplayRect(&Dest, ren, tileLoc);
-            mTextureAtlas->DrawTileAt(ren, tile.type, Dest, tile.bHasCollider);
+            mTextureAtlas->DrawTileAt(ren, tile.type, Dest, tile.bHasCollider,
+                                      mLayer);
         }
     }
 }
 
+void TilemapComponent::HandleTileChanged(TileLoc tileLoc)
+{
+    TileLoc chunkLoc = tileLoc / (int)CHUNK_SIZE;
+    if (chunkLoc.x < 0 || chunkLoc.y < 0 || chunkLoc.x >= mChunkCount.x ||
+        chunkLoc.y >= mChunkCount.y)
+        return;
+
+    mChunks[chunkLoc.y * mChunkCount.x + chunkLoc.x].bDirty = true;
+}
+
+void TilemapComponent::HandleTilemapResized() { ReleaseChunks(); }
+
+void TilemapComponent::HandleAreaChanged(TileLoc first, Size2D size)
+{
+    TileLoc firstChunk = glm::max(first, TileLoc(0, 0)) / (int)CHUNK_SIZE;
+    TileLoc lastChunk = glm::min(first + TileLoc(size) - 1,
+                                 TileLoc(mChunkCount * CHUNK_SIZE) - 1) /
+                        (int)CHUNK_SIZE;
+
+    TextureLoader* textures = ResourceManager::instance().Textures();
+    TileLoc chunkLoc;
+    for (chunkLoc.y = firstChunk.y; chunkLoc.y <= lastChunk.y; chunkLoc.y++)
+    {
+        for (chunkLoc.x = firstChunk.x; chunkLoc.x <= lastChunk.x; chunkLoc.x++)
+        {
+            // Unloaded chunks should not keep their textures around
+            RenderChunk& chunk =
+                mChunks[chunkLoc.y * mChunkCount.x + chunkLoc.x];
+            textures->RetireTexture(std::move(chunk.texture));
+            chunk.bDirty = true;
+        }
+    }
+}
+
+void TilemapComponent::ReleaseChunks()
+{
+    // The frame in flight may still draw these, so they are destroyed on the
+    // renderer before the next frame (see TextureLoader::RetireTexture)
+    TextureLoader* textures = ResourceManager::instance().Textures();
+    for (RenderChunk& chunk : mChunks)
+    {
+        textures->RetireTexture(std::move(chunk.texture));
+    }
+    mChunks.clear();
+    mChunkCount = Size2D{0, 0};
+}
+
 void TilemapComponent::GenerateMapFromFile(std::string filePath)
 {
-    ResourceManager::instance().Tilemaps()->Load(filePath);
-    mMapData = ResourceManager::instance().Tilemaps()->Get(filePath);
+    TilemapLoader* tilemaps = ResourceManager::instance().Tilemaps();
+    tilemaps->Load(filePath);
+    if (mMapData) mMapData->RemoveChangeListener(this);
+    ReleaseChunks();
+    mStreamer.reset();
+
+    // Acquire first, in case it is the same map
+    ResourceHandle<TilemapData> handle = tilemaps->Acquire(filePath);
+    tilemaps->Release(mMapHandle);
+    mMapHandle = handle;
+
+    mMapData = tilemaps->Get(mMapHandle);
+    mMapData->AddChangeListener(this);
 
     mMapData->Print();
 }
 
+void TilemapComponent::StreamMapFromDirectory(std::string worldDir)
+{
+    if (mMapData) mMapData->RemoveChangeListener(this);
+    ReleaseChunks();
+    ResourceManager::instance().Tilemaps()->Release(mMapHandle);
+
+    mStreamer.reset(new TilemapStreamer(worldDir));
+    mMapData = mStreamer->GetMapData();
+    mMapData->AddChangeListener(this);
+}
+
 void TilemapComponent::GetTileDisplayRect(SDL_Rect* out_rect,
                                           RenderContext* ren,
                                           TileLoc tile) const
@@ -97,6 +330,24 @@ glm::vec2 TilemapComponent::WorldPosToTilePos(const glm::vec2& worldPos) const
                      worldPos.y / mTileDisplaySize.y);
 }
 
+bool TilemapComponent::GetTileRange(const FRect& worldRect, TileLoc* out_first,
+                                    TileLoc* out_last) const
+{
+    Size2D mapSize = mMapData->GetSize();
+
+    glm::vec2 first = glm::floor(WorldPosToTilePos(worldRect.pos));
+    glm::vec2 last =
+        glm::floor(WorldPosToTilePos(worldRect.pos + worldRect.size));
+
+    if (last.x < 0 || last.y < 0 || first.x >= mapSize.x ||
+        first.y >= mapSize.y)
+        return false;
+
+    *out_first = glm::max(TileLoc(first), TileLoc(0, 0));
+    *out_last = glm::min(TileLoc(last), TileLoc(mapSize) - 1);
+    return true;
+}
+
 std::shared_ptr<TilemapData> TilemapComponent::GetTileMapData()
 {
     return mMapData;
@@ -1,8 +1,77 @@
 #include "core/TransformComponent.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+
 TransformComponent::TransformComponent()
-    : Component("transform"), mPosition(0, 0)
+    : Component("transform"), mLocalPosition(0, 0)
+{
+}
+
+TransformComponent::~TransformComponent()
+{
+    // Orphaned children keep their world position
+    while (!mChildren.empty())
+    {
+        mChildren.back()->SetParent(nullptr);
+    }
+    SetParent(nullptr);
+}
+
+void TransformComponent::SetParent(TransformComponent* parent)
+{
+    if (parent == mParent) return;
+
+    for (TransformComponent* ancestor = parent; ancestor;
+         ancestor = ancestor->mParent)
+    {
+        if (ancestor == this)
+        {
+            throw std::invalid_argument(
+                "A transform cannot be parented to one of its descendants.");
+        }
+    }
+
+    glm::vec2 worldPos = GetPosition();
+
+    if (mParent)
+    {
+        auto& siblings = mParent->mChildren;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), this),
+                       siblings.end());
+    }
+
+    mParent = parent;
+    if (mParent)
+    {
+        mParent->mChildren.push_back(this);
+        mLocalPosition = worldPos - mParent->GetPosition();
+    }
+    else
+    {
+        mLocalPosition = worldPos;
+    }
+
+    UpdateDepth();
+    MarkDirty();
+}
+
+void TransformComponent::MarkDirty()
 {
+    if (mbDirty) return;
+
+    mbDirty = true;
+    for (TransformComponent* child : mChildren)
+    {
+        child->MarkDirty();
+    }
 }
 
-TransformComponent::~TransformComponent() {}
+void TransformComponent::UpdateDepth()
+{
+    mDepth = mParent ? mParent->mDepth + 1 : 0;
+    for (TransformComponent* child : mChildren)
+    {
+        child->UpdateDepth();
+    }
+}
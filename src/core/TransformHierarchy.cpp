@@ -0,0 +1,78 @@
+#include "core/TransformHierarchy.hpp"
+#include "core/GameObject.hpp"
+#include "core/TransformComponent.hpp"
+
+#include <algorithm>
+
+void TransformHierarchy::Add(TransformComponent* transform)
+{
+    transform->mHierarchyIndex = mTransforms.size();
+    mTransforms.push_back(transform);
+    if (transform->GetDepth() > 0) mbOrderDirty = true;
+}
+
+void TransformHierarchy::Remove(TransformComponent* transform)
+{
+    size_t index = transform->mHierarchyIndex;
+    if (index >= mTransforms.size() || mTransforms[index] != transform)
+        return;
+
+    // Closed by the next propagation, which keeps the rest sorted
+    mTransforms[index] = nullptr;
+    transform->mHierarchyIndex = TransformComponent::NOT_IN_HIERARCHY;
+    mRemovedCount++;
+}
+
+void TransformHierarchy::RemoveScope(const util::ScopeArena* arena)
+{
+    auto inArena = [arena](const TransformComponent* transform)
+    { return !transform || transform->GetGameObject()->GetArena() == arena; };
+    // Erasing keeps the remaining transforms sorted
+    mTransforms.erase(
+        std::remove_if(mTransforms.begin(), mTransforms.end(), inArena),
+        mTransforms.end());
+    mRemovedCount = 0;
+    UpdateIndices();
+}
+
+void TransformHierarchy::Propagate()
+{
+    if (mRemovedCount > 0)
+    {
+        mTransforms.erase(
+            std::remove(mTransforms.begin(), mTransforms.end(), nullptr),
+            mTransforms.end());
+        mRemovedCount = 0;
+        if (!mbOrderDirty) UpdateIndices();
+    }
+    if (mbOrderDirty)
+    {
+        std::stable_sort(mTransforms.begin(), mTransforms.end(),
+                         [](const TransformComponent* lhs,
+                            const TransformComponent* rhs)
+                         { return lhs->mDepth < rhs->mDepth; });
+        mbOrderDirty = false;
+        UpdateIndices();
+    }
+
+    // Parents are visited before their children, so a parent's cached world
+    // position is always up to date by the time its children read it.
+    for (TransformComponent* transform : mTransforms)
+    {
+        if (!transform->mbDirty) continue;
+
+        transform->mWorldPosition =
+            transform->mParent ? transform->mParent->mWorldPosition +
+                                     transform->mLocalPosition
+                               : transform->mLocalPosition;
+        transform->mbDirty = false;
+    }
+}
+
+void TransformHierarchy::UpdateIndices()
+{
+    for (size_t i = 0; i < mTransforms.size(); ++i)
+    {
+        mTransforms[i]->mHierarchyIndex = i;
+    }
+}
@@ -18,28 +18,16 @@ bool TilemapColliderComponent::CollidesWithRectangle(FRect* rect)
 {
     FindTilemapIfNull();
 
-    glm::vec2 position = mGameObject->GetTransform().GetPosition();
-
-    // Get the top left bounds of the tile that the rectangle *COULD* collide
-    // with
-    glm::vec2 topLeftCornerRect = glm::vec2(rect->x, rect->y);
-    glm::vec2 topLeftTilePos = mTilemap->WorldPosToTilePos(topLeftCornerRect);
-
-    // Get the bottom right bounds of the tile that the rectangle *COULD*
-    // collide with
-    glm::vec2 bottomRightCornerRect =
-        topLeftCornerRect + glm::vec2(rect->w, rect->h);
-    glm::vec2 bottomRightTilePos =
-        mTilemap->WorldPosToTilePos(bottomRightCornerRect);
+    // Get the bounds of the tiles that the rectangle *COULD* collide with
+    TileLoc firstTile, lastTile;
+    if (!mTilemap->GetTileRange(*rect, &firstTile, &lastTile)) return false;
 
     // Loop through all of the tiles that the rect *MAY* collide with (if it has
     // a collider)
     TileLoc tileLoc;
-    for (tileLoc.y = topLeftTilePos.y; tileLoc.y <= bottomRightTilePos.y;
-         ++tileLoc.y)
+    for (tileLoc.y = firstTile.y; tileLoc.y <= lastTile.y; ++tileLoc.y)
     {
-        for (tileLoc.x = topLeftTilePos.x; tileLoc.x <= bottomRightTilePos.x;
-             ++tileLoc.x)
+        for (tileLoc.x = firstTile.x; tileLoc.x <= lastTile.x; ++tileLoc.x)
         {
             TileData tile = mData->GetTile(tileLoc);
             if (tile.bHasCollider) return true;
@@ -83,11 +71,14 @@ void TilemapColliderComponent::DrawGizmos(RenderContext* renderer,
 
     SDL_Rect tileRect;
 
-    Size2D tilemapSize = mData->GetSize();
+    TileLoc firstTile, lastTile;
+    if (!mTilemap->GetTileRange(renderer->GetViewRect(), &firstTile, &lastTile))
+        return;
+
     TileLoc tileLoc;
-    for (tileLoc.y = 0; tileLoc.y < tilemapSize.y; ++tileLoc.y)
+    for (tileLoc.y = firstTile.y; tileLoc.y <= lastTile.y; ++tileLoc.y)
     {
-        for (tileLoc.x = 0; tileLoc.x < tilemapSize.x; ++tileLoc.x)
+        for (tileLoc.x = firstTile.x; tileLoc.x <= lastTile.x; ++tileLoc.x)
         {
             if (!mData->GetTile(tileLoc).bHasCollider) continue;
 
@@ -0,0 +1,129 @@
+#include "core/render/CommandBuffer.hpp"
+
+#include <algorithm>
+
+namespace render
+{
+
+void CommandBuffer::Clear()
+{
+    quads.clear();
+    overlays.clear();
+    stats = FrameStats();
+}
+
+void CommandBuffer::Execute(SDL_Renderer* renderer)
+{
+    if (renderer)
+    {
+        SDL_SetRenderDrawColor(renderer, clearColor.r, clearColor.g,
+                               clearColor.b, clearColor.a);
+        SDL_RenderClear(renderer);
+    }
+
+    SortQuads();
+
+    // The order is settled, so neighbors with the same texture can share a
+    // draw call regardless of their layer
+    size_t runBegin = 0;
+    for (size_t i = 1; i <= quads.size(); ++i)
+    {
+        if (i < quads.size() && quads[i].texture == quads[runBegin].texture)
+            continue;
+
+        SubmitRun(renderer, runBegin, i);
+        runBegin = i;
+    }
+    stats.quads += quads.size();
+
+    if (!renderer) return;
+    for (RenderCallback& overlay : overlays)
+    {
+        overlay(renderer);
+    }
+}
+
+void CommandBuffer::SortQuads()
+{
+    size_t count = quads.size();
+    if (count < 2) return;
+
+    mSortEntries.resize(count);
+    mSortScratch.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        mSortEntries[i] = SortEntry{quads[i].sortKey, (uint32_t)i};
+    }
+
+    for (unsigned int shift = 0; shift < 64; shift += 8)
+    {
+        size_t offsets[256] = {};
+        for (const SortEntry& entry : mSortEntries)
+        {
+            offsets[(entry.key >> shift) & 0xFF]++;
+        }
+
+        // Every key has the same byte here, so the order would not change
+        if (offsets[(mSortEntries[0].key >> shift) & 0xFF] == count) continue;
+
+        size_t total = 0;
+        for (size_t& offset : offsets)
+        {
+            size_t digitCount = offset;
+            offset = total;
+            total += digitCount;
+        }
+
+        for (const SortEntry& entry : mSortEntries)
+        {
+            mSortScratch[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+        }
+        mSortEntries.swap(mSortScratch);
+    }
+
+    mSortedQuads.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        mSortedQuads[i] = quads[mSortEntries[i].index];
+    }
+    quads.swap(mSortedQuads);
+}
+
+void CommandBuffer::SubmitRun(SDL_Renderer* renderer, size_t begin,
+                              size_t end)
+{
+    if (begin == end) return;
+
+    unsigned int batchSize = end - begin;
+    stats.drawCalls++;
+    stats.batches++;
+    stats.largestBatch = std::max(stats.largestBatch, batchSize);
+
+    if (!renderer) return;
+
+    mVertices.clear();
+    mIndices.clear();
+    for (size_t i = begin; i < end; ++i)
+    {
+        const SpriteQuad& quad = quads[i];
+        const SDL_FRect& d = quad.dest;
+        const SDL_FRect& uv = quad.uv;
+
+        int first = mVertices.size();
+        mVertices.push_back({{d.x, d.y}, quad.color, {uv.x, uv.y}});
+        mVertices.push_back(
+            {{d.x + d.w, d.y}, quad.color, {uv.x + uv.w, uv.y}});
+        mVertices.push_back(
+            {{d.x + d.w, d.y + d.h}, quad.color, {uv.x + uv.w, uv.y + uv.h}});
+        mVertices.push_back(
+            {{d.x, d.y + d.h}, quad.color, {uv.x, uv.y + uv.h}});
+
+        mIndices.insert(mIndices.end(), {first, first + 1, first + 2, first,
+                                         first + 2, first + 3});
+    }
+
+    SDL_RenderGeometry(renderer, quads[begin].texture, mVertices.data(),
+                       mVertices.size(), mIndices.data(), mIndices.size());
+}
+
+}  // namespace render
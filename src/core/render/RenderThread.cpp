@@ -0,0 +1,104 @@
+#include "core/render/RenderThread.hpp"
+
+namespace render
+{
+
+RenderThread::RenderThread(IGraphicsEngineRenderer* renderer)
+    : mRenderer(renderer)
+{
+    mThread = std::thread(&RenderThread::ThreadLoop, this);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mWorkDone.wait(lock, [this] { return mbStarted; });
+}
+
+RenderThread::~RenderThread()
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWorkDone.wait(lock, [this] { return IsIdle(); });
+        mbStopping = true;
+    }
+    mWorkAvailable.notify_one();
+    mThread.join();
+}
+
+FrameStats RenderThread::Submit(CommandBuffer* buffer)
+{
+    FrameStats completedStats;
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWorkDone.wait(lock, [this] { return IsIdle(); });
+        completedStats = mCompletedStats;
+        mPendingFrame = buffer;
+    }
+    mWorkAvailable.notify_one();
+    return completedStats;
+}
+
+void RenderThread::Invoke(const RenderCallback& work)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mWorkDone.wait(lock, [this] { return IsIdle(); });
+    mPendingWork = &work;
+    mWorkAvailable.notify_one();
+    mWorkDone.wait(lock, [this] { return IsIdle(); });
+}
+
+FrameStats RenderThread::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mWorkDone.wait(lock, [this] { return IsIdle(); });
+    return mCompletedStats;
+}
+
+void RenderThread::ThreadLoop()
+{
+    // The renderer belongs to the thread that creates it
+    if (!mRenderer->GetRenderer())
+    {
+        mbOwnsRenderer = mRenderer->CreateRenderer();
+    }
+    SDL_Renderer* renderer = mRenderer->GetRenderer();
+    SDL_Renderer* drawRenderer =
+        mRenderer->DiscardsDraws() ? nullptr : renderer;
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mbStarted = true;
+    mWorkDone.notify_all();
+    while (true)
+    {
+        mWorkAvailable.wait(lock,
+                            [this] { return mbStopping || !IsIdle(); });
+        if (mbStopping) break;
+
+        // The main thread does not touch the pending work until it is done,
+        // so it can run without holding the lock
+        lock.unlock();
+        if (mPendingWork)
+        {
+            (*mPendingWork)(renderer);
+        }
+        else
+        {
+            mPendingFrame->Execute(drawRenderer);
+            mRenderer->RenderPresent();
+        }
+        lock.lock();
+
+        if (mPendingWork)
+        {
+            mPendingWork = nullptr;
+        }
+        else
+        {
+            mCompletedStats = mPendingFrame->stats;
+            mPendingFrame = nullptr;
+        }
+        mWorkDone.notify_all();
+    }
+
+    if (mbOwnsRenderer) mRenderer->DestroyRenderer();
+}
+
+}  // namespace render
@@ -0,0 +1,80 @@
+#include "core/render/SpriteBatch.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace render
+{
+
+void SpriteBatch::SetTarget(CommandBuffer* buffer)
+{
+    mTarget = buffer;
+    mTextureIds.clear();
+}
+
+void SpriteBatch::SetLayerYSorted(int layer, bool bYSorted)
+{
+    if (bYSorted)
+        mYSortedLayers.insert(layer);
+    else
+        mYSortedLayers.erase(layer);
+}
+
+void SpriteBatch::Draw(SDL_Texture* texture, glm::uvec2 textureSize,
+                       const SDL_Rect& src, const SDL_Rect& dest, int layer,
+                       unsigned int depth)
+{
+    SpriteQuad quad;
+    quad.texture = texture;
+    quad.sortKey = MakeSortKey(texture, dest, layer, depth);
+    quad.dest = {(float)dest.x, (float)dest.y, (float)dest.w, (float)dest.h};
+    quad.uv = {(float)src.x / textureSize.x, (float)src.y / textureSize.y,
+               (float)src.w / textureSize.x, (float)src.h / textureSize.y};
+    quad.color = {0xFF, 0xFF, 0xFF, 0xFF};
+    mTarget->quads.push_back(quad);
+}
+
+void SpriteBatch::Fill(SDL_Color color, const SDL_Rect& dest, int layer)
+{
+    SpriteQuad quad;
+    quad.texture = nullptr;
+    quad.sortKey = MakeSortKey(nullptr, dest, layer, 0);
+    quad.dest = {(float)dest.x, (float)dest.y, (float)dest.w, (float)dest.h};
+    quad.uv = {0, 0, 0, 0};
+    quad.color = color;
+    mTarget->quads.push_back(quad);
+}
+
+void SpriteBatch::DrawOverlay(RenderCallback overlay)
+{
+    mTarget->overlays.push_back(std::move(overlay));
+}
+
+uint64_t SpriteBatch::MakeSortKey(SDL_Texture* texture, const SDL_Rect& dest,
+                                  int layer, unsigned int depth)
+{
+    // Signed values are offset so negative ones sort first
+    uint64_t layerBits = std::clamp(layer, -0x8000, 0x7FFF) + 0x8000;
+
+    uint64_t yBits = 0;
+    if (mYSortedLayers.count(layer))
+    {
+        int bottom = dest.y + dest.h;
+        yBits = std::clamp(bottom, -0x800000, 0x7FFFFF) + 0x800000;
+    }
+
+    auto textureIt = mTextureIds.find(texture);
+    if (textureIt == mTextureIds.end())
+    {
+        // Past 65535 textures in a frame, the rest share the last id
+        uint16_t id = std::min<size_t>(mTextureIds.size(), 0xFFFF);
+        textureIt = mTextureIds.emplace(texture, id).first;
+    }
+    uint64_t textureBits = textureIt->second;
+
+    uint64_t depthBits = std::min(depth, 0xFFu);
+
+    return layerBits << 48 | yBits << 24 | textureBits << 8 | depthBits;
+}
+
+}  // namespace render
@@ -0,0 +1,288 @@
+#include "core/resources/AssetBundle.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+// Tilemaps are used in place, so their chunks must not straddle pages
+constexpr size_t TILEMAP_ALIGNMENT = 4096;
+constexpr size_t DEFAULT_ALIGNMENT = 16;
+
+size_t Align(size_t offset, size_t alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+AssetBundle::AssetBundle(const std::string& bundleLoc)
+{
+    // Read only, since it stays mapped while every level using it loads and
+    // unloads. Tilemaps used in place copy the chunks they edit.
+    mFile = std::make_shared<util::MappedFile>(bundleLoc);
+
+    size_t fileSize = mFile->GetSize();
+    if (fileSize < sizeof(mHeader))
+    {
+        throw std::invalid_argument("Asset bundle is truncated.");
+    }
+    std::memcpy(&mHeader, mFile->GetData(), sizeof(mHeader));
+
+    if (std::memcmp(mHeader.magic, AssetBundleHeader::MAGIC,
+                    sizeof(mHeader.magic)) != 0)
+    {
+        throw std::invalid_argument("File is not an asset bundle.");
+    }
+    if (mHeader.version != AssetBundleHeader::VERSION)
+    {
+        throw std::invalid_argument("Asset bundle version " +
+                                    std::to_string(mHeader.version) +
+                                    " is not supported.");
+    }
+    size_t bucketCount = mHeader.bucketCount;
+    if (bucketCount == 0 || (bucketCount & (bucketCount - 1)) != 0 ||
+        mHeader.indexOffset % alignof(AssetBundleEntry) != 0 ||
+        mHeader.indexOffset + bucketCount * sizeof(AssetBundleEntry) >
+            fileSize ||
+        mHeader.pathsOffset > fileSize)
+    {
+        throw std::invalid_argument("Asset bundle has a bad index.");
+    }
+
+    mIndex = reinterpret_cast<const AssetBundleEntry*>(mFile->GetData() +
+                                                       mHeader.indexOffset);
+    mPaths =
+        reinterpret_cast<const char*>(mFile->GetData() + mHeader.pathsOffset);
+}
+
+const AssetBundleEntry* AssetBundle::Find(const std::string& path,
+                                          AssetType type) const
+{
+    std::string normalized = NormalizePath(path);
+    uint64_t hash = HashPath(normalized);
+    size_t pathsSize = mFile->GetSize() - mHeader.pathsOffset;
+
+    uint32_t mask = mHeader.bucketCount - 1;
+    for (uint32_t probe = 0; probe < mHeader.bucketCount; ++probe)
+    {
+        const AssetBundleEntry& entry = mIndex[(hash + probe) & mask];
+        if (entry.pathHash == 0) return nullptr;
+        if (entry.pathHash != hash || entry.type != type) continue;
+
+        if ((size_t)entry.pathOffset + entry.pathLength > pathsSize ||
+            normalized.compare(0, std::string::npos,
+                               mPaths + entry.pathOffset,
+                               entry.pathLength) != 0)
+        {
+            continue;
+        }
+
+        if (entry.dataOffset + entry.dataSize > mFile->GetSize())
+        {
+            throw std::invalid_argument("Asset '" + normalized +
+                                        "' is outside of the bundle.");
+        }
+        return &entry;
+    }
+    return nullptr;
+}
+
+const BakedTextureHeader* AssetBundle::FindTexture(
+    const std::string& path) const
+{
+    const AssetBundleEntry* entry = Find(path, AssetType::Texture);
+    if (!entry) return nullptr;
+
+    const BakedTextureHeader* texture =
+        reinterpret_cast<const BakedTextureHeader*>(mFile->GetData() +
+                                                    entry->dataOffset);
+    if (entry->dataSize < sizeof(BakedTextureHeader) ||
+        entry->dataSize - sizeof(BakedTextureHeader) <
+            (uint64_t)texture->pitch * texture->height)
+    {
+        throw std::invalid_argument("Texture '" + path +
+                                    "' in the bundle is truncated.");
+    }
+    return texture;
+}
+
+SDL_Surface* AssetBundle::CreateSurface(const std::string& path) const
+{
+    const BakedTextureHeader* texture = FindTexture(path);
+    if (!texture) return nullptr;
+
+    // The mapping is private, SDL only reads the pixels
+    void* pixels = const_cast<BakedTextureHeader*>(texture) + 1;
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(
+        pixels, texture->width, texture->height,
+        SDL_BITSPERPIXEL(texture->pixelFormat), texture->pitch,
+        texture->pixelFormat);
+    if (!surface) return nullptr;
+
+    // Formats with alpha blend by default, even where the image had none
+    SDL_SetSurfaceBlendMode(surface, texture->bBlend ? SDL_BLENDMODE_BLEND
+                                                     : SDL_BLENDMODE_NONE);
+    return surface;
+}
+
+uint64_t AssetBundle::HashPath(const std::string& path)
+{
+    // 64 bit FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : path)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash != 0 ? hash : 1;
+}
+
+std::string AssetBundle::NormalizePath(const std::string& path)
+{
+    if (path.compare(0, 2, "./") == 0) return path.substr(2);
+    return path;
+}
+
+void AssetBundleBuilder::AddTexture(const std::string& path,
+                                    SDL_Surface* surface,
+                                    uint32_t pixelFormat,
+                                    uint32_t spriteWidth,
+                                    uint32_t spriteHeight)
+{
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, pixelFormat, 0);
+    if (!converted)
+    {
+        throw std::runtime_error("Could not convert '" + path +
+                                 "': " + SDL_GetError());
+    }
+
+    BakedTextureHeader header;
+    header.width = converted->w;
+    header.height = converted->h;
+    header.pitch = converted->pitch;
+    header.pixelFormat = pixelFormat;
+    header.spriteWidth = spriteWidth;
+    header.spriteHeight = spriteHeight;
+    header.bBlend =
+        surface->format->Amask != 0 || SDL_HasColorKey(surface) == SDL_TRUE;
+    header.reserved = 0;
+
+    std::string data(reinterpret_cast<const char*>(&header), sizeof(header));
+    SDL_LockSurface(converted);
+    data.append(static_cast<const char*>(converted->pixels),
+                (size_t)converted->pitch * converted->h);
+    SDL_UnlockSurface(converted);
+    SDL_FreeSurface(converted);
+
+    AddAsset(path, AssetType::Texture, std::move(data));
+}
+
+void AssetBundleBuilder::AddAsset(const std::string& path, AssetType type,
+                                  std::string data)
+{
+    std::string normalized = AssetBundle::NormalizePath(path);
+    for (const Asset& asset : mAssets)
+    {
+        if (asset.path == normalized && asset.type == type)
+        {
+            throw std::invalid_argument("Asset '" + path +
+                                        "' was added twice.");
+        }
+    }
+
+    mAssets.push_back(Asset{normalized, type, std::move(data)});
+}
+
+void AssetBundleBuilder::Write(const std::string& bundleLoc) const
+{
+    // Keeping the index at most half full keeps probes short
+    uint32_t bucketCount = 1;
+    while (bucketCount < mAssets.size() * 2) bucketCount *= 2;
+    std::vector<AssetBundleEntry> index(bucketCount, AssetBundleEntry{});
+    std::string paths;
+
+    // Mounted bundles may be using the old file, so it is replaced rather
+    // than written over
+    std::string tempLoc = bundleLoc + ".tmp";
+    std::ofstream outFile(tempLoc, std::ios::binary);
+    if (!outFile.is_open())
+    {
+        throw std::runtime_error("Could not save to file '" + bundleLoc +
+                                 "'");
+    }
+
+    AssetBundleHeader header{};
+    std::memcpy(header.magic, AssetBundleHeader::MAGIC, sizeof(header.magic));
+    header.version = AssetBundleHeader::VERSION;
+    header.bucketCount = bucketCount;
+    header.assetCount = mAssets.size();
+    outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    size_t offset = sizeof(header);
+    auto padTo = [&outFile, &offset](size_t alignment)
+    {
+        std::string padding(Align(offset, alignment) - offset, '\0');
+        outFile.write(padding.data(), padding.size());
+        offset += padding.size();
+    };
+
+    for (const Asset& asset : mAssets)
+    {
+        padTo(asset.type == AssetType::Tilemap ? TILEMAP_ALIGNMENT
+                                               : DEFAULT_ALIGNMENT);
+
+        AssetBundleEntry entry{};
+        entry.pathHash = AssetBundle::HashPath(asset.path);
+        entry.dataOffset = offset;
+        entry.dataSize = asset.data.size();
+        entry.pathOffset = paths.size();
+        entry.pathLength = asset.path.size();
+        entry.type = asset.type;
+
+        uint32_t bucket = entry.pathHash & (bucketCount - 1);
+        while (index[bucket].pathHash != 0)
+        {
+            bucket = (bucket + 1) & (bucketCount - 1);
+        }
+        index[bucket] = entry;
+
+        outFile.write(asset.data.data(), asset.data.size());
+        offset += asset.data.size();
+        paths += asset.path;
+    }
+
+    padTo(alignof(AssetBundleEntry));
+    header.indexOffset = offset;
+    outFile.write(reinterpret_cast<const char*>(index.data()),
+                  index.size() * sizeof(AssetBundleEntry));
+    offset += index.size() * sizeof(AssetBundleEntry);
+
+    header.pathsOffset = offset;
+    outFile.write(paths.data(), paths.size());
+
+    // Now that the offsets are known
+    outFile.seekp(0);
+    outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    outFile.close();
+    if (!outFile)
+    {
+        std::remove(tempLoc.c_str());
+        throw std::runtime_error("Could not save to file '" + bundleLoc +
+                                 "'");
+    }
+
+    // Renaming over an existing file fails on Windows
+    if (std::rename(tempLoc.c_str(), bundleLoc.c_str()) != 0)
+    {
+        std::remove(bundleLoc.c_str());
+        if (std::rename(tempLoc.c_str(), bundleLoc.c_str()) != 0)
+        {
+            throw std::runtime_error("Could not save to file '" + bundleLoc +
+                                     "'");
+        }
+    }
+}
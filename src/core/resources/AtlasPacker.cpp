@@ -0,0 +1,68 @@
+#include "core/resources/AtlasPacker.hpp"
+
+#include <algorithm>
+
+AtlasPacker::AtlasPacker(glm::uvec2 pageSize, unsigned int padding)
+    : mPageSize(pageSize), mPadding(padding)
+{
+}
+
+bool AtlasPacker::Insert(glm::uvec2 size, unsigned int* out_page,
+                         glm::uvec2* out_origin)
+{
+    if (size.x > mPageSize.x || size.y > mPageSize.y) return false;
+
+    for (unsigned int i = 0; i < mPages.size(); ++i)
+    {
+        if (InsertInto(mPages[i], size, out_origin))
+        {
+            *out_page = i;
+            return true;
+        }
+    }
+
+    mPages.emplace_back();
+    InsertInto(mPages.back(), size, out_origin);
+    *out_page = mPages.size() - 1;
+    return true;
+}
+
+glm::uvec2 AtlasPacker::GetUsedSize(unsigned int page) const
+{
+    return mPages[page].usedSize;
+}
+
+bool AtlasPacker::InsertInto(Page& page, glm::uvec2 size,
+                             glm::uvec2* out_origin)
+{
+    Shelf* shelf = nullptr;
+    for (Shelf& candidate : page.shelves)
+    {
+        if (size.y <= candidate.height && candidate.x + size.x <= mPageSize.x)
+        {
+            shelf = &candidate;
+            break;
+        }
+    }
+
+    if (!shelf)
+    {
+        unsigned int y = 0;
+        if (!page.shelves.empty())
+        {
+            const Shelf& last = page.shelves.back();
+            y = last.y + last.height + mPadding;
+        }
+        if (y + size.y > mPageSize.y) return false;
+
+        page.shelves.push_back(Shelf{y, size.y, 0});
+        shelf = &page.shelves.back();
+    }
+
+    *out_origin = glm::uvec2(shelf->x, shelf->y);
+    shelf->x += size.x + mPadding;
+
+    page.usedSize.x = std::max(page.usedSize.x, out_origin->x + size.x);
+    page.usedSize.y = std::max(page.usedSize.y, out_origin->y + size.y);
+    return true;
+}
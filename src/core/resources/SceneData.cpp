@@ -0,0 +1,97 @@
+#include "core/resources/SceneData.hpp"
+
+#include <stdexcept>
+
+SceneData::SceneData() {}
+
+SceneString SceneData::AddString(const std::string& string)
+{
+    SceneString stored{(uint32_t)mStrings.size(), (uint32_t)string.size()};
+    mStrings += string;
+    return stored;
+}
+
+void SceneData::Validate() const
+{
+    auto checkString = [this](SceneString string)
+    {
+        if ((uint64_t)string.offset + string.length > mStrings.size())
+        {
+            throw std::invalid_argument("Scene has a bad string.");
+        }
+    };
+
+    for (const SceneResource& resource : mResources)
+    {
+        checkString(resource.name);
+        checkString(resource.fileLoc);
+        if (resource.type != SceneResourceType::Spritesheet &&
+            resource.type != SceneResourceType::Tilemap)
+        {
+            throw std::invalid_argument("Scene has an unknown resource type.");
+        }
+    }
+
+    auto checkResource = [this](uint32_t index, SceneResourceType type)
+    {
+        if (index == SceneComponent::NO_RESOURCE) return;
+        if (index >= mResources.size() || mResources[index].type != type)
+        {
+            throw std::invalid_argument("Scene refers to a bad resource.");
+        }
+    };
+
+    for (const SceneComponent& component : mComponents)
+    {
+        checkResource(component.spritesheet, SceneResourceType::Spritesheet);
+        checkResource(component.tilemap, SceneResourceType::Tilemap);
+        if ((uint64_t)component.firstAnimation + component.animationCount >
+            mAnimations.size())
+        {
+            throw std::invalid_argument("Scene has a bad animation range.");
+        }
+
+        bool bNeedsSheet = component.type == SceneComponentType::Tilemap ||
+                           component.type == SceneComponentType::Sprite ||
+                           component.type == SceneComponentType::Animator;
+        if (bNeedsSheet &&
+            component.spritesheet == SceneComponent::NO_RESOURCE)
+        {
+            throw std::invalid_argument("Scene has a component without a "
+                                        "spritesheet.");
+        }
+        if (component.type == SceneComponentType::Tilemap &&
+            component.tilemap == SceneComponent::NO_RESOURCE)
+        {
+            throw std::invalid_argument("Scene has a tilemap without a map.");
+        }
+        if (component.type < SceneComponentType::Tilemap ||
+            component.type > SceneComponentType::Rect)
+        {
+            throw std::invalid_argument("Scene has an unknown component "
+                                        "type.");
+        }
+    }
+
+    for (size_t i = 0; i < mObjects.size(); ++i)
+    {
+        const SceneObject& object = mObjects[i];
+        checkString(object.name);
+        if ((uint64_t)object.firstComponent + object.componentCount >
+            mComponents.size())
+        {
+            throw std::invalid_argument("Scene has a bad component range.");
+        }
+        // Parents come first, so they exist when their children are created
+        if (object.parent != SceneObject::NO_PARENT &&
+            (object.parent < 0 || (size_t)object.parent >= i))
+        {
+            throw std::invalid_argument("Scene has a bad parent.");
+        }
+    }
+
+    for (const SceneAnimation& animation : mAnimations)
+    {
+        checkString(animation.name);
+    }
+}
@@ -0,0 +1,553 @@
+#include "core/resources/SceneLoader.hpp"
+#include "core/resources/AssetBundle.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+/**
+ * Copy a table of records out of a binary scene.
+ * @param data The scene file
+ * @param dataSize The size of the file, in bytes
+ * @param offset Where the table starts, moved past it
+ * @param count The number of records
+ * @param out_table Filled with the records
+ */
+template <typename RecordT>
+void ReadTable(const char* data, size_t dataSize, size_t* offset,
+               uint32_t count, std::vector<RecordT>& out_table)
+{
+    size_t tableSize = (size_t)count * sizeof(RecordT);
+    if (tableSize > dataSize - *offset)
+    {
+        throw std::invalid_argument("Scene file is truncated.");
+    }
+
+    out_table.resize(count);
+    if (tableSize != 0)
+    {
+        std::memcpy(out_table.data(), data + *offset, tableSize);
+    }
+    *offset += tableSize;
+}
+
+template <typename RecordT>
+void WriteTable(const std::vector<RecordT>& table, std::ostream& out)
+{
+    out.write(reinterpret_cast<const char*>(table.data()),
+              table.size() * sizeof(RecordT));
+}
+
+/**
+ * Reads the arguments of a line of a text scene.
+ */
+class LineReader
+{
+public:
+    LineReader(const std::string& line, unsigned int lineNumber)
+        : mStream(line), mLineNumber(lineNumber)
+    {
+    }
+
+    /**
+     * Read a word
+     * @param out_word Set to the word
+     * @return false if the line has no more words
+     */
+    bool Next(std::string* out_word) { return (bool)(mStream >> *out_word); }
+
+    /**
+     * Read an argument the line must have
+     * @param what What the argument is, for the error
+     */
+    template <typename ValueT>
+    ValueT Required(const char* what)
+    {
+        ValueT value;
+        if (!(mStream >> value)) Fail(std::string("Expected ") + what + ".");
+        return value;
+    }
+
+    /**
+     * Read an argument the line may have
+     * @param fallback The value if the line has no more arguments
+     */
+    template <typename ValueT>
+    ValueT Optional(ValueT fallback)
+    {
+        mStream >> std::ws;
+        if (mStream.eof()) return fallback;
+        return Required<ValueT>("a number");
+    }
+
+    [[noreturn]] void Fail(const std::string& message) const
+    {
+        throw std::invalid_argument("Scene line " +
+                                    std::to_string(mLineNumber) + ": " +
+                                    message);
+    }
+
+private:
+    std::istringstream mStream;
+    unsigned int mLineNumber;
+};
+}  // namespace
+
+SceneLoader::SceneLoader() {}
+SceneLoader::~SceneLoader() {}
+
+void SceneLoader::Load(std::string fileLoc)
+{
+    if (IsLoaded(fileLoc)) return;
+
+    const AssetBundleEntry* bundled =
+        mBundle ? mBundle->Find(fileLoc, AssetType::Scene) : nullptr;
+    if (bundled)
+    {
+        const char* data =
+            reinterpret_cast<const char*>(mBundle->GetFile()->GetData());
+        std::shared_ptr<SceneData> sceneData(new SceneData());
+        LoadBinary(data + bundled->dataOffset, bundled->dataSize, *sceneData);
+        AddResource(fileLoc, std::move(sceneData));
+        return;
+    }
+
+    SceneFormat format;
+    AddResource(fileLoc, Read(fileLoc, &format));
+}
+
+std::shared_ptr<SceneData> SceneLoader::Read(const std::string& fileLoc,
+                                             SceneFormat* out_format)
+{
+    std::ifstream file(fileLoc, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::invalid_argument("Scene file '" + fileLoc +
+                                    "' could not be found.");
+    }
+
+    // Scenes are small, so the whole file is read in one go
+    std::string contents((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+    bool bBinary = contents.size() >= sizeof(SceneFileHeader::MAGIC) &&
+                   std::memcmp(contents.data(), SceneFileHeader::MAGIC,
+                               sizeof(SceneFileHeader::MAGIC)) == 0;
+
+    std::shared_ptr<SceneData> sceneData(new SceneData());
+    if (bBinary)
+    {
+        LoadBinary(contents.data(), contents.size(), *sceneData);
+    }
+    else
+    {
+        std::istringstream text(contents);
+        LoadText(text, *sceneData);
+    }
+
+    *out_format = bBinary ? SceneFormat::Binary : SceneFormat::Text;
+    return sceneData;
+}
+
+void SceneLoader::LoadText(std::istream& in, SceneData& sceneData)
+{
+    std::unordered_map<std::string, uint32_t> resourcesByName;
+    std::unordered_map<std::string, int32_t> objectsByName;
+    SceneObject* object = nullptr;
+    // The last animator of the current object, for its animations
+    int64_t animator = -1;
+
+    std::string line;
+    unsigned int lineNumber = 0;
+    while (std::getline(in, line))
+    {
+        ++lineNumber;
+        LineReader reader(line, lineNumber);
+        std::string keyword;
+        if (!reader.Next(&keyword) || keyword[0] == '#') continue;
+
+        auto findResource = [&](SceneResourceType type) -> uint32_t
+        {
+            std::string name = reader.Required<std::string>("a resource");
+            auto resourceIt = resourcesByName.find(name);
+            if (resourceIt == resourcesByName.end() ||
+                sceneData.mResources[resourceIt->second].type != type)
+            {
+                reader.Fail("Unknown resource '" + name + "'.");
+            }
+            return resourceIt->second;
+        };
+        auto addComponent = [&](SceneComponentType type) -> SceneComponent&
+        {
+            if (!object) reader.Fail("Component outside of an object.");
+
+            SceneComponent component{};
+            component.type = type;
+            component.spritesheet = SceneComponent::NO_RESOURCE;
+            component.tilemap = SceneComponent::NO_RESOURCE;
+            component.firstAnimation = sceneData.mAnimations.size();
+            sceneData.mComponents.push_back(component);
+            object->componentCount++;
+            return sceneData.mComponents.back();
+        };
+
+        if (keyword == "spritesheet" || keyword == "map")
+        {
+            SceneResource resource{};
+            resource.type = keyword == "map" ? SceneResourceType::Tilemap
+                                             : SceneResourceType::Spritesheet;
+            std::string name = reader.Required<std::string>("a name");
+            resource.name = sceneData.AddString(name);
+            resource.fileLoc =
+                sceneData.AddString(reader.Required<std::string>("a path"));
+            if (resource.type == SceneResourceType::Spritesheet)
+            {
+                resource.spriteWidth = reader.Optional<uint32_t>(0);
+                resource.spriteHeight = reader.Optional<uint32_t>(0);
+            }
+
+            if (!resourcesByName.emplace(name, sceneData.mResources.size())
+                     .second)
+            {
+                reader.Fail("Resource '" + name + "' is declared twice.");
+            }
+            sceneData.mResources.push_back(resource);
+        }
+        else if (keyword == "ysort")
+        {
+            sceneData.mYSortedLayers.push_back(
+                reader.Required<int32_t>("a layer"));
+        }
+        else if (keyword == "object")
+        {
+            std::string name;
+            reader.Next(&name);
+            if (!name.empty() &&
+                !objectsByName.emplace(name, sceneData.mObjects.size()).second)
+            {
+                reader.Fail("Object '" + name + "' is declared twice.");
+            }
+
+            SceneObject newObject{};
+            newObject.name = sceneData.AddString(name);
+            newObject.parent = SceneObject::NO_PARENT;
+            newObject.firstComponent = sceneData.mComponents.size();
+            sceneData.mObjects.push_back(newObject);
+            object = &sceneData.mObjects.back();
+            animator = -1;
+        }
+        else if (keyword == "position" || keyword == "parent")
+        {
+            if (!object) reader.Fail("'" + keyword + "' outside of an object.");
+
+            if (keyword == "position")
+            {
+                object->x = reader.Required<float>("x");
+                object->y = reader.Required<float>("y");
+                continue;
+            }
+            std::string name = reader.Required<std::string>("a parent");
+            auto parentIt = objectsByName.find(name);
+            if (parentIt == objectsByName.end())
+            {
+                reader.Fail("Unknown object '" + name +
+                            "', parents must come first.");
+            }
+            object->parent = parentIt->second;
+        }
+        else if (keyword == "tilemap")
+        {
+            uint32_t tilemap = findResource(SceneResourceType::Tilemap);
+            uint32_t spritesheet = findResource(SceneResourceType::Spritesheet);
+            SceneComponent& component =
+                addComponent(SceneComponentType::Tilemap);
+            component.tilemap = tilemap;
+            component.spritesheet = spritesheet;
+            component.width = reader.Required<float>("a tile width");
+            component.height = reader.Required<float>("a tile height");
+            component.layer = reader.Optional<int32_t>(0);
+        }
+        else if (keyword == "tilemap_collider")
+        {
+            addComponent(SceneComponentType::TilemapCollider);
+        }
+        else if (keyword == "controller")
+        {
+            SceneComponent& component =
+                addComponent(SceneComponentType::Controller);
+            component.speed = reader.Optional<float>(0);
+        }
+        else if (keyword == "sprite" || keyword == "animator")
+        {
+            uint32_t spritesheet = findResource(SceneResourceType::Spritesheet);
+            bool bAnimator = keyword == "animator";
+            SceneComponent& component =
+                addComponent(bAnimator ? SceneComponentType::Animator
+                                       : SceneComponentType::Sprite);
+            component.spritesheet = spritesheet;
+            component.width = reader.Required<float>("a width");
+            component.height = reader.Required<float>("a height");
+            component.layer = reader.Optional<int32_t>(0);
+            if (bAnimator)
+                animator = sceneData.mComponents.size() - 1;
+            else
+                component.spriteIndex = reader.Optional<uint32_t>(0);
+        }
+        else if (keyword == "animation")
+        {
+            if (animator < 0) reader.Fail("Animation without an animator.");
+
+            SceneAnimation animation{};
+            animation.name =
+                sceneData.AddString(reader.Required<std::string>("a name"));
+            animation.spritesheetRow = reader.Required<uint32_t>("a row");
+            animation.frameCount = reader.Required<uint32_t>("a frame count");
+            animation.frameDuration = reader.Optional<float>(0.2f);
+            sceneData.mAnimations.push_back(animation);
+            sceneData.mComponents[animator].animationCount++;
+        }
+        else if (keyword == "sprite_collider")
+        {
+            SceneComponent& component =
+                addComponent(SceneComponentType::SpriteCollider);
+            std::string option;
+            if (reader.Next(&option))
+            {
+                if (option != "trigger")
+                    reader.Fail("Unknown option '" + option + "'.");
+                component.flags |= SceneComponent::FLAG_TRIGGER;
+            }
+        }
+        else if (keyword == "rect")
+        {
+            SceneComponent& component = addComponent(SceneComponentType::Rect);
+            component.width = reader.Required<float>("a width");
+            component.height = reader.Required<float>("a height");
+            for (int channel = 0; channel < 3; ++channel)
+            {
+                component.color[channel] = reader.Required<int>("a color");
+            }
+            component.color[3] = reader.Optional<int>(0xFF);
+            component.layer = reader.Optional<int32_t>(0);
+        }
+        else
+        {
+            reader.Fail("Unknown keyword '" + keyword + "'.");
+        }
+    }
+
+    sceneData.Validate();
+}
+
+void SceneLoader::LoadBinary(const char* data, size_t dataSize,
+                             SceneData& sceneData)
+{
+    SceneFileHeader header;
+    if (dataSize < sizeof(header))
+    {
+        throw std::invalid_argument("Scene file is truncated.");
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.magic, SceneFileHeader::MAGIC,
+                    sizeof(header.magic)) != 0)
+    {
+        throw std::invalid_argument("File is not a binary scene.");
+    }
+    if (header.version != SceneFileHeader::VERSION)
+    {
+        throw std::invalid_argument("Scene version " +
+                                    std::to_string(header.version) +
+                                    " is not supported.");
+    }
+
+    size_t offset = sizeof(header);
+    ReadTable(data, dataSize, &offset, header.resourceCount,
+              sceneData.mResources);
+    ReadTable(data, dataSize, &offset, header.objectCount, sceneData.mObjects);
+    ReadTable(data, dataSize, &offset, header.componentCount,
+              sceneData.mComponents);
+    ReadTable(data, dataSize, &offset, header.animationCount,
+              sceneData.mAnimations);
+    ReadTable(data, dataSize, &offset, header.ySortedLayerCount,
+              sceneData.mYSortedLayers);
+    if (header.stringsSize > dataSize - offset)
+    {
+        throw std::invalid_argument("Scene file is truncated.");
+    }
+    sceneData.mStrings.assign(data + offset, header.stringsSize);
+
+    sceneData.Validate();
+}
+
+void SceneLoader::Write(const SceneData& sceneData, const std::string& fileLoc,
+                        SceneFormat format)
+{
+    std::string tempLoc = fileLoc + ".tmp";
+    std::ofstream outFile(tempLoc, std::ios::binary);
+
+    if (!outFile.is_open())
+    {
+        throw std::runtime_error("Could not save to file '" + fileLoc + "'");
+    }
+
+    if (format == SceneFormat::Binary)
+        WriteBinary(sceneData, outFile);
+    else
+        WriteText(sceneData, outFile);
+
+    outFile.close();
+    if (!outFile)
+    {
+        std::remove(tempLoc.c_str());
+        throw std::runtime_error("Could not save to file '" + fileLoc + "'");
+    }
+
+    // Renaming over an existing file fails on Windows
+    if (std::rename(tempLoc.c_str(), fileLoc.c_str()) != 0)
+    {
+        std::remove(fileLoc.c_str());
+        if (std::rename(tempLoc.c_str(), fileLoc.c_str()) != 0)
+        {
+            throw std::runtime_error("Could not save to file '" + fileLoc +
+                                     "'");
+        }
+    }
+}
+
+void SceneLoader::WriteText(const SceneData& sceneData, std::ostream& out)
+{
+    // Enough digits for every float to read back the same
+    out.precision(9);
+
+    const std::vector<SceneResource>& resources = sceneData.GetResources();
+    for (const SceneResource& resource : resources)
+    {
+        bool bSpritesheet = resource.type == SceneResourceType::Spritesheet;
+        out << (bSpritesheet ? "spritesheet " : "map ")
+            << sceneData.GetString(resource.name) << ' '
+            << sceneData.GetString(resource.fileLoc);
+        if (bSpritesheet && resource.spriteWidth != 0)
+        {
+            out << ' ' << resource.spriteWidth << ' ' << resource.spriteHeight;
+        }
+        out << '\n';
+    }
+    for (int32_t layer : sceneData.GetYSortedLayers())
+    {
+        out << "ysort " << layer << '\n';
+    }
+
+    const std::vector<SceneObject>& objects = sceneData.GetObjects();
+    // Parents without a name are named by their index
+    auto objectName = [&](size_t objectIdx)
+    {
+        std::string name = sceneData.GetString(objects[objectIdx].name);
+        return name.empty() ? "object" + std::to_string(objectIdx) : name;
+    };
+    std::vector<bool> bIsParent(objects.size(), false);
+    for (const SceneObject& object : objects)
+    {
+        if (object.parent != SceneObject::NO_PARENT)
+            bIsParent[object.parent] = true;
+    }
+
+    auto resourceName = [&](uint32_t index)
+    { return sceneData.GetString(resources[index].name); };
+    for (size_t objectIdx = 0; objectIdx < objects.size(); ++objectIdx)
+    {
+        const SceneObject& object = objects[objectIdx];
+        std::string name = sceneData.GetString(object.name);
+        if (name.empty() && bIsParent[objectIdx]) name = objectName(objectIdx);
+
+        out << '\n' << "object" << (name.empty() ? "" : " ") << name << '\n';
+        out << "position " << object.x << ' ' << object.y << '\n';
+        if (object.parent != SceneObject::NO_PARENT)
+        {
+            out << "parent " << objectName(object.parent) << '\n';
+        }
+
+        for (uint32_t i = 0; i < object.componentCount; ++i)
+        {
+            const SceneComponent& component =
+                sceneData.GetComponents()[object.firstComponent + i];
+            switch (component.type)
+            {
+            case SceneComponentType::Tilemap:
+                out << "tilemap " << resourceName(component.tilemap) << ' '
+                    << resourceName(component.spritesheet) << ' '
+                    << component.width << ' ' << component.height << ' '
+                    << component.layer << '\n';
+                break;
+            case SceneComponentType::TilemapCollider:
+                out << "tilemap_collider\n";
+                break;
+            case SceneComponentType::Controller:
+                out << "controller " << component.speed << '\n';
+                break;
+            case SceneComponentType::Sprite:
+                out << "sprite " << resourceName(component.spritesheet) << ' '
+                    << component.width << ' ' << component.height << ' '
+                    << component.layer << ' ' << component.spriteIndex
+                    << '\n';
+                break;
+            case SceneComponentType::Animator:
+                out << "animator " << resourceName(component.spritesheet)
+                    << ' ' << component.width << ' ' << component.height
+                    << ' ' << component.layer << '\n';
+                for (uint32_t j = 0; j < component.animationCount; ++j)
+                {
+                    const SceneAnimation& animation =
+                        sceneData
+                            .GetAnimations()[component.firstAnimation + j];
+                    out << "animation " << sceneData.GetString(animation.name)
+                        << ' ' << animation.spritesheetRow << ' '
+                        << animation.frameCount << ' '
+                        << animation.frameDuration << '\n';
+                }
+                break;
+            case SceneComponentType::SpriteCollider:
+                out << "sprite_collider";
+                if (component.flags & SceneComponent::FLAG_TRIGGER)
+                    out << " trigger";
+                out << '\n';
+                break;
+            case SceneComponentType::Rect:
+                out << "rect " << component.width << ' ' << component.height;
+                for (uint8_t channel : component.color)
+                {
+                    out << ' ' << (int)channel;
+                }
+                out << ' ' << component.layer << '\n';
+                break;
+            }
+        }
+    }
+}
+
+void SceneLoader::WriteBinary(const SceneData& sceneData, std::ostream& out)
+{
+    SceneFileHeader header{};
+    std::memcpy(header.magic, SceneFileHeader::MAGIC, sizeof(header.magic));
+    header.version = SceneFileHeader::VERSION;
+    header.resourceCount = sceneData.GetResources().size();
+    header.objectCount = sceneData.GetObjects().size();
+    header.componentCount = sceneData.GetComponents().size();
+    header.animationCount = sceneData.GetAnimations().size();
+    header.ySortedLayerCount = sceneData.GetYSortedLayers().size();
+    header.stringsSize = sceneData.mStrings.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    WriteTable(sceneData.GetResources(), out);
+    WriteTable(sceneData.GetObjects(), out);
+    WriteTable(sceneData.GetComponents(), out);
+    WriteTable(sceneData.GetAnimations(), out);
+    WriteTable(sceneData.GetYSortedLayers(), out);
+    out.write(sceneData.mStrings.data(), sceneData.mStrings.size());
+}
@@ -0,0 +1,151 @@
+#include "core/resources/SceneResources.hpp"
+#include "core/ResourceManager.hpp"
+#include "core/resources/Spritesheet.hpp"
+#include "core/resources/TilemapData.hpp"
+
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+
+SceneResources::SceneResources(const std::string& sceneLoc, size_t memoryCap)
+    : mSceneLoc(sceneLoc), mMemoryCap(memoryCap)
+{
+    SceneLoader* scenes = ResourceManager::instance().Scenes();
+    scenes->Load(sceneLoc);
+    mSceneHandle = scenes->Acquire(sceneLoc);
+    mScene = scenes->Get(mSceneHandle);
+
+    const std::vector<SceneResource>& sceneResources = mScene->GetResources();
+    mResources.resize(sceneResources.size());
+    for (size_t i = 0; i < sceneResources.size(); ++i)
+    {
+        mResources[i].type = sceneResources[i].type;
+        mResources[i].fileLoc = mScene->GetString(sceneResources[i].fileLoc);
+    }
+}
+
+SceneResources::~SceneResources()
+{
+    ResourceManager& resourceManager = ResourceManager::instance();
+    for (LoadedResource& resource : mResources)
+    {
+        // Loads still in flight finish on their own, unreferenced
+        resourceManager.Tilemaps()->Release(resource.tilemap);
+        if (!resource.spritesheet.IsValid()) continue;
+
+        resourceManager.Spritesheets()->Release(resource.spritesheet);
+        // The texture of a freed sheet is no use to anyone else
+        if (!resourceManager.Spritesheets()->IsLoaded(resource.fileLoc))
+        {
+            resourceManager.Textures()->FreeUnreferenced(resource.fileLoc);
+        }
+    }
+    resourceManager.Scenes()->Release(mSceneHandle);
+}
+
+std::shared_ptr<Spritesheet> SceneResources::GetSpritesheet(
+    uint32_t resourceIndex) const
+{
+    if (resourceIndex >= mResources.size()) return nullptr;
+
+    return ResourceManager::instance().Spritesheets()->Get(
+        mResources[resourceIndex].spritesheet);
+}
+
+void SceneResources::Update(int frameIdx, bool bIgnoreCap)
+{
+    TextureLoader* textures = ResourceManager::instance().Textures();
+    for (size_t i = 0; i < mNextLoad && mError.empty(); ++i)
+    {
+        LoadedResource& resource = mResources[i];
+        if (!resource.bFinished &&
+            resource.load.wait_for(std::chrono::seconds(0)) ==
+                std::future_status::ready)
+        {
+            Finish(resource);
+        }
+        if (resource.texture.IsValid())
+        {
+            textures->Use(resource.texture, frameIdx);
+        }
+    }
+
+    while (mError.empty() && mNextLoad < mResources.size())
+    {
+        bool bInFlight = mFinishedCount < mNextLoad;
+        bool bOverCap = mMemoryCap != 0 && mMemoryUsage >= mMemoryCap;
+        if (!bIgnoreCap && (bInFlight || bOverCap)) break;
+
+        LoadedResource& resource = mResources[mNextLoad++];
+        Start(resource);
+        // Shared resources are ready right away
+        if (resource.load.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready)
+        {
+            Finish(resource);
+        }
+    }
+}
+
+void SceneResources::Start(LoadedResource& resource)
+{
+    ResourceManager& resourceManager = ResourceManager::instance();
+    if (resource.type == SceneResourceType::Spritesheet)
+    {
+        resource.bShared =
+            resourceManager.Spritesheets()->IsLoaded(resource.fileLoc);
+        resource.load =
+            resourceManager.Spritesheets()->LoadAsync(resource.fileLoc);
+    }
+    else
+    {
+        resource.bShared =
+            resourceManager.Tilemaps()->IsLoaded(resource.fileLoc);
+        resource.load = resourceManager.Tilemaps()->LoadAsync(resource.fileLoc);
+    }
+}
+
+void SceneResources::Finish(LoadedResource& resource)
+{
+    resource.bFinished = true;
+    mFinishedCount++;
+    try
+    {
+        resource.load.get();
+    }
+    catch (const std::exception& e)
+    {
+        mError = "'" + resource.fileLoc + "': " + e.what();
+        return;
+    }
+
+    ResourceManager& resourceManager = ResourceManager::instance();
+    size_t bytes = 0;
+    if (resource.type == SceneResourceType::Spritesheet)
+    {
+        resource.spritesheet =
+            resourceManager.Spritesheets()->Acquire(resource.fileLoc);
+        // Packed sheets have given up the texture of their file
+        TextureLoader* textures = resourceManager.Textures();
+        if (textures->IsLoaded(resource.fileLoc))
+        {
+            resource.texture = textures->LoadHandle(resource.fileLoc);
+            bytes = textures->GetMemoryUsage(resource.texture);
+        }
+    }
+    else
+    {
+        resource.tilemap =
+            resourceManager.Tilemaps()->Acquire(resource.fileLoc);
+        std::shared_ptr<TilemapData> mapData =
+            resourceManager.Tilemaps()->Get(resource.tilemap);
+        if (mapData) bytes = mapData->GetMemoryUsage();
+    }
+
+    if (!resource.spritesheet.IsValid() && !resource.tilemap.IsValid())
+    {
+        mError = "'" + resource.fileLoc + "' could not be loaded";
+        return;
+    }
+    if (!resource.bShared) mMemoryUsage += bytes;
+}
@@ -5,19 +5,34 @@
 Spritesheet::Spritesheet(std::shared_ptr<SDL_Texture> texture)
     : mTexture(texture), mSize(1, 1)
 {
-    int width, height;
+    int width = 0, height = 0;
     SDL_QueryTexture(mTexture.get(), NULL, NULL, &width, &height);
-    mTextureSize = mSpriteSize = Size2D{width, height};
+    mTextureSize = mRegionSize = mSpriteSize = Size2D{width, height};
+}
+
+Spritesheet::Spritesheet(TextureLoader* textureLoader,
+                         const std::string& fileLoc)
+    : mSize(1, 1)
+{
+    UseFileTexture(textureLoader, fileLoc);
+    mSpriteSize = mRegionSize;
 }
 
 Spritesheet::Spritesheet(Spritesheet&& other) noexcept
 {
     mTexture = std::move(other.mTexture);
     other.mTexture = NULL;
+    mTextureLoader = other.mTextureLoader;
+    mFileLoc = std::move(other.mFileLoc);
+    mTextureHandle = other.mTextureHandle;
+    other.mTextureLoader = nullptr;
 
     mTextureSize = other.mTextureSize;
+    mOrigin = other.mOrigin;
+    mRegionSize = other.mRegionSize;
     mSize = other.mSize;
     mSpriteSize = other.mSpriteSize;
+    mLayoutVersion = other.mLayoutVersion;
 }
 
 Spritesheet::~Spritesheet()
@@ -28,28 +43,99 @@ Spritesheet::~Spritesheet()
 void Spritesheet::SetSpriteSize(Size2D size)
 {
     mSpriteSize = size;
+    mLayoutVersion++;
 
-    mSize.x = mTextureSize.x / mSpriteSize.x;
-    mSize.y = mTextureSize.y / mSpriteSize.y;
+    mSize.x = mRegionSize.x / mSpriteSize.x;
+    mSize.y = mRegionSize.y / mSpriteSize.y;
 }
 
-void Spritesheet::DrawTileAt(RenderContext* renderContext,
-                             unsigned int tileIndex, SDL_Rect& dest,
-                             bool hasCollider)
+void Spritesheet::MoveToTexture(std::shared_ptr<SDL_Texture> texture,
+                                Size2D textureSize, Size2D origin)
+{
+    mTexture = std::move(texture);
+    mTextureLoader = nullptr;
+    mTextureHandle = TextureLoader::Handle();
+    mTextureSize = textureSize;
+    mOrigin = origin;
+    mLayoutVersion++;
+}
+
+void Spritesheet::UseFileTexture(TextureLoader* textureLoader,
+                                 const std::string& fileLoc)
+{
+    mTexture.reset();
+    mTextureLoader = textureLoader;
+    mFileLoc = fileLoc;
+    mTextureHandle = mTextureLoader->LoadHandle(mFileLoc);
+
+    int width = 0, height = 0;
+    SDL_QueryTexture(GetTexture(), NULL, NULL, &width, &height);
+    mTextureSize = mRegionSize = Size2D{width, height};
+    mOrigin = Size2D{0, 0};
+    mLayoutVersion++;
+    if (mSpriteSize.x != 0 && mSpriteSize.y != 0) SetSpriteSize(mSpriteSize);
+}
+
+SDL_Texture* Spritesheet::GetTexture()
+{
+    if (!mTextureLoader) return mTexture.get();
+
+    // Only drawing counts as a use for eviction, and only drawing reloads
+    return mTextureLoader->Get(mTextureHandle).get();
+}
+
+SDL_Texture* Spritesheet::UseTexture(RenderContext* renderContext)
+{
+    if (!mTextureLoader) return mTexture.get();
+
+    SDL_Texture* texture =
+        mTextureLoader->Use(mTextureHandle, renderContext->frameIdx);
+    if (texture) return texture;
+
+    // Evicted since it was last drawn
+    renderContext->RunOnRenderer(
+        [this](SDL_Renderer*)
+        { mTextureHandle = mTextureLoader->LoadHandle(mFileLoc); });
+    return mTextureLoader->Use(mTextureHandle, renderContext->frameIdx);
+}
+
+SDL_Rect Spritesheet::GetSourceRect(unsigned int spriteIndex)
 {
     SDL_Rect src;
     // Reverse lookup, given the tile type
     // and then figuring out how to select it
     // from the texture atlas.
-    src.x = (tileIndex % mSize.x) * mSpriteSize.x;
-    src.y = (tileIndex / mSize.x) * mSpriteSize.y;
+    src.x = mOrigin.x + (spriteIndex % mSize.x) * mSpriteSize.x;
+    src.y = mOrigin.y + (spriteIndex / mSize.x) * mSpriteSize.y;
     src.w = mSpriteSize.x;
     src.h = mSpriteSize.y;
+    return src;
+}
+
+void Spritesheet::DrawTileAt(RenderContext* renderContext,
+                             unsigned int tileIndex, SDL_Rect& dest,
+                             bool hasCollider, int layer,
+                             unsigned int depth)
+{
+    DrawRegionAt(renderContext, GetSourceRect(tileIndex), dest, layer, depth);
+}
+void Spritesheet::DrawRegionAt(RenderContext* renderContext,
+                               const SDL_Rect& src, SDL_Rect& dest, int layer,
+                               unsigned int depth)
+{
+    SDL_Texture* texture = UseTexture(renderContext);
+    if (renderContext->spriteBatch)
+    {
+        renderContext->spriteBatch->Draw(texture, mTextureSize, src, dest,
+                                         layer, depth);
+        return;
+    }
 
-    SDL_RenderCopy(renderContext->renderer, mTexture.get(), &src, &dest);
+    SDL_RenderCopy(renderContext->renderer, texture, &src, &dest);
 }
 void Spritesheet::DrawSpriteAt(RenderContext* renderContext,
-                               unsigned int spriteIndex, SDL_Rect& dest)
+                               unsigned int spriteIndex, SDL_Rect& dest,
+                               int layer, unsigned int depth)
 {
-    DrawTileAt(renderContext, spriteIndex, dest);
+    DrawTileAt(renderContext, spriteIndex, dest, false, layer, depth);
 }
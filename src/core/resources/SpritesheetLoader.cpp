@@ -1,10 +1,15 @@
 #include "core/resources/SpritesheetLoader.hpp"
+#include "core/resources/AssetBundle.hpp"
+#include "core/resources/AtlasPacker.hpp"
 #include "core/resources/Spritesheet.hpp"
 
+#include <algorithm>
+#include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <vector>
 
-SpritesheetLoader::SpritesheetLoader(ResourceLoader<SDL_Texture>* textureLoader)
+SpritesheetLoader::SpritesheetLoader(TextureLoader* textureLoader)
 {
     if (!textureLoader)
     {
@@ -19,14 +24,178 @@ SpritesheetLoader::~SpritesheetLoader() {}
 
 void SpritesheetLoader::Load(std::string fileLoc)
 {
-    if (mResources.count(fileLoc) != 0) return;
+    if (IsLoaded(fileLoc)) return;
 
     mTextureLoader->Load(fileLoc);
+    AddSpritesheet(fileLoc);
+}
+
+std::shared_future<void> SpritesheetLoader::LoadAsync(std::string fileLoc)
+{
+    if (IsLoaded(fileLoc)) return MakeReadyFuture();
+
+    auto pendingIt = mPending.find(fileLoc);
+    if (pendingIt != mPending.end()) return pendingIt->second;
+
+    auto loaded = std::make_shared<std::promise<void>>();
+    std::shared_future<void> future = loaded->get_future().share();
+    mPending.emplace(fileLoc, future);
 
-    std::shared_ptr<SDL_Texture> texture = mTextureLoader->Get(fileLoc);
+    mTextureLoader->LoadAsync(
+        fileLoc,
+        [this, fileLoc, loaded](std::exception_ptr error)
+        {
+            mPending.erase(fileLoc);
+            if (error)
+            {
+                loaded->set_exception(error);
+                return;
+            }
 
-    Spritesheet* spritesheet = new Spritesheet(texture);
+            // Unless it was loaded synchronously in the meantime
+            if (!IsLoaded(fileLoc)) AddSpritesheet(fileLoc);
+            loaded->set_value();
+        });
+    return future;
+}
+
+void SpritesheetLoader::AddSpritesheet(const std::string& fileLoc)
+{
+    Spritesheet* spritesheet = new Spritesheet(mTextureLoader, fileLoc);
     std::shared_ptr<Spritesheet> spritesheetResource(spritesheet);
 
-    mResources.emplace(fileLoc, std::move(spritesheetResource));
+    const BakedTextureHeader* baked =
+        mBundle ? mBundle->FindTexture(fileLoc) : nullptr;
+    if (baked && baked->spriteWidth != 0 && baked->spriteHeight != 0)
+    {
+        spritesheet->SetSpriteSize({baked->spriteWidth, baked->spriteHeight});
+    }
+
+    AddResource(fileLoc, std::move(spritesheetResource));
+}
+
+void SpritesheetLoader::RefreshTexture(const std::string& fileLoc)
+{
+    std::shared_ptr<Spritesheet> spritesheet = Get(fileLoc);
+    if (spritesheet) spritesheet->UseFileTexture(mTextureLoader, fileLoc);
+}
+
+void SpritesheetLoader::PackAtlas(SDL_Renderer* renderer, unsigned int pageSize)
+{
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) == 0 &&
+        info.max_texture_width > 0 && info.max_texture_height > 0)
+    {
+        pageSize = std::min<unsigned int>(
+            pageSize,
+            std::min(info.max_texture_width, info.max_texture_height));
+    }
+
+    struct Placement
+    {
+        std::string fileLoc;
+        Spritesheet* sheet;
+        unsigned int page;
+        Size2D origin;
+    };
+
+    // A sheet still using the texture of its file is not packed yet
+    std::vector<Placement> placements;
+    for (ResourceSlot& slot : mSlots)
+    {
+        if (!slot.resource || !slot.resource->UsesFileTexture()) continue;
+
+        placements.push_back(
+            Placement{slot.fileLoc, slot.resource.get(), 0, {0, 0}});
+    }
+
+    // Shelves pack best when the tallest sheets go first
+    std::sort(placements.begin(), placements.end(),
+              [](const Placement& lhs, const Placement& rhs)
+              {
+                  return lhs.sheet->GetRegionSize().y >
+                         rhs.sheet->GetRegionSize().y;
+              });
+
+    AtlasPacker packer(Size2D(pageSize, pageSize));
+    std::vector<unsigned int> sheetsPerPage;
+    for (auto it = placements.begin(); it != placements.end();)
+    {
+        if (!packer.Insert(it->sheet->GetRegionSize(), &it->page,
+                           &it->origin))
+        {
+            it = placements.erase(it);
+            continue;
+        }
+        sheetsPerPage.resize(packer.GetPageCount(), 0);
+        sheetsPerPage[it->page]++;
+        ++it;
+    }
+
+    // Pages are put together from the images of the sheets, then uploaded
+    // as static textures. Render targets would lose the atlas whenever the
+    // renderer resets them (see Component::HandleRenderTargetsReset)
+    unsigned int packedCount = 0, pageCount = 0;
+    for (unsigned int page = 0; page < packer.GetPageCount(); ++page)
+    {
+        // A page with a single sheet would not save any texture switches
+        if (sheetsPerPage[page] < 2) continue;
+
+        Size2D pageUsed = packer.GetUsedSize(page);
+        // Starts out transparent
+        SDL_Surface* pageSurface = SDL_CreateRGBSurfaceWithFormat(
+            0, pageUsed.x, pageUsed.y, 32, SDL_PIXELFORMAT_RGBA8888);
+        if (!pageSurface)
+        {
+            SDL_Log("Could not create atlas page: %s", SDL_GetError());
+            break;
+        }
+
+        std::vector<Placement*> pagePlacements;
+        for (Placement& placement : placements)
+        {
+            if (placement.page != page) continue;
+
+            SDL_Surface* image = mTextureLoader->ReadSurface(placement.fileLoc);
+            if (!image) continue;
+            Size2D regionSize = placement.sheet->GetRegionSize();
+            SDL_Rect src{0, 0, (int)regionSize.x, (int)regionSize.y};
+            SDL_Rect dest{(int)placement.origin.x, (int)placement.origin.y,
+                          (int)regionSize.x, (int)regionSize.y};
+
+            // Copy the pixels as they are, including alpha
+            SDL_SetSurfaceBlendMode(image, SDL_BLENDMODE_NONE);
+            int result = SDL_BlitSurface(image, &src, pageSurface, &dest);
+            SDL_FreeSurface(image);
+            if (result == 0) pagePlacements.push_back(&placement);
+        }
+
+        SDL_Texture* pageTexture =
+            SDL_CreateTextureFromSurface(renderer, pageSurface);
+        SDL_FreeSurface(pageSurface);
+        if (!pageTexture)
+        {
+            // Keep the separate textures
+            SDL_Log("Could not create atlas texture: %s", SDL_GetError());
+            break;
+        }
+        SDL_SetTextureBlendMode(pageTexture, SDL_BLENDMODE_BLEND);
+
+        // Shared by the sheets on the page, freed with the last of them
+        std::shared_ptr<SDL_Texture> atlas = mTextureLoader->AdoptTexture(
+            pageTexture, "atlas page " + std::to_string(page));
+        for (Placement* placement : pagePlacements)
+        {
+            placement->sheet->MoveToTexture(atlas, pageUsed,
+                                            placement->origin);
+            std::shared_ptr<SDL_Texture> loaded =
+                mTextureLoader->Get(placement->fileLoc);
+            mTextureLoader->Destroy(loaded);
+            packedCount++;
+        }
+        pageCount++;
+    }
+
+    std::cout << "Packed " << packedCount << " spritesheet(s) into "
+              << pageCount << " atlas texture(s)\n";
 }
@@ -1,20 +1,43 @@
 #include "core/resources/TextureLoader.hpp"
+#include "core/resources/AssetBundle.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
+#include <utility>
 #if defined(LINUX) || defined(MINGW)
 #include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
 #else  // This works for Mac
 #include <SDL.h>
+#include <SDL_image.h>
 #endif
 
-TextureLoader::TextureLoader(SDL_Renderer* renderer) { mRenderer = renderer; }
-TextureLoader::~TextureLoader() {}
+namespace
+{
+// How long to wait after an eviction that could not get under budget
+constexpr int EVICTION_RETRY_FRAMES = 60;
+}  // namespace
+
+TextureLoader::TextureLoader(SDL_Renderer* renderer, util::ThreadPool* workers)
+{
+    mRenderer = renderer;
+    mWorkers = workers;
+}
+TextureLoader::~TextureLoader()
+{
+    // The workers are stopped by now, but their last images may be queued
+    for (DecodedImage& image : mDecoded)
+    {
+        if (image.surface) SDL_FreeSurface(image.surface);
+    }
+}
 
 void TextureLoader::Load(std::string fileLoc)
 {
-    if (mResources.count(fileLoc) != 0) return;
+    if (IsLoaded(fileLoc)) return;
 
-    SDL_Surface* surface = SDL_LoadBMP(fileLoc.c_str());
+    SDL_Surface* surface = ReadSurface(fileLoc);
 
     if (surface == nullptr)
     {
@@ -22,30 +45,263 @@ void TextureLoader::Load(std::string fileLoc)
     }
     else
     {
-        std::cout << "SDL_LoadBMP allocated\n";
+        std::cout << "Surface allocated\n";
     }
 
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(mRenderer, surface);
+    AddTexture(fileLoc, surface);
 
-    if (nullptr == texture)
+    SDL_FreeSurface(surface);
+    std::cout << "Surface freed\n";
+}
+
+SDL_Surface* TextureLoader::ReadSurface(const std::string& fileLoc) const
+{
+    if (mBundle)
     {
-        std::cerr << "Error creating texture\n";
+        SDL_Surface* surface = mBundle->CreateSurface(fileLoc);
+        if (surface) return surface;
     }
-    else
+    return DecodeFile(fileLoc);
+}
+
+SDL_Surface* TextureLoader::DecodeFile(const std::string& fileLoc)
+{
+    // Picks the decoder by the contents of the file, BMP included
+    return IMG_Load(fileLoc.c_str());
+}
+
+std::shared_future<void> TextureLoader::LoadAsync(std::string fileLoc)
+{
+    return LoadAsync(fileLoc, nullptr);
+}
+
+std::shared_future<void> TextureLoader::LoadAsync(std::string fileLoc,
+                                                  LoadCallback onLoaded)
+{
+    if (IsLoaded(fileLoc))
+    {
+        if (onLoaded) onLoaded(nullptr);
+        return MakeReadyFuture();
+    }
+
+    auto pendingIt = mPending.find(fileLoc);
+    if (pendingIt == mPending.end())
     {
-        std::cout << "SDL_Texture allocated\n";
+        pendingIt = mPending.emplace(fileLoc, PendingLoad()).first;
+        PendingLoad& pending = pendingIt->second;
+        pending.future = pending.promise.get_future().share();
+
+        mWorkers->Submit([this, fileLoc] { Decode(fileLoc); });
     }
 
+    if (onLoaded) pendingIt->second.callbacks.push_back(std::move(onLoaded));
+    return pendingIt->second.future;
+}
+
+void TextureLoader::Decode(const std::string& fileLoc)
+{
+    DecodedImage image{fileLoc, ReadSurface(fileLoc), ""};
+    if (!image.surface)
+    {
+        image.error = "Could not load texture '" + fileLoc +
+                      "': " + SDL_GetError();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mDecodedMutex);
+        mDecoded.push_back(std::move(image));
+    }
+    mDecodedReady.notify_one();
+}
+
+unsigned int TextureLoader::ProcessUploads(double budgetMs)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 budgetTicks = budgetMs * SDL_GetPerformanceFrequency() / 1000;
+
+    unsigned int uploadCount = 0;
+    while (true)
+    {
+        DecodedImage image;
+        {
+            std::lock_guard<std::mutex> lock(mDecodedMutex);
+            if (mDecoded.empty()) break;
+
+            image = std::move(mDecoded.front());
+            mDecoded.pop_front();
+        }
+
+        std::exception_ptr error;
+        if (!image.surface)
+        {
+            error = std::make_exception_ptr(std::runtime_error(image.error));
+        }
+        else if (!IsLoaded(image.fileLoc) &&
+                 !AddTexture(image.fileLoc, image.surface))
+        {
+            error = std::make_exception_ptr(std::runtime_error(
+                "Could not create texture for '" + image.fileLoc + "'"));
+        }
+        if (image.surface) SDL_FreeSurface(image.surface);
+        uploadCount++;
+
+        auto pendingIt = mPending.find(image.fileLoc);
+        if (pendingIt != mPending.end())
+        {
+            PendingLoad pending = std::move(pendingIt->second);
+            mPending.erase(pendingIt);
+
+            if (error)
+                pending.promise.set_exception(error);
+            else
+                pending.promise.set_value();
+            for (LoadCallback& callback : pending.callbacks) callback(error);
+        }
+
+        if (budgetMs >= 0 && SDL_GetPerformanceCounter() - start >= budgetTicks)
+            break;
+    }
+    return uploadCount;
+}
+
+void TextureLoader::WaitForDecodes()
+{
+    if (mPending.empty()) return;
+
+    std::unique_lock<std::mutex> lock(mDecodedMutex);
+    mDecodedReady.wait(lock, [this] { return !mDecoded.empty(); });
+}
+
+bool TextureLoader::AddTexture(const std::string& fileLoc,
+                               SDL_Surface* surface)
+{
+    std::shared_ptr<SDL_Texture> texture = CreateTexture(fileLoc, surface);
+    if (!texture) return false;
+
     std::cout << "New copy of " << fileLoc << " has been loaded\n";
-    std::shared_ptr<SDL_Texture> textureResource(
+    AddResource(fileLoc, std::move(texture));
+    UpdateUsage(fileLoc);
+    return true;
+}
+
+bool TextureLoader::ReplaceTexture(const std::string& fileLoc,
+                                   SDL_Surface* surface)
+{
+    std::shared_ptr<SDL_Texture> texture = CreateTexture(fileLoc, surface);
+    if (!texture) return false;
+
+    std::cout << "New copy of " << fileLoc << " has been reloaded\n";
+    ReplaceResource(fileLoc, std::move(texture));
+    UpdateUsage(fileLoc);
+    return true;
+}
+
+std::shared_ptr<SDL_Texture> TextureLoader::CreateTexture(
+    const std::string& fileLoc, SDL_Surface* surface)
+{
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(mRenderer, surface);
+
+    if (nullptr == texture)
+    {
+        std::cerr << "Error creating texture\n";
+        return nullptr;
+    }
+    std::cout << "SDL_Texture allocated\n";
+
+    return AdoptTexture(texture, fileLoc);
+}
+
+std::shared_ptr<SDL_Texture> TextureLoader::AdoptTexture(
+    SDL_Texture* texture, const std::string& name)
+{
+    Uint32 format;
+    int width, height;
+    SDL_QueryTexture(texture, &format, NULL, &width, &height);
+    size_t bytes = (size_t)width * height * SDL_BYTESPERPIXEL(format);
+    *mMemoryUsage += bytes;
+
+    std::shared_ptr<std::atomic<size_t>> memoryUsage = mMemoryUsage;
+    return std::shared_ptr<SDL_Texture>(
         texture,
-        [fileLoc](auto texPtr)
+        [name, memoryUsage, bytes](auto texPtr)
         {
-            std::cout << "Destroying texture '" << fileLoc << "'...\n";
+            std::cout << "Destroying texture '" << name << "'...\n";
             SDL_DestroyTexture(texPtr);
+            *memoryUsage -= bytes;
         });
-    mResources.emplace(fileLoc, textureResource);
+}
 
-    SDL_FreeSurface(surface);
-    std::cout << "SDL_LoadBMP freed\n";
+void TextureLoader::UpdateUsage(const std::string& fileLoc)
+{
+    uint32_t slotIndex = mSlotsByFile.at(fileLoc);
+    if (mUsage.size() < mSlots.size()) mUsage.resize(mSlots.size());
+
+    TextureUsage& usage = mUsage[slotIndex];
+    int width, height;
+    Uint32 format;
+    SDL_QueryTexture(mSlots[slotIndex].resource.get(), &format, NULL, &width,
+                     &height);
+    usage.bytes = (size_t)width * height * SDL_BYTESPERPIXEL(format);
+    // New textures are as recent as the last frame, so the ones loaded ahead
+    // of time are not the first to go
+    usage.lastDrawFrame = mLatestFrame;
+}
+
+ResourceHandle<SDL_Texture> TextureLoader::LoadHandle(
+    const std::string& fileLoc)
+{
+    Load(fileLoc);
+
+    auto slotIt = mSlotsByFile.find(fileLoc);
+    if (slotIt == mSlotsByFile.end()) return Handle();
+    return Handle{slotIt->second, mSlots[slotIt->second].generation};
+}
+
+size_t TextureLoader::GetMemoryUsage(Handle handle) const
+{
+    if (!Get(handle)) return 0;
+    return mUsage[handle.slot].bytes;
+}
+
+unsigned int TextureLoader::EvictTextures(int frameIdx)
+{
+    if (mMemoryBudget == 0 || GetMemoryUsage() <= mMemoryBudget) return 0;
+
+    // Evicting a texture that is held elsewhere would not free it
+    std::vector<uint32_t> candidates;
+    for (uint32_t slotIndex = 0; slotIndex < mSlots.size(); ++slotIndex)
+    {
+        const ResourceSlot& slot = mSlots[slotIndex];
+        if (slot.resource && slot.refCount == 0 &&
+            slot.resource.use_count() == 1 &&
+            mUsage[slotIndex].lastDrawFrame < frameIdx - 1)
+        {
+            candidates.push_back(slotIndex);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [this](uint32_t lhs, uint32_t rhs)
+              {
+                  return mUsage[lhs].lastDrawFrame <
+                         mUsage[rhs].lastDrawFrame;
+              });
+
+    unsigned int evictedCount = 0;
+    for (uint32_t slotIndex : candidates)
+    {
+        if (GetMemoryUsage() <= mMemoryBudget) break;
+
+        std::cout << "Evicting texture '" << mSlots[slotIndex].fileLoc
+                  << "' (" << mUsage[slotIndex].bytes << " bytes)\n";
+        FreeSlot(slotIndex);
+        evictedCount++;
+    }
+    mEvictionCount += evictedCount;
+
+    // Everything left is in use, wait for some of it not to be
+    if (GetMemoryUsage() > mMemoryBudget)
+    {
+        mNextEvictionFrame = frameIdx + EVICTION_RETRY_FRAMES;
+    }
+    return evictedCount;
 }
@@ -1,18 +1,158 @@
 #include "core/resources/TilemapLoader.hpp"
+#include "core/resources/AssetBundle.hpp"
 #include "core/resources/Spritesheet.hpp"
 #include "core/resources/TilemapData.hpp"
 
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <tuple>
+#include <vector>
 
-TilemapLoader::TilemapLoader() {}
+TilemapLoader::TilemapLoader(util::ThreadPool* workers) : mWorkers(workers) {}
 TilemapLoader::~TilemapLoader() {}
 
 void TilemapLoader::Load(std::string fileLoc)
+{
+    if (IsLoaded(fileLoc)) return;
+
+    const AssetBundleEntry* bundled =
+        mBundle ? mBundle->Find(fileLoc, AssetType::Tilemap) : nullptr;
+    if (bundled)
+    {
+        std::shared_ptr<TilemapData> mapData(new TilemapData());
+        LoadBinary(mBundle->GetFile(), bundled->dataOffset,
+                   bundled->dataSize, *mapData);
+
+        AddResource(fileLoc, std::move(mapData));
+        mFormats[fileLoc] = TilemapFormat::Binary;
+        return;
+    }
+
+    TilemapFormat format;
+    std::shared_ptr<TilemapData> mapData = Read(fileLoc, &format);
+    AddResource(fileLoc, std::move(mapData));
+    mFormats[fileLoc] = format;
+}
+
+std::shared_future<void> TilemapLoader::LoadAsync(std::string fileLoc)
+{
+    if (IsLoaded(fileLoc) ||
+        (mBundle && mBundle->Find(fileLoc, AssetType::Tilemap)))
+    {
+        return ResourceLoader<TilemapData>::LoadAsync(fileLoc);
+    }
+
+    auto pendingIt = mPending.find(fileLoc);
+    if (pendingIt != mPending.end()) return pendingIt->second.future;
+
+    PendingLoad& pending = mPending[fileLoc];
+    pending.future = pending.promise.get_future().share();
+    mWorkers->Submit(
+        [this, fileLoc]
+        {
+            ReadMap map;
+            map.fileLoc = fileLoc;
+            try
+            {
+                map.mapData = Read(fileLoc, &map.format);
+            }
+            catch (const std::exception& e)
+            {
+                map.error = e.what();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mReadMutex);
+                mRead.push_back(std::move(map));
+            }
+            mReadReady.notify_one();
+        });
+    return pending.future;
+}
+
+unsigned int TilemapLoader::ProcessLoads()
+{
+    std::deque<ReadMap> read;
+    {
+        std::lock_guard<std::mutex> lock(mReadMutex);
+        read.swap(mRead);
+    }
+
+    for (ReadMap& map : read)
+    {
+        // Loaded in the meantime with Load, which wins
+        if (map.mapData && !IsLoaded(map.fileLoc))
+        {
+            AddResource(map.fileLoc, map.mapData);
+            mFormats[map.fileLoc] = map.format;
+        }
+
+        auto pendingIt = mPending.find(map.fileLoc);
+        if (pendingIt == mPending.end()) continue;
+
+        if (map.mapData)
+        {
+            pendingIt->second.promise.set_value();
+        }
+        else
+        {
+            pendingIt->second.promise.set_exception(
+                std::make_exception_ptr(std::invalid_argument(map.error)));
+        }
+        mPending.erase(pendingIt);
+    }
+    return read.size();
+}
+
+void TilemapLoader::WaitForReads()
+{
+    if (mPending.empty()) return;
+
+    std::unique_lock<std::mutex> lock(mReadMutex);
+    mReadReady.wait(lock, [this] { return !mRead.empty(); });
+}
+
+std::shared_ptr<TilemapData> TilemapLoader::Read(const std::string& fileLoc,
+                                                 TilemapFormat* out_format)
+{
+    std::ifstream file(fileLoc, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::invalid_argument("Tilemap file could not be found.");
+    }
+
+    char magic[sizeof(TilemapFileHeader::MAGIC)] = {};
+    file.read(magic, sizeof(magic));
+    file.close();
+    bool bBinary = std::memcmp(magic, TilemapFileHeader::MAGIC,
+                               sizeof(magic)) == 0;
+
+    std::shared_ptr<TilemapData> mapData(new TilemapData());
+    if (bBinary)
+        LoadBinary(fileLoc, *mapData);
+    else
+        LoadText(fileLoc, *mapData);
+
+    *out_format = bBinary ? TilemapFormat::Binary : TilemapFormat::Text;
+    return mapData;
+}
+
+void TilemapLoader::ReplaceTiles(const std::string& fileLoc,
+                                 TilemapData& mapData, TilemapFormat format)
+{
+    std::shared_ptr<TilemapData> loaded = Get(fileLoc);
+    if (!loaded) return;
+
+    loaded->ReplaceTiles(mapData);
+    mFormats[fileLoc] = format;
+}
+
+void TilemapLoader::LoadText(const std::string& fileLoc, TilemapData& mapData)
 {
     std::ifstream file;
     file.open(fileLoc);
@@ -21,8 +161,6 @@ void TilemapLoader::Load(std::string fileLoc)
     TileData tile;
 
     unsigned int maxCols = 0;
-    mResources.emplace(fileLoc, new TilemapData());
-    TilemapData& mapData = *mResources[fileLoc];
 
     if (!file.is_open())
     {
@@ -56,6 +194,85 @@ void TilemapLoader::Load(std::string fileLoc)
     file.close();
 }
 
+void TilemapLoader::LoadBinary(const std::string& fileLoc,
+                               TilemapData& mapData)
+{
+    // Chunks are copied out of the mapping before their tiles are set
+    std::shared_ptr<util::MappedFile> file =
+        std::make_shared<util::MappedFile>(fileLoc);
+
+    LoadBinary(file, 0, file->GetSize(), mapData);
+}
+
+void TilemapLoader::LoadBinary(std::shared_ptr<util::MappedFile> file,
+                               size_t offset, size_t dataSize,
+                               TilemapData& mapData)
+{
+    uint8_t* data = file->GetData() + offset;
+
+    TilemapFileHeader header;
+    if (dataSize < sizeof(header))
+    {
+        throw std::invalid_argument("Tilemap file is truncated.");
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.magic, TilemapFileHeader::MAGIC,
+                    sizeof(header.magic)) != 0)
+    {
+        throw std::invalid_argument("Tilemap file is not a binary tilemap.");
+    }
+
+    if (header.version != TilemapFileHeader::VERSION)
+    {
+        throw std::invalid_argument("Tilemap file version " +
+                                    std::to_string(header.version) +
+                                    " is not supported.");
+    }
+    if (header.chunkSize != TilemapData::CHUNK_SIZE)
+    {
+        throw std::invalid_argument(
+            "Tilemap file has a different chunk size than TilemapData.");
+    }
+
+    const unsigned int chunkSize = TilemapData::CHUNK_SIZE;
+    Size2D size{header.width, header.height};
+    Size2D gridSize = (size + chunkSize - 1u) / chunkSize;
+    size_t gridChunks = (size_t)gridSize.x * gridSize.y;
+    size_t dataOffset = GetChunkDataOffset(gridChunks);
+    if (dataSize < dataOffset + header.storedChunks *
+                                    sizeof(TilemapData::TileChunk))
+    {
+        throw std::invalid_argument("Tilemap file is truncated.");
+    }
+
+    // The data is page aligned, so the table and chunks are aligned too
+    const uint32_t* chunkTable =
+        reinterpret_cast<const uint32_t*>(data + sizeof(header));
+    TilemapData::TileChunk* chunks =
+        reinterpret_cast<TilemapData::TileChunk*>(data + dataOffset);
+
+    mapData.mChunks.clear();
+    mapData.mChunks.resize(gridChunks);
+    for (size_t i = 0; i < gridChunks; ++i)
+    {
+        if (chunkTable[i] == TilemapFileHeader::EMPTY_CHUNK) continue;
+        if (chunkTable[i] >= header.storedChunks)
+        {
+            throw std::invalid_argument("Tilemap file has a bad chunk table.");
+        }
+
+        mapData.mChunks[i] = TilemapData::ChunkPtr(
+            &chunks[chunkTable[i]], TilemapData::ChunkDeleter{true});
+    }
+    mapData.mMappedFile = std::move(file);
+    mapData.mGridSize = gridSize;
+    mapData.mOrigin = {0, 0};
+    mapData.mSize = size;
+
+    mapData.EnsureAtLeast1x1();
+}
+
 void TilemapLoader::Save(std::shared_ptr<TilemapData>& resource)
 {
     if (!resource)
@@ -63,34 +280,152 @@ void TilemapLoader::Save(std::shared_ptr<TilemapData>& resource)
         throw std::invalid_argument("Trying to save an invalid resource");
     }
 
-    auto resourceIt = FindByPtr(resource);
-    if (resourceIt == mResources.end())
+    ResourceSlot* slot = FindSlot(resource);
+    if (!slot)
     {
         throw std::invalid_argument("Trying to save an invalid resource");
     }
 
-    std::string fileLoc = resourceIt->first;
-    TilemapData& mapData = *resourceIt->second;
+    Save(resource, mFormats[slot->fileLoc]);
+}
+
+void TilemapLoader::Save(std::shared_ptr<TilemapData>& resource,
+                         TilemapFormat format)
+{
+    if (!resource)
+    {
+        throw std::invalid_argument("Trying to save an invalid resource");
+    }
+
+    ResourceSlot* slot = FindSlot(resource);
+    if (!slot)
+    {
+        throw std::invalid_argument("Trying to save an invalid resource");
+    }
+
+    std::string fileLoc = slot->fileLoc;
+    TilemapData& mapData = *slot->resource;
 
     mapData.ShrinkToFit();
 
-    std::ofstream outFile(fileLoc);
+    Write(mapData, fileLoc, format);
+    mFormats[fileLoc] = format;
+}
+
+void TilemapLoader::Write(const TilemapData& mapData,
+                          const std::string& fileLoc, TilemapFormat format)
+{
+    // The map may be using the old file (see LoadBinary), so it is replaced
+    // rather than written over
+    std::string tempLoc = fileLoc + ".tmp";
+    std::ofstream outFile(tempLoc, std::ios::binary);
 
     if (!outFile.is_open())
     {
         throw std::runtime_error("Could not save to file '" + fileLoc + "'");
     }
 
+    if (format == TilemapFormat::Binary)
+        WriteBinary(mapData, outFile);
+    else
+        WriteText(mapData, outFile);
+
+    outFile.close();
+    if (!outFile)
+    {
+        std::remove(tempLoc.c_str());
+        throw std::runtime_error("Could not save to file '" + fileLoc + "'");
+    }
+
+    // Renaming over an existing file fails on Windows
+    if (std::rename(tempLoc.c_str(), fileLoc.c_str()) != 0)
+    {
+        std::remove(fileLoc.c_str());
+        if (std::rename(tempLoc.c_str(), fileLoc.c_str()) != 0)
+        {
+            throw std::runtime_error("Could not save to file '" + fileLoc +
+                                     "'");
+        }
+    }
+}
+
+void TilemapLoader::WriteText(const TilemapData& mapData, std::ostream& out)
+{
     Size2D mapSize = mapData.GetSize();
     TileLoc tileLoc;
     for (tileLoc.y = 0; tileLoc.y < mapSize.y; ++tileLoc.y)
     {
         for (tileLoc.x = 0; tileLoc.x < mapSize.x; ++tileLoc.x)
         {
-            outFile << mapData.GetTile(tileLoc) << ' ';
+            out << mapData.GetTile(tileLoc) << ' ';
         }
-        outFile << std::endl;
+        out << '\n';
     }
+}
 
-    outFile.close();
+void TilemapLoader::WriteBinary(const TilemapData& mapData, std::ostream& out)
+{
+    const unsigned int chunkSize = TilemapData::CHUNK_SIZE;
+    Size2D size = mapData.GetSize();
+    Size2D gridSize = (size + chunkSize - 1u) / chunkSize;
+
+    // The map's own chunks may not line up with the file's (its origin can
+    // be anywhere), so the tiles are copied into new ones
+    std::vector<uint32_t> chunkTable(gridSize.x * gridSize.y,
+                                     TilemapFileHeader::EMPTY_CHUNK);
+    std::vector<TilemapData::TileChunk> chunks;
+    TilemapData::TileChunk chunk;
+    TileLoc chunkLoc;
+    for (chunkLoc.y = 0; chunkLoc.y < gridSize.y; ++chunkLoc.y)
+    {
+        for (chunkLoc.x = 0; chunkLoc.x < gridSize.x; ++chunkLoc.x)
+        {
+            bool bEmpty = true;
+            TileLoc offset;
+            for (offset.y = 0; offset.y < chunkSize; ++offset.y)
+            {
+                for (offset.x = 0; offset.x < chunkSize; ++offset.x)
+                {
+                    PackedTile tile = TilemapData::Pack(mapData.GetTile(
+                        chunkLoc * (int)chunkSize + offset));
+                    chunk.tiles[offset.y * chunkSize + offset.x] = tile;
+                    if (tile != 0) bEmpty = false;
+                }
+            }
+            if (bEmpty) continue;
+
+            chunkTable[chunkLoc.y * gridSize.x + chunkLoc.x] = chunks.size();
+            chunks.push_back(chunk);
+        }
+    }
+
+    TilemapFileHeader header;
+    std::memcpy(header.magic, TilemapFileHeader::MAGIC, sizeof(header.magic));
+    header.version = TilemapFileHeader::VERSION;
+    header.chunkSize = chunkSize;
+    header.width = size.x;
+    header.height = size.y;
+    header.storedChunks = chunks.size();
+    header.reserved = 0;
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(chunkTable.data()),
+              chunkTable.size() * sizeof(uint32_t));
+
+    size_t dataOffset = GetChunkDataOffset(chunkTable.size());
+    size_t written = sizeof(header) + chunkTable.size() * sizeof(uint32_t);
+    std::vector<char> padding(dataOffset - written, 0);
+    out.write(padding.data(), padding.size());
+
+    out.write(reinterpret_cast<const char*>(chunks.data()),
+              chunks.size() * sizeof(TilemapData::TileChunk));
+}
+
+size_t TilemapLoader::GetChunkDataOffset(size_t gridChunks)
+{
+    // Chunks are a power of two in size, so aligning them to their size keeps
+    // each within one page
+    const size_t alignment = sizeof(TilemapData::TileChunk);
+    size_t tableEnd = sizeof(TilemapFileHeader) + gridChunks * sizeof(uint32_t);
+    return (tableEnd + alignment - 1) / alignment * alignment;
 }
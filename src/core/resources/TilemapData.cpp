@@ -1,6 +1,8 @@
 #include "core/resources/TilemapData.hpp"
+#include <glm/common.hpp>
 #include <glm/vec2.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <iomanip>
 
@@ -27,121 +29,350 @@ inline bool operator==(const TileData& lhs, const TileData& rhs)
 }
 
 TilemapData::TilemapData() {}
-TilemapData::TilemapData(Size2D size, const TileGrid& tileData)
-    : mData(tileData), mSize(size)
+TilemapData::~TilemapData() {}
+
+PackedTile TilemapData::Pack(TileData tile)
 {
-    EnsureAtLeast1x1();
+    PackedTile type = std::clamp(tile.type, -1, 0x7FFE) + 1;
+    return type | (tile.bHasCollider ? 0x8000 : 0);
+}
+
+TileData TilemapData::Unpack(PackedTile tile)
+{
+    return TileData{(tile & 0x7FFF) - 1, (tile & 0x8000) != 0};
 }
-TilemapData::~TilemapData() {}
 
 TileData TilemapData::GetTile(TileLoc tileLoc) const noexcept
 {
-    return (tileLoc.x < 0 || tileLoc.y < 0 || tileLoc.x >= mSize.x ||
-            tileLoc.y >= mSize.y)
-               ? TileData()
-               : mData[tileLoc.y][tileLoc.x];
+    if (tileLoc.x < 0 || tileLoc.y < 0 || tileLoc.x >= mSize.x ||
+        tileLoc.y >= mSize.y)
+        return TileData();
+
+    // Unsigned, so dividing by the chunk size is a shift
+    unsigned int x = tileLoc.x + mOrigin.x;
+    unsigned int y = tileLoc.y + mOrigin.y;
+    unsigned int chunkIndex = (y / CHUNK_SIZE) * mGridSize.x + x / CHUNK_SIZE;
+    const TileChunk* chunk = mChunks[chunkIndex].get();
+    if (!chunk)
+    {
+        bool bUnloaded = !mChunkLoaded.empty() && !mChunkLoaded[chunkIndex];
+        return bUnloaded ? Unpack(mUnloadedTile) : TileData();
+    }
+
+    return Unpack(
+        chunk->tiles[(y % CHUNK_SIZE) * CHUNK_SIZE + x % CHUNK_SIZE]);
 }
 
 void TilemapData::SetTile(TileLoc tileLoc, TileData tileData) noexcept
 {
+    // Streamed maps do not grow, and loading a chunk replaces its tiles
+    if (IsStreamed() && !IsTileLoaded(tileLoc)) return;
+
+    Size2D previousSize = mSize;
     GrowToFit(tileLoc);
 
     if (tileLoc.x < 0) tileLoc.x = 0;
     if (tileLoc.y < 0) tileLoc.y = 0;
 
-    if (tileData.type < -1) tileData.type = -1;
+    PackedTile packed = Pack(tileData);
+    // Empty tiles do not need their chunk allocated
+    PackedTile* tile = FindTile(tileLoc, packed != 0);
+    if (tile) *tile = packed;
+
+    bool resized = mSize != previousSize;
+    for (ITilemapChangeListener* listener : mChangeListeners)
+    {
+        if (resized)
+            listener->HandleTilemapResized();
+        else
+            listener->HandleTileChanged(tileLoc);
+    }
+}
+
+size_t TilemapData::GetMemoryUsage() const
+{
+    size_t usage = mChunks.capacity() * sizeof(mChunks[0]);
+    for (const ChunkPtr& chunk : mChunks)
+    {
+        if (chunk && !chunk.get_deleter().bMapped) usage += sizeof(TileChunk);
+    }
+    return usage;
+}
+
+bool TilemapData::IsTileLoaded(TileLoc tileLoc) const
+{
+    if (tileLoc.x < 0 || tileLoc.y < 0 || tileLoc.x >= mSize.x ||
+        tileLoc.y >= mSize.y)
+        return false;
+    if (!IsStreamed()) return true;
 
-    mData[tileLoc.y][tileLoc.x] = tileData;
+    // Streamed maps always have their origin at the start of the grid
+    TileLoc chunkLoc = tileLoc / (int)CHUNK_SIZE;
+    return mChunkLoaded[chunkLoc.y * mGridSize.x + chunkLoc.x];
+}
+
+void TilemapData::SetUnloadedTile(TileData tile)
+{
+    mUnloadedTile = Pack(tile);
+    for (ITilemapChangeListener* listener : mChangeListeners)
+    {
+        listener->HandleAreaChanged({0, 0}, mSize);
+    }
+}
+
+void TilemapData::AddChangeListener(ITilemapChangeListener* listener)
+{
+    if (mChangeListeners.count(listener)) return;
+
+    mChangeListeners.insert(listener);
+}
+void TilemapData::RemoveChangeListener(ITilemapChangeListener* listener)
+{
+    if (!mChangeListeners.count(listener)) return;
+
+    mChangeListeners.erase(listener);
 }
 
 void TilemapData::Print(std::ostream& out) const
 {
-    for (const TileRow& row : mData)
+    TileLoc tileLoc;
+    for (tileLoc.y = 0; tileLoc.y < mSize.y; ++tileLoc.y)
     {
-        for (const TileData& tile : row)
+        for (tileLoc.x = 0; tileLoc.x < mSize.x; ++tileLoc.x)
         {
-            out << std::setw(4) << tile << ' ';
+            out << std::setw(4) << GetTile(tileLoc) << ' ';
         }
         out << std::endl;
     }
 }
 
-void TilemapData::PopRowsFront(unsigned int count)
+PackedTile* TilemapData::FindTile(TileLoc tileLoc, bool allocate)
 {
-    for (int row = 0; row < count; ++row)
+    unsigned int x = tileLoc.x + mOrigin.x;
+    unsigned int y = tileLoc.y + mOrigin.y;
+    ChunkPtr& chunk = mChunks[(y / CHUNK_SIZE) * mGridSize.x + x / CHUNK_SIZE];
+    if (!chunk)
     {
-        mData.pop_front();
+        if (!allocate) return nullptr;
+        // Value initialized, so every tile starts empty. Assigned rather than
+        // reset, since the slot's deleter may be for a mapped chunk.
+        chunk = ChunkPtr(new TileChunk());
     }
-    mSize.y -= count;
+    return &GetWritableChunk(chunk)
+                ->tiles[(y % CHUNK_SIZE) * CHUNK_SIZE + x % CHUNK_SIZE];
 }
-void TilemapData::PopRowsBack(unsigned int count)
+
+TilemapData::TileChunk* TilemapData::GetWritableChunk(ChunkPtr& chunk)
+{
+    // The mapping is shared by every load of the file, and read only
+    if (chunk.get_deleter().bMapped) chunk = ChunkPtr(new TileChunk(*chunk));
+    return chunk.get();
+}
+
+void TilemapData::ReserveGrid(Size2D front, Size2D back)
 {
-    for (int row = 0; row < count; ++row)
+    // Tiles that fit around the map without growing
+    Size2D gridTiles = mGridSize * CHUNK_SIZE;
+    Size2D frontRoom = mOrigin;
+    Size2D backRoom = gridTiles - Size2D(mOrigin) - mSize;
+
+    // Chunks to add on each side
+    Size2D addFront{0, 0}, addBack{0, 0};
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        if (front[axis] > frontRoom[axis])
+        {
+            addFront[axis] = (front[axis] - frontRoom[axis] + CHUNK_SIZE - 1) /
+                             CHUNK_SIZE;
+        }
+        if (back[axis] > backRoom[axis])
+        {
+            addBack[axis] =
+                (back[axis] - backRoom[axis] + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        }
+        if (addFront[axis] == 0 && addBack[axis] == 0) continue;
+
+        // At least double, on the side that is growing
+        unsigned int added = addFront[axis] + addBack[axis];
+        if (added < mGridSize[axis])
+        {
+            if (addFront[axis] > 0)
+                addFront[axis] += mGridSize[axis] - added;
+            else
+                addBack[axis] += mGridSize[axis] - added;
+        }
+    }
+    if (addFront == Size2D(0, 0) && addBack == Size2D(0, 0)) return;
+
+    // Only the chunk pointers move, tiles stay where they are in their chunks
+    Size2D newGridSize = mGridSize + addFront + addBack;
+    std::vector<ChunkPtr> newChunks(newGridSize.x * newGridSize.y);
+    for (unsigned int y = 0; y < mGridSize.y; ++y)
     {
-        mData.pop_back();
+        for (unsigned int x = 0; x < mGridSize.x; ++x)
+        {
+            newChunks[(y + addFront.y) * newGridSize.x + x + addFront.x] =
+                std::move(mChunks[y * mGridSize.x + x]);
+        }
     }
-    mSize.y -= count;
+    mChunks = std::move(newChunks);
+    mGridSize = newGridSize;
+    mOrigin += TileLoc(addFront * CHUNK_SIZE);
 }
-void TilemapData::PopColsFront(unsigned int count)
+
+void TilemapData::ReleaseUnusedChunks()
 {
-    for (TileRow& row : mData)
+    Size2D first = Size2D(mOrigin) / CHUNK_SIZE;
+    Size2D last = (Size2D(mOrigin) + mSize - 1u) / CHUNK_SIZE;
+    for (unsigned int y = 0; y < mGridSize.y; ++y)
     {
-        for (int col = 0; col < count; ++col)
+        for (unsigned int x = 0; x < mGridSize.x; ++x)
         {
-            row.pop_front();
+            if (x >= first.x && x <= last.x && y >= first.y && y <= last.y)
+                continue;
+            mChunks[y * mGridSize.x + x].reset();
         }
     }
-    mSize.x -= count;
 }
-void TilemapData::PopColsBack(unsigned int count)
+
+void TilemapData::ClearArea(TileLoc first, Size2D size)
 {
-    for (TileRow& row : mData)
+    if (size.x == 0 || size.y == 0) return;
+
+    Size2D gridFirst = Size2D(first + mOrigin);
+    Size2D gridEnd = gridFirst + size;
+
+    // Clear a rectangle of each chunk the area overlaps
+    for (unsigned int chunkY = gridFirst.y / CHUNK_SIZE;
+         chunkY * CHUNK_SIZE < gridEnd.y; ++chunkY)
     {
-        for (int col = 0; col < count; ++col)
+        for (unsigned int chunkX = gridFirst.x / CHUNK_SIZE;
+             chunkX * CHUNK_SIZE < gridEnd.x; ++chunkX)
         {
-            row.pop_back();
+            ChunkPtr& chunkPtr = mChunks[chunkY * mGridSize.x + chunkX];
+            if (!chunkPtr) continue;
+            TileChunk* chunk = GetWritableChunk(chunkPtr);
+
+            Size2D chunkFirst = Size2D(chunkX, chunkY) * CHUNK_SIZE;
+            Size2D from = glm::max(gridFirst, chunkFirst) - chunkFirst;
+            Size2D to = glm::min(gridEnd, chunkFirst + CHUNK_SIZE) - chunkFirst;
+            for (unsigned int y = from.y; y < to.y; ++y)
+            {
+                PackedTile* row = chunk->tiles + y * CHUNK_SIZE;
+                std::fill(row + from.x, row + to.x, 0);
+            }
         }
     }
+}
+
+void TilemapData::PopRowsFront(unsigned int count)
+{
+    count = std::min(count, mSize.y);
+    mOrigin.y += count;
+    mSize.y -= count;
+}
+void TilemapData::PopRowsBack(unsigned int count)
+{
+    mSize.y -= std::min(count, mSize.y);
+}
+void TilemapData::PopColsFront(unsigned int count)
+{
+    count = std::min(count, mSize.x);
+    mOrigin.x += count;
     mSize.x -= count;
 }
+void TilemapData::PopColsBack(unsigned int count)
+{
+    mSize.x -= std::min(count, mSize.x);
+}
+
+// Tiles left in a chunk by a pop are cleared when they are emplaced again
 
 void TilemapData::EmplaceRowsFront(unsigned int count)
 {
-    for (int row = 0; row < count; ++row)
-    {
-        mData.emplace_front(mSize.x);
-    }
+    ReserveGrid({0, count}, {0, 0});
+    mOrigin.y -= count;
     mSize.y += count;
+    ClearArea({0, 0}, {mSize.x, count});
 }
 void TilemapData::EmplaceRowsBack(unsigned int count)
 {
-    for (int row = 0; row < count; ++row)
-    {
-        mData.emplace_back(mSize.x);
-    }
+    ReserveGrid({0, 0}, {0, count});
     mSize.y += count;
+    ClearArea({0, mSize.y - count}, {mSize.x, count});
 }
 void TilemapData::EmplaceColsFront(unsigned int count)
 {
-    for (TileRow& row : mData)
-    {
-        for (int col = 0; col < count; ++col)
-        {
-            row.emplace_front();
-        }
-    }
+    ReserveGrid({count, 0}, {0, 0});
+    mOrigin.x -= count;
     mSize.x += count;
+    ClearArea({0, 0}, {count, mSize.y});
 }
 void TilemapData::EmplaceColsBack(unsigned int count)
 {
-    for (TileRow& row : mData)
+    ReserveGrid({0, 0}, {count, 0});
+    mSize.x += count;
+    ClearArea({mSize.x - count, 0}, {count, mSize.y});
+}
+
+void TilemapData::InitStreamed(Size2D size)
+{
+    mChunks.clear();
+    mMappedFile.reset();
+    mGridSize = {0, 0};
+    mOrigin = {0, 0};
+    mSize = {0, 0};
+    ReserveGrid({0, 0}, size);
+    mSize = size;
+    mChunkLoaded.assign(mGridSize.x * mGridSize.y, false);
+}
+
+void TilemapData::LoadChunk(TileLoc chunkLoc,
+                            std::unique_ptr<TileChunk> chunk)
+{
+    unsigned int chunkIndex = chunkLoc.y * mGridSize.x + chunkLoc.x;
+    mChunks[chunkIndex] = ChunkPtr(chunk.release());
+    mChunkLoaded[chunkIndex] = true;
+    NotifyChunkChanged(chunkLoc);
+}
+
+void TilemapData::UnloadChunk(TileLoc chunkLoc)
+{
+    unsigned int chunkIndex = chunkLoc.y * mGridSize.x + chunkLoc.x;
+    mChunks[chunkIndex].reset();
+    mChunkLoaded[chunkIndex] = false;
+    NotifyChunkChanged(chunkLoc);
+}
+
+void TilemapData::ReplaceTiles(TilemapData& other)
+{
+    // The old chunks may be in the old file, so they go first
+    mChunks = std::move(other.mChunks);
+    mMappedFile = std::move(other.mMappedFile);
+    mGridSize = other.mGridSize;
+    mOrigin = other.mOrigin;
+    mSize = other.mSize;
+    mChunkLoaded.clear();
+
+    other.mChunks.clear();
+    other.mGridSize = Size2D{0, 0};
+    other.mOrigin = TileLoc{0, 0};
+    other.mSize = Size2D{0, 0};
+
+    for (ITilemapChangeListener* listener : mChangeListeners)
     {
-        for (int col = 0; col < count; ++col)
-        {
-            row.emplace_back();
-        }
+        listener->HandleTilemapResized();
+    }
+}
+
+void TilemapData::NotifyChunkChanged(TileLoc chunkLoc)
+{
+    TileLoc first = chunkLoc * (int)CHUNK_SIZE;
+    Size2D size = glm::min(Size2D(CHUNK_SIZE), mSize - Size2D(first));
+    for (ITilemapChangeListener* listener : mChangeListeners)
+    {
+        listener->HandleAreaChanged(first, size);
     }
-    mSize.x += count;
 }
 
 void TilemapData::ShrinkToFit()
@@ -167,6 +398,9 @@ void TilemapData::ShrinkToFit()
         }
     }
 
+    // With no data at all, keep only the first tile
+    if (minX > maxX || minY > maxY) minX = maxX = minY = maxY = 0;
+
     // Cut out all rows with no data
     int originalHeight = mSize.y;
     PopRowsFront(minY);
@@ -183,6 +417,14 @@ void TilemapData::ShrinkToFit()
             "Width of tile map data after shrink is not as expected.");
 
     EnsureAtLeast1x1();
+    ReleaseUnusedChunks();
+
+    if (mSize.x == originalWidth && mSize.y == originalHeight) return;
+
+    for (ITilemapChangeListener* listener : mChangeListeners)
+    {
+        listener->HandleTilemapResized();
+    }
 }
 
 void TilemapData::GrowToFit(TileLoc tileLoc)
@@ -202,8 +444,8 @@ void TilemapData::EnsureAtLeast1x1()
 {
     if (mSize.x > 0 && mSize.y > 0) return;
 
-    mSize.x = 1;
-    mSize.y = 1;
-    mData.emplace_back();
-    mData.back().emplace_back();
+    mSize = {0, 0};
+    ReserveGrid({0, 0}, {1, 1});
+    mSize = {1, 1};
+    ClearArea({0, 0}, mSize);
 }
@@ -0,0 +1,258 @@
+#include "core/resources/TilemapStreamer.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <glm/common.hpp>
+
+namespace
+{
+std::string GetChunkPath(const std::string& worldDir, TileLoc chunkLoc)
+{
+    return worldDir + "/" + std::to_string(chunkLoc.x) + "_" +
+           std::to_string(chunkLoc.y);
+}
+}  // namespace
+
+TilemapStreamer::TilemapStreamer(const std::string& worldDir)
+    : mWorldDir(worldDir), mMapData(new TilemapData())
+{
+    std::ifstream worldFile(worldDir + "/world");
+    if (!worldFile.is_open())
+    {
+        throw std::invalid_argument("Tilemap world file could not be found.");
+    }
+
+    Size2D size;
+    if (!(worldFile >> size.x >> size.y) || size.x == 0 || size.y == 0)
+    {
+        throw std::invalid_argument("Tilemap world file has no valid size.");
+    }
+
+    mMapData->InitStreamed(size);
+    mGridSize = mMapData->mGridSize;
+
+    mThread = std::thread(&TilemapStreamer::ThreadLoop, this);
+}
+
+TilemapStreamer::~TilemapStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mbStopping = true;
+    }
+    mRequestAvailable.notify_one();
+    mThread.join();
+}
+
+void TilemapStreamer::SetStreamDistance(unsigned int loadDistance,
+                                        unsigned int keepDistance)
+{
+    mLoadDistance = loadDistance;
+    mKeepDistance = std::max(loadDistance, keepDistance);
+}
+
+void TilemapStreamer::Update(TileLoc firstVisible, TileLoc lastVisible)
+{
+    ++mUpdateCount;
+    mFirstVisibleChunk = firstVisible / (int)TilemapData::CHUNK_SIZE;
+    mLastVisibleChunk = lastVisible / (int)TilemapData::CHUNK_SIZE;
+
+    // Hand over the chunks that finished loading, unless the view has moved
+    // away from them in the meantime
+    std::vector<LoadedChunk> loaded;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        loaded.swap(mLoaded);
+    }
+    for (LoadedChunk& chunk : loaded)
+    {
+        unsigned int chunkIndex =
+            chunk.chunkLoc.y * mGridSize.x + chunk.chunkLoc.x;
+        mRequested.erase(chunkIndex);
+        if (GetDistance(chunk.chunkLoc) > mKeepDistance) continue;
+
+        if (chunk.tiles) mLoadedBytes += sizeof(TilemapData::TileChunk);
+        mMapData->LoadChunk(chunk.chunkLoc, std::move(chunk.tiles));
+        mLastUsed[chunkIndex] = mUpdateCount;
+    }
+
+    // Request the chunks within the load distance, nearest first
+    TileLoc firstChunk = glm::max(
+        mFirstVisibleChunk - (int)mLoadDistance, TileLoc(0, 0));
+    TileLoc lastChunk = glm::min(mLastVisibleChunk + (int)mLoadDistance,
+                                 TileLoc(mGridSize) - 1);
+    std::vector<TileLoc> requests;
+    TileLoc chunkLoc;
+    for (chunkLoc.y = firstChunk.y; chunkLoc.y <= lastChunk.y; ++chunkLoc.y)
+    {
+        for (chunkLoc.x = firstChunk.x; chunkLoc.x <= lastChunk.x; ++chunkLoc.x)
+        {
+            unsigned int chunkIndex = chunkLoc.y * mGridSize.x + chunkLoc.x;
+            auto usedIt = mLastUsed.find(chunkIndex);
+            if (usedIt != mLastUsed.end())
+                usedIt->second = mUpdateCount;
+            else if (mRequested.insert(chunkIndex).second)
+                requests.push_back(chunkLoc);
+        }
+    }
+    std::sort(requests.begin(), requests.end(),
+              [this](TileLoc lhs, TileLoc rhs)
+              { return GetDistance(lhs) < GetDistance(rhs); });
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        // Drop queued requests the view has moved away from
+        auto farIt = std::remove_if(
+            mRequests.begin(), mRequests.end(),
+            [this](TileLoc queuedLoc)
+            {
+                if (GetDistance(queuedLoc) <= mKeepDistance) return false;
+                mRequested.erase(queuedLoc.y * mGridSize.x + queuedLoc.x);
+                return true;
+            });
+        mRequests.erase(farIt, mRequests.end());
+
+        // Nearer chunks go ahead of the ones already queued
+        mRequests.insert(mRequests.begin(), requests.begin(), requests.end());
+    }
+    if (!requests.empty()) mRequestAvailable.notify_one();
+
+    // Unload far chunks, then the least recently used ones over the budget
+    std::vector<std::pair<uint64_t, unsigned int>> unused;
+    std::vector<unsigned int> far;
+    for (const auto& used : mLastUsed)
+    {
+        if (GetDistance(GetChunkLoc(used.first)) > mKeepDistance)
+            far.push_back(used.first);
+        else if (used.second != mUpdateCount)
+            unused.emplace_back(used.second, used.first);
+    }
+    for (unsigned int chunkIndex : far) UnloadChunk(chunkIndex);
+
+    if (mLoadedBytes <= mMemoryBudget) return;
+    std::sort(unused.begin(), unused.end());
+    for (const auto& chunk : unused)
+    {
+        if (mLoadedBytes <= mMemoryBudget) break;
+        UnloadChunk(chunk.second);
+    }
+}
+
+void TilemapStreamer::UnloadChunk(unsigned int chunkIndex)
+{
+    if (mMapData->mChunks[chunkIndex])
+        mLoadedBytes -= sizeof(TilemapData::TileChunk);
+    mMapData->UnloadChunk(GetChunkLoc(chunkIndex));
+    mLastUsed.erase(chunkIndex);
+}
+
+unsigned int TilemapStreamer::GetDistance(TileLoc chunkLoc) const
+{
+    TileLoc before = mFirstVisibleChunk - chunkLoc;
+    TileLoc after = chunkLoc - mLastVisibleChunk;
+    TileLoc distance = glm::max(glm::max(before, after), TileLoc(0, 0));
+    return std::max(distance.x, distance.y);
+}
+
+void TilemapStreamer::ThreadLoop()
+{
+    while (true)
+    {
+        TileLoc chunkLoc;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mRequestAvailable.wait(
+                lock, [this] { return mbStopping || !mRequests.empty(); });
+            if (mbStopping) return;
+
+            chunkLoc = mRequests.front();
+            mRequests.pop_front();
+        }
+
+        LoadedChunk chunk{chunkLoc, ReadChunk(chunkLoc)};
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mLoaded.push_back(std::move(chunk));
+    }
+}
+
+std::unique_ptr<TilemapData::TileChunk> TilemapStreamer::ReadChunk(
+    TileLoc chunkLoc) const
+{
+    const unsigned int chunkSize = TilemapData::CHUNK_SIZE;
+
+    std::ifstream file(GetChunkPath(mWorldDir, chunkLoc));
+    if (!file.is_open()) return nullptr;
+
+    std::unique_ptr<TilemapData::TileChunk> chunk(new TilemapData::TileChunk());
+    bool bEmpty = true;
+
+    std::string line;
+    TileData tile;
+    for (unsigned int y = 0; y < chunkSize && std::getline(file, line); ++y)
+    {
+        std::stringstream ss(line);
+        for (unsigned int x = 0; x < chunkSize && ss >> tile; ++x)
+        {
+            PackedTile packed = TilemapData::Pack(tile);
+            chunk->tiles[y * chunkSize + x] = packed;
+            if (packed != 0) bEmpty = false;
+        }
+    }
+
+    if (bEmpty) return nullptr;
+    return chunk;
+}
+
+void TilemapStreamer::WriteWorld(const TilemapData& map,
+                                 const std::string& worldDir)
+{
+    const int chunkSize = TilemapData::CHUNK_SIZE;
+    Size2D size = map.GetSize();
+
+    std::ofstream worldFile(worldDir + "/world");
+    if (!worldFile.is_open())
+    {
+        throw std::runtime_error("Could not save to directory '" + worldDir +
+                                 "'");
+    }
+    worldFile << size.x << ' ' << size.y << std::endl;
+
+    TileLoc chunkLoc;
+    for (chunkLoc.y = 0; chunkLoc.y * chunkSize < size.y; ++chunkLoc.y)
+    {
+        for (chunkLoc.x = 0; chunkLoc.x * chunkSize < size.x; ++chunkLoc.x)
+        {
+            TileLoc first = chunkLoc * chunkSize;
+            TileLoc last = glm::min(first + chunkSize, TileLoc(size)) - 1;
+
+            // Empty chunks need no file
+            std::stringstream chunkText;
+            bool bEmpty = true;
+            TileLoc tileLoc;
+            for (tileLoc.y = first.y; tileLoc.y <= last.y; ++tileLoc.y)
+            {
+                for (tileLoc.x = first.x; tileLoc.x <= last.x; ++tileLoc.x)
+                {
+                    TileData tile = map.GetTile(tileLoc);
+                    if (tile.type != -1 || tile.bHasCollider) bEmpty = false;
+                    chunkText << tile << ' ';
+                }
+                chunkText << std::endl;
+            }
+            if (bEmpty) continue;
+
+            std::ofstream chunkFile(GetChunkPath(worldDir, chunkLoc));
+            if (!chunkFile.is_open())
+            {
+                throw std::runtime_error("Could not save to directory '" +
+                                         worldDir + "'");
+            }
+            chunkFile << chunkText.str();
+        }
+    }
+}
@@ -0,0 +1,183 @@
+#include "core/util/FileWatcher.hpp"
+
+#include <algorithm>
+
+#ifdef LINUX
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace util
+{
+
+#ifdef LINUX
+
+namespace
+{
+/**
+ * Split a file location into the directory to watch, and the prefix that
+ * names in that directory are reported with.
+ */
+void SplitFileLoc(const std::string& fileLoc, std::string* out_dir,
+                  std::string* out_prefix)
+{
+    size_t slash = fileLoc.find_last_of('/');
+    if (slash == std::string::npos)
+    {
+        *out_dir = ".";
+        out_prefix->clear();
+        return;
+    }
+    *out_dir = slash == 0 ? "/" : fileLoc.substr(0, slash);
+    *out_prefix = fileLoc.substr(0, slash + 1);
+}
+}  // namespace
+
+FileWatcher::FileWatcher(unsigned int debounceMs) : mDebounce(debounceMs)
+{
+    mInotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (mInotifyFd < 0) return;
+
+    if (pipe2(mWakePipe, O_NONBLOCK | O_CLOEXEC) != 0)
+    {
+        close(mInotifyFd);
+        mInotifyFd = -1;
+        return;
+    }
+
+    mThread = std::thread(&FileWatcher::ThreadLoop, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+    if (mThread.joinable())
+    {
+        char wake = 0;
+        (void)write(mWakePipe[1], &wake, 1);
+        mThread.join();
+    }
+
+    if (mInotifyFd >= 0) close(mInotifyFd);
+    if (mWakePipe[0] >= 0) close(mWakePipe[0]);
+    if (mWakePipe[1] >= 0) close(mWakePipe[1]);
+}
+
+bool FileWatcher::IsSupported() const { return mInotifyFd >= 0; }
+
+bool FileWatcher::Watch(const std::string& fileLoc)
+{
+    if (!IsSupported()) return false;
+
+    std::string dir, prefix;
+    SplitFileLoc(fileLoc, &dir, &prefix);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mWatchedDirs.count(dir) == 0)
+    {
+        // Written in place, or replaced by a rename
+        int wd = inotify_add_watch(mInotifyFd, dir.c_str(),
+                                   IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0) return false;
+
+        mDirs[wd] = prefix;
+        mWatchedDirs.insert(dir);
+    }
+    mFiles.insert(fileLoc);
+    return true;
+}
+
+void FileWatcher::ThreadLoop()
+{
+    alignas(inotify_event) char buffer[4096];
+
+    while (true)
+    {
+        int timeoutMs;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            timeoutMs = PromoteQuietFiles();
+        }
+
+        pollfd fds[2] = {{mInotifyFd, POLLIN, 0}, {mWakePipe[0], POLLIN, 0}};
+        if (poll(fds, 2, timeoutMs) < 0) continue;
+        if (fds[1].revents & POLLIN) return;
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        ssize_t length;
+        while ((length = read(mInotifyFd, buffer, sizeof(buffer))) > 0)
+        {
+            Clock::time_point now = Clock::now();
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            for (char* next = buffer; next < buffer + length;)
+            {
+                const inotify_event* event =
+                    reinterpret_cast<const inotify_event*>(next);
+                next += sizeof(inotify_event) + event->len;
+                if (event->len == 0) continue;
+
+                auto dirIt = mDirs.find(event->wd);
+                if (dirIt == mDirs.end()) continue;
+
+                // Other files in the directory are not watched
+                std::string fileLoc = dirIt->second + event->name;
+                if (mFiles.count(fileLoc) != 0) mChanged[fileLoc] = now;
+            }
+        }
+    }
+}
+
+#else
+
+FileWatcher::FileWatcher(unsigned int debounceMs) : mDebounce(debounceMs) {}
+
+FileWatcher::~FileWatcher() {}
+
+bool FileWatcher::IsSupported() const { return false; }
+
+bool FileWatcher::Watch(const std::string& fileLoc) { return false; }
+
+void FileWatcher::ThreadLoop() {}
+
+#endif
+
+void FileWatcher::TakeChanges(std::vector<std::string>& out)
+{
+    out.clear();
+    std::lock_guard<std::mutex> lock(mMutex);
+    out.swap(mReady);
+}
+
+int FileWatcher::PromoteQuietFiles()
+{
+    if (mChanged.empty()) return -1;
+
+    Clock::time_point now = Clock::now();
+    Clock::duration untilNext = mDebounce;
+    for (auto it = mChanged.begin(); it != mChanged.end();)
+    {
+        Clock::duration quiet = now - it->second;
+        if (quiet >= mDebounce)
+        {
+            if (std::find(mReady.begin(), mReady.end(), it->first) ==
+                mReady.end())
+            {
+                mReady.push_back(it->first);
+            }
+            it = mChanged.erase(it);
+            continue;
+        }
+        untilNext = std::min(untilNext, mDebounce - quiet);
+        ++it;
+    }
+
+    if (mChanged.empty()) return -1;
+    // Round up, so the files are quiet by the time the thread wakes up
+    return std::chrono::duration_cast<std::chrono::milliseconds>(untilNext)
+               .count() +
+           1;
+}
+
+}  // namespace util
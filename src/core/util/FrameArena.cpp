@@ -0,0 +1,55 @@
+#include "core/util/FrameArena.hpp"
+
+namespace util
+{
+
+FrameArena::FrameArena(size_t capacity) : mCapacity(capacity)
+{
+    mBuffer = static_cast<char*>(::operator new(
+        capacity, std::align_val_t(alignof(std::max_align_t))));
+}
+
+FrameArena::~FrameArena()
+{
+    Reset();
+    ::operator delete(mBuffer, std::align_val_t(alignof(std::max_align_t)));
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+    size_t offset = mOffset.load(std::memory_order_relaxed);
+    size_t alignedOffset, newOffset;
+    do
+    {
+        alignedOffset = (offset + alignment - 1) & ~(alignment - 1);
+        newOffset = alignedOffset + size;
+        if (newOffset > mCapacity) break;
+    } while (!mOffset.compare_exchange_weak(offset, newOffset,
+                                            std::memory_order_relaxed));
+
+    if (newOffset <= mCapacity) return mBuffer + alignedOffset;
+
+    // Out of space: fall back to the heap until the next reset
+    void* memory = ::operator new(size, std::align_val_t(alignment));
+    std::lock_guard<std::mutex> lock(mOverflowMutex);
+    mOverflow.emplace_back(memory, alignment);
+    mOverflowBytes += size;
+    return memory;
+}
+
+void FrameArena::Reset()
+{
+    mLastFrameUsage = GetUsed();
+    if (mLastFrameUsage > mPeakUsage) mPeakUsage = mLastFrameUsage;
+
+    for (auto& [memory, alignment] : mOverflow)
+    {
+        ::operator delete(memory, std::align_val_t(alignment));
+    }
+    mOverflow.clear();
+    mOverflowBytes = 0;
+
+    mOffset.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace util
@@ -0,0 +1,109 @@
+#include "core/util/FramePacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace util
+{
+
+FramePacer::FramePacer(double targetFrameRate)
+    : mFrequency(SDL_GetPerformanceFrequency())
+{
+    SetTargetFrameRate(targetFrameRate);
+}
+
+void FramePacer::SetTargetFrameRate(double targetFrameRate)
+{
+    mTargetFrameRate = targetFrameRate;
+    mTargetTicks = targetFrameRate > 0 ? mFrequency / targetFrameRate : 0;
+}
+
+float FramePacer::WaitForNextFrame()
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (mFrameStart == 0)
+    {
+        // Nothing to measure yet
+        mFrameStart = now;
+        return mTargetFrameRate > 0 ? 1.0f / mTargetFrameRate : 1.0f / 60;
+    }
+
+    Uint64 workTicks = now - mFrameStart;
+
+    if (mTargetTicks != 0)
+    {
+        Uint64 deadline = mFrameStart + mTargetTicks;
+        while (now < deadline)
+        {
+            double remainingMs = (double)(deadline - now) * 1000 / mFrequency;
+            if (remainingMs > SPIN_THRESHOLD_MS + 1)
+                SDL_Delay((Uint32)(remainingMs - SPIN_THRESHOLD_MS));
+
+            now = SDL_GetPerformanceCounter();
+        }
+    }
+
+    // A missed deadline is not made up for, the next frame starts now
+    Uint64 frameTicks = now - mFrameStart;
+    mFrameStart = now;
+
+    FrameTiming& timing = mHistory[mHistoryNext];
+    timing.frameTime = (double)frameTicks / mFrequency;
+    timing.workTime = (double)workTicks / mFrequency;
+    mHistoryNext = (mHistoryNext + 1) % HISTORY_SIZE;
+    mHistoryCount = std::min(mHistoryCount + 1, HISTORY_SIZE);
+
+    return std::min(timing.frameTime, MAX_DELTA_TIME);
+}
+
+void FramePacer::GetHistory(std::vector<FrameTiming>& out) const
+{
+    out.clear();
+    unsigned int first = (mHistoryNext + HISTORY_SIZE - mHistoryCount) %
+                         HISTORY_SIZE;
+    for (unsigned int i = 0; i < mHistoryCount; ++i)
+    {
+        out.push_back(mHistory[(first + i) % HISTORY_SIZE]);
+    }
+}
+
+FrameTiming FramePacer::GetAverage() const
+{
+    FrameTiming average;
+    if (mHistoryCount == 0) return average;
+
+    for (unsigned int i = 0; i < mHistoryCount; ++i)
+    {
+        average.frameTime += mHistory[i].frameTime;
+        average.workTime += mHistory[i].workTime;
+    }
+    average.frameTime /= mHistoryCount;
+    average.workTime /= mHistoryCount;
+    return average;
+}
+
+float FramePacer::GetJitter() const
+{
+    if (mHistoryCount == 0) return 0;
+
+    float mean = GetAverage().frameTime;
+    float variance = 0;
+    for (unsigned int i = 0; i < mHistoryCount; ++i)
+    {
+        float difference = mHistory[i].frameTime - mean;
+        variance += difference * difference;
+    }
+    return std::sqrt(variance / mHistoryCount);
+}
+
+float FramePacer::GetLongestFrameTime() const
+{
+    float longest = 0;
+    for (unsigned int i = 0; i < mHistoryCount; ++i)
+    {
+        longest = std::max(longest, mHistory[i].frameTime);
+    }
+    return longest;
+}
+
+}  // namespace util
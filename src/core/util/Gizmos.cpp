@@ -10,9 +10,8 @@
 #include <SDL.h>
 #endif
 
-#define EscapeIfNecessary()                              \
-    if (!mCtx || mDrawMode == DrawMode::DM_NONE) return; \
-    SDL_Renderer* ren = mCtx->renderer;
+#define EscapeIfNecessary() \
+    if (!mCtx || mDrawMode == DrawMode::DM_NONE) return;
 
 #define ExpandColor(color) color.r, color.g, color.b, color.a
 
@@ -23,16 +22,28 @@ void Gizmos::DrawRect(SDL_Rect rect)
 {
     EscapeIfNecessary();
 
-    if (mDrawMode & DrawMode::DM_FILL)
+    // Captured by value, since the frame may be drawn on the render thread
+    DrawMode drawMode = mDrawMode;
+    SDL_Color fillColor = mFillColor;
+    SDL_Color strokeColor = mStrokeColor;
+    auto draw = [=](SDL_Renderer* ren)
     {
-        SDL_SetRenderDrawColor(ren, ExpandColor(mFillColor));
-        SDL_RenderFillRect(ren, &rect);
-    }
-    if (mDrawMode & DrawMode::DM_STROKE)
-    {
-        SDL_SetRenderDrawColor(ren, ExpandColor(mStrokeColor));
-        SDL_RenderDrawRect(ren, &rect);
-    }
+        if (drawMode & DrawMode::DM_FILL)
+        {
+            SDL_SetRenderDrawColor(ren, ExpandColor(fillColor));
+            SDL_RenderFillRect(ren, &rect);
+        }
+        if (drawMode & DrawMode::DM_STROKE)
+        {
+            SDL_SetRenderDrawColor(ren, ExpandColor(strokeColor));
+            SDL_RenderDrawRect(ren, &rect);
+        }
+    };
+
+    if (mCtx->spriteBatch)
+        mCtx->spriteBatch->DrawOverlay(draw);
+    else
+        draw(mCtx->renderer);
 }
 void Gizmos::DrawRay(glm::vec2 start, glm::vec2 direction, float length)
 {
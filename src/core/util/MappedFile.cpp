@@ -0,0 +1,78 @@
+#include "core/util/MappedFile.hpp"
+
+#include <stdexcept>
+
+#ifdef MINGW
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace util
+{
+
+#ifdef MINGW
+
+MappedFile::MappedFile(const std::string& path, bool bWritable)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Could not open file '" + path + "'");
+    }
+
+    mBuffer.assign(std::istreambuf_iterator<char>(file),
+                   std::istreambuf_iterator<char>());
+    mData = mBuffer.data();
+    mSize = mBuffer.size();
+}
+
+MappedFile::~MappedFile() {}
+
+#else
+
+MappedFile::MappedFile(const std::string& path, bool bWritable)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Could not open file '" + path + "'");
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("Could not read file '" + path + "'");
+    }
+
+    mSize = fileStat.st_size;
+    // Empty files can not be mapped
+    if (mSize > 0)
+    {
+        int protection = PROT_READ | (bWritable ? PROT_WRITE : 0);
+        void* data = mmap(nullptr, mSize, protection, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            throw std::runtime_error("Could not map file '" + path + "'");
+        }
+        mData = static_cast<uint8_t*>(data);
+    }
+
+    // The mapping stays valid after the file is closed
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData) munmap(mData, mSize);
+}
+
+#endif
+
+}  // namespace util
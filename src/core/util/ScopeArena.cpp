@@ -0,0 +1,140 @@
+#include "core/util/ScopeArena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+// With AddressSanitizer, memory of the arena that is not allocated is
+// poisoned, so using an object after a reset is caught like a use after free
+#if defined(__SANITIZE_ADDRESS__)
+#define SCOPE_ARENA_ASAN
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define SCOPE_ARENA_ASAN
+#endif
+#endif
+
+#ifdef SCOPE_ARENA_ASAN
+#include <sanitizer/asan_interface.h>
+#define POISON(memory, size) ASAN_POISON_MEMORY_REGION(memory, size)
+#define UNPOISON(memory, size) ASAN_UNPOISON_MEMORY_REGION(memory, size)
+#else
+#define POISON(memory, size) ((void)(memory), (void)(size))
+#define UNPOISON(memory, size) ((void)(memory), (void)(size))
+#endif
+
+namespace util
+{
+
+ScopeArena::ScopeArena(size_t blockSize) : mBlockSize(blockSize)
+{
+    AddBlock(mBlockSize);
+}
+
+ScopeArena::~ScopeArena()
+{
+    Reset();
+    for (Block& block : mBlocks)
+    {
+        UNPOISON(block.memory, block.size);
+        ::operator delete(block.memory,
+                          std::align_val_t(alignof(std::max_align_t)));
+    }
+}
+
+void* ScopeArena::Allocate(size_t size, size_t alignment)
+{
+    while (true)
+    {
+        Block& block = mBlocks[mBlockIdx];
+        // Aligned by address, since alignment can exceed the block's
+        uintptr_t start = (uintptr_t)block.memory + mOffset;
+        uintptr_t aligned =
+            (start + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        size_t newOffset = aligned - (uintptr_t)block.memory + size;
+        if (newOffset <= block.size)
+        {
+            mUsed += newOffset - mOffset;
+            mOffset = newOffset;
+            UNPOISON(reinterpret_cast<void*>(aligned), size);
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        // The rest of this block is wasted
+        mBlockIdx++;
+        mOffset = 0;
+        if (mBlockIdx == mBlocks.size()) AddBlock(size + alignment);
+    }
+}
+
+void* ScopeArena::AllocateFinalized(size_t size, size_t alignment)
+{
+    // The object is at least as aligned as the finalizer, which ends right
+    // where the object starts
+    alignment = std::max(alignment, alignof(Finalizer));
+    size_t headerSize =
+        (sizeof(Finalizer) + alignment - 1) & ~(alignment - 1);
+    char* memory = static_cast<char*>(Allocate(headerSize + size, alignment));
+    return memory + headerSize;
+}
+
+void ScopeArena::AddFinalizer(void* object, void (*destroy)(void*))
+{
+    Finalizer* finalizer = reinterpret_cast<Finalizer*>(
+        static_cast<char*>(object) - sizeof(Finalizer));
+    finalizer->destroy = destroy;
+    finalizer->previous = mLastFinalizer;
+    mLastFinalizer = finalizer;
+    mFinalizerCount++;
+}
+
+void ScopeArena::RunFinalizer(void* object)
+{
+    Finalizer* finalizer = reinterpret_cast<Finalizer*>(
+        static_cast<char*>(object) - sizeof(Finalizer));
+    if (!finalizer->destroy) return;
+
+    void (*destroy)(void*) = finalizer->destroy;
+    finalizer->destroy = nullptr;
+    mFinalizerCount--;
+    destroy(object);
+}
+
+void ScopeArena::Reset()
+{
+    while (mLastFinalizer)
+    {
+        Finalizer* finalizer = mLastFinalizer;
+        mLastFinalizer = finalizer->previous;
+        if (finalizer->destroy)
+        {
+            finalizer->destroy(reinterpret_cast<char*>(finalizer) +
+                               sizeof(Finalizer));
+        }
+    }
+    mFinalizerCount = 0;
+
+    for (size_t i = 1; i < mBlocks.size(); ++i)
+    {
+        mCapacity -= mBlocks[i].size;
+        UNPOISON(mBlocks[i].memory, mBlocks[i].size);
+        ::operator delete(mBlocks[i].memory,
+                          std::align_val_t(alignof(std::max_align_t)));
+    }
+    mBlocks.resize(1);
+    POISON(mBlocks[0].memory, mBlocks[0].size);
+    mBlockIdx = 0;
+    mOffset = 0;
+    mUsed = 0;
+}
+
+void ScopeArena::AddBlock(size_t minSize)
+{
+    size_t size = std::max(minSize, mBlockSize);
+    char* memory = static_cast<char*>(::operator new(
+        size, std::align_val_t(alignof(std::max_align_t))));
+    POISON(memory, size);
+    mBlocks.push_back(Block{memory, size});
+    mCapacity += size;
+}
+
+}  // namespace util
@@ -0,0 +1,38 @@
+#include "core/util/SpatialGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace util
+{
+
+void SpatialGrid::Clear()
+{
+    for (auto& cell : mCells)
+    {
+        cell.second.clear();
+    }
+    mUnbounded.clear();
+    mBoundedCount = 0;
+}
+
+void SpatialGrid::Insert(unsigned int id, const FRect& bounds)
+{
+    int minX = std::floor(bounds.x / mCellSize);
+    int minY = std::floor(bounds.y / mCellSize);
+    int maxX = std::floor((bounds.x + bounds.w) / mCellSize);
+    int maxY = std::floor((bounds.y + bounds.h) / mCellSize);
+
+    for (int y = minY; y <= maxY; ++y)
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            mCells[CellKey(x, y)].push_back(Entry{id, bounds});
+        }
+    }
+    mBoundedCount++;
+}
+
+void SpatialGrid::InsertUnbounded(unsigned int id) { mUnbounded.push_back(id); }
+
+}  // namespace util
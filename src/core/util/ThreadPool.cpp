@@ -0,0 +1,93 @@
+#include "core/util/ThreadPool.hpp"
+
+namespace util
+{
+
+ThreadPool::ThreadPool(unsigned int workerCount)
+{
+    mWorkers.reserve(workerCount);
+    for (unsigned int i = 0; i < workerCount; ++i)
+    {
+        mWorkers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mbStopping = true;
+    }
+    mTaskAvailable.notify_all();
+
+    for (std::thread& worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+std::future<void> ThreadPool::Submit(std::function<void()> task)
+{
+    std::packaged_task<void()> packagedTask(std::move(task));
+    std::future<void> future = packagedTask.get_future();
+
+    if (mWorkers.empty())
+    {
+        packagedTask();
+        return future;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTasks.push(std::move(packagedTask));
+    }
+    mTaskAvailable.notify_one();
+    return future;
+}
+
+void ThreadPool::RunAll(std::vector<std::function<void()>>& tasks)
+{
+    if (tasks.empty()) return;
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(tasks.size() - 1);
+    for (size_t i = 1; i < tasks.size(); ++i)
+    {
+        futures.push_back(Submit(tasks[i]));
+    }
+
+    tasks[0]();
+
+    for (std::future<void>& future : futures)
+    {
+        // Rethrows any exception thrown by the task
+        future.get();
+    }
+}
+
+unsigned int ThreadPool::DefaultWorkerCount()
+{
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mTaskAvailable.wait(lock,
+                                [this] { return mbStopping || !mTasks.empty(); });
+
+            if (mTasks.empty()) return;
+
+            task = std::move(mTasks.front());
+            mTasks.pop();
+        }
+        task();
+    }
+}
+
+}  // namespace util
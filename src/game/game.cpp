@@ -16,87 +16,57 @@
 
 #include <iostream>
 #include <memory>
+#include <string>
 
 int main(int argc, char** argv)
 {
     // Create an instance of an object for our engine
     Engine engine;
     // Initialize the Engine Subsystems
-    engine.InitializeGraphicsSubSystem();
+    // Run without a window with "--headless [frames]", or with
+    // "--headless-discard [frames]" to only count draws
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "--headless" || mode == "--headless-discard")
+    {
+        engine.InitializeHeadlessGraphicsSubSystem(mode ==
+                                                   "--headless-discard");
+        engine.SetFrameLimit(argc > 2 ? std::stoi(argv[2]) : 1000);
+    }
+    else
+    {
+        engine.InitializeGraphicsSubSystem();
+    }
     engine.InitializeInputSystem();
+    engine.InitializeJobSystem();
     // Once all subsystems have been initialized
     // Start the engine
     engine.Startup();
 
-    // Setup our TileMap
-    // This tile map is 20x11 in our game
-    // It is using a 'reference' tilemap with 8x8 tiles
-    // that are each 64x64 pixels.
-    GameObject& tilemapObject = engine.InstantiateGameObject();
-    const char* tilemapSpritesheetLoc =
-        "./assets/mspj-engine/sprites/path/path-sheet.bmp";
-    ResourceManager::instance().Spritesheets()->Load(tilemapSpritesheetLoc);
-    std::shared_ptr<Spritesheet> tilemapTextureAtlas =
-        ResourceManager::instance().Spritesheets()->Get(tilemapSpritesheetLoc);
-    tilemapTextureAtlas->SetSpriteSize({32, 32});
-    // Create the tilemap component
-    TilemapComponent* tilemapComponent =
-        engine.InstantiateComponent<TilemapComponent>(tilemapObject,
-                                                      tilemapTextureAtlas);
-    tilemapComponent->SetDisplayTileSize({64, 64});
-    // Generate a a simple tilemap
-    tilemapComponent->GenerateMapFromFile(
-        "./assets/mspj-engine/tilemaps/level0");
-    TilemapColliderComponent* tilemapCollider =
-        engine.InstantiateComponent<TilemapColliderComponent>(tilemapObject);
+    // Load assets from the bundle made by `make bundle`, if there is one. The
+    // ones not in it are still loaded from their own files.
+    ResourceManager::instance().MountBundle("./assets/mspj-engine.bundle");
+    // Reload assets when they are saved, while editing them (Linux only)
+    // ResourceManager::instance().EnableHotReload(true);
+    // Evict the textures drawn least recently beyond 256 MB
+    ResourceManager::instance().Textures()->SetMemoryBudget(256 << 20);
 
-    // Note: Player must be created after the tilemap to be rendered after
-    // (above) the tilemap Create our player game object, all components created
-    // here are to be deleted by the Player
-    GameObject& player = engine.InstantiateGameObject();
-    // Prepare the controller
-    ControllerComponent* controller =
-        engine.InstantiateComponent<ControllerComponent>(player);
-    player.GetTransform().SetPosition({128, 64});
-    // Prepare the sprite
-    SpriteAnimator* sprite =
-        engine.InstantiateComponent<SpriteAnimator>(player);
-    const char* playerSpriteheetLoc =
-        "./assets/mspj-engine/sprites/walk-cycle/"
-        "character-walk-spritesheet.bmp";
-    ResourceManager::instance().Spritesheets()->Load(playerSpriteheetLoc);
-    std::shared_ptr<Spritesheet> characterSpritesheet =
-        ResourceManager::instance().Spritesheets()->Get(playerSpriteheetLoc);
-    characterSpritesheet->SetSpriteSize({32, 32});
-    sprite->UseSpritesheet(characterSpritesheet);
-    sprite->SetSize({32, 32});
-    sprite->SetAnimation("move_down", 0, 4);
-    sprite->SetAnimation("move_up", 1, 4);
-    sprite->SetAnimation("move_left", 2, 4);
-    sprite->SetAnimation("move_right", 3, 4);
-    sprite->SetAnimation("idle", 4, 2);
-    SpriteColliderComponent* spriteCollider =
-        engine.InstantiateComponent<SpriteColliderComponent>(player);
+    // Create the level: the tilemap, the player and a mushroom. See the
+    // scene file for how they are set up.
+    if (engine.LoadScene("./assets/mspj-engine/scenes/level0.scene") != 0)
+    {
+        engine.Shutdown();
+        return 1;
+    }
+    // The next level can be loaded in the background while this one plays,
+    // keeping its resources under 64 MB, then switched to at once (e.g. when
+    // a component sees the level is won):
+    // engine.PrefetchScene("./assets/mspj-engine/scenes/level1.scene",
+    //                      64 << 20);
+    // engine.SwitchToPrefetchedScene();
 
     int numMushrooms = 3;
     int collectedCount = 0;
 
-    const char* mushroomSpriteLoc =
-        "./assets/mspj-engine/sprites/objects/mushroom-coin.bmp";
-    ResourceManager::instance().Spritesheets()->Load(mushroomSpriteLoc);
-    std::shared_ptr<Spritesheet> mushroomSpritesheet =
-        ResourceManager::instance().Spritesheets()->Get(mushroomSpriteLoc);
-
-    GameObject& mushroom = engine.InstantiateGameObject();
-    SpriteRenderer* mushroomSprite =
-        engine.InstantiateComponent<SpriteRenderer>(mushroom);
-    mushroomSprite->UseSpritesheet(mushroomSpritesheet);
-    mushroomSprite->SetSize({32, 32});
-    ColliderComponent* mushroomCollider =
-        engine.InstantiateComponent<SpriteColliderComponent>(mushroom);
-    mushroomCollider->SetIsTrigger(true);
-    mushroom.GetTransform().SetPosition({144, 128});
-
     // An artifact of original engine that used python for scripting.
     /*
     engine.InstantiateBehaviorComponent(mushroom, "collectable",
@@ -112,6 +82,9 @@ int main(int argc, char** argv)
       });
     */
 
+    // Draw the tilemap, player and mushroom from one texture
+    engine.PackSpritesheets();
+
     // Run our program forever
     engine.RunGameLoop();
     // Explicitly call Shutdown to terminate our engine
@@ -0,0 +1,114 @@
+// Helpers shared by the benchmark tools: timing, and reading the arguments
+// from the command line. Each bench keeps only its workload.
+
+#ifndef __BENCHUTIL_HPP__
+#define __BENCHUTIL_HPP__
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace bench
+{
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * The time since a point, in milliseconds.
+ * @param start The point to measure from
+ * @return The milliseconds since start
+ */
+inline double MsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+        .count();
+}
+
+/**
+ * The arguments of a bench, read by position. Arguments that are not given
+ * take their default, and ones that are not numbers fail Check, which
+ * prints the usage.
+ */
+class Args
+{
+public:
+    /**
+     * Constructor
+     * @param argc The argument count from main
+     * @param argv The arguments from main
+     * @param usage The arguments the bench takes, e.g. "[objects] [rounds]"
+     */
+    Args(int argc, char** argv, const char* usage)
+        : mArgc(argc), mArgv(argv), mUsage(usage)
+    {
+    }
+
+    /**
+     * The number of arguments, counting the program.
+     */
+    int Count() const { return mArgc; }
+
+    /**
+     * Read a number.
+     * @tparam T The integer type of the number
+     * @param index The position of the argument, 1 for the first
+     * @param defaultValue The number when the argument is not given
+     * @return The number, or defaultValue if it is not given or not valid
+     */
+    template <typename T>
+    T Get(int index, T defaultValue)
+    {
+        static_assert(std::is_integral<T>::value,
+                      "Bench arguments are integers.");
+        if (index >= mArgc) return defaultValue;
+
+        try
+        {
+            size_t length = 0;
+            long long value = std::stoll(mArgv[index], &length);
+            if (mArgv[index][length] == '\0' &&
+                (std::is_signed<T>::value || value >= 0))
+                return (T)value;
+        }
+        catch (const std::exception&)
+        {
+        }
+        mbValid = false;
+        return defaultValue;
+    }
+
+    /**
+     * Read a string.
+     * @param index The position of the argument, 1 for the first
+     * @param defaultValue The string when the argument is not given
+     * @return The string
+     */
+    std::string GetString(int index, const char* defaultValue) const
+    {
+        return index < mArgc ? mArgv[index] : defaultValue;
+    }
+
+    /**
+     * Check the arguments, printing the usage if they are not valid.
+     * @param bValid Whether the values read make sense for the bench
+     * @return Whether the bench can run
+     */
+    bool Check(bool bValid) const
+    {
+        if (bValid && mbValid) return true;
+
+        std::cerr << "Usage: " << mArgv[0] << " " << mUsage << std::endl;
+        return false;
+    }
+
+private:
+    int mArgc;
+    char** mArgv;
+    const char* mUsage;
+    // Whether every number read was one
+    bool mbValid = true;
+};
+}  // namespace bench
+
+#endif  // __BENCHUTIL_HPP__
@@ -0,0 +1,186 @@
+// Bakes the assets listed in a manifest into one asset bundle (see
+// AssetBundle), which the game mounts with ResourceManager::MountBundle.
+//
+// Usage: assetbake <manifest> <output> [pixel format]
+// Textures are converted to the pixel format ahead of time, ARGB8888 by
+// default (also ABGR8888, RGBA8888 or BGRA8888). It should be the format the
+// renderer uses, so textures are created without converting them.
+//
+// Each line of the manifest is an asset, as one of:
+//   texture <path> [<sprite width> <sprite height>]
+//   tilemap <path>
+//   scene <path>
+// Paths are the ones the game loads the assets by. Textures can be in any
+// format the TextureLoader decodes. Empty lines and lines starting with '#'
+// are skipped.
+
+#include "core/ResourceManager.hpp"
+#include "core/resources/AssetBundle.hpp"
+#include "core/resources/SceneLoader.hpp"
+#include "core/resources/TextureLoader.hpp"
+#include "core/resources/TilemapLoader.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#if defined(LINUX) || defined(MINGW)
+#include <SDL2/SDL.h>
+#else  // This works for Mac
+#include <SDL.h>
+#endif
+
+namespace
+{
+struct PixelFormatName
+{
+    const char* name;
+    uint32_t format;
+};
+
+const PixelFormatName PIXEL_FORMATS[] = {
+    {"ARGB8888", SDL_PIXELFORMAT_ARGB8888},
+    {"ABGR8888", SDL_PIXELFORMAT_ABGR8888},
+    {"RGBA8888", SDL_PIXELFORMAT_RGBA8888},
+    {"BGRA8888", SDL_PIXELFORMAT_BGRA8888},
+};
+
+void BakeTexture(AssetBundleBuilder& builder, const std::string& path,
+                 uint32_t pixelFormat, uint32_t spriteWidth,
+                 uint32_t spriteHeight)
+{
+    SDL_Surface* surface = TextureLoader::DecodeFile(path);
+    if (!surface)
+    {
+        throw std::runtime_error("Could not load texture '" + path +
+                                 "': " + SDL_GetError());
+    }
+
+    try
+    {
+        builder.AddTexture(path, surface, pixelFormat, spriteWidth,
+                           spriteHeight);
+    }
+    catch (...)
+    {
+        SDL_FreeSurface(surface);
+        throw;
+    }
+    SDL_FreeSurface(surface);
+}
+
+void BakeTilemap(AssetBundleBuilder& builder, const std::string& path)
+{
+    TilemapLoader* tilemaps = ResourceManager::instance().Tilemaps();
+    tilemaps->Load(path);
+
+    std::ostringstream data;
+    TilemapLoader::WriteBinary(*tilemaps->Get(path), data);
+    builder.AddAsset(path, AssetType::Tilemap, data.str());
+}
+
+void BakeScene(AssetBundleBuilder& builder, const std::string& path)
+{
+    SceneFormat format;
+    std::shared_ptr<SceneData> sceneData = SceneLoader::Read(path, &format);
+
+    std::ostringstream data;
+    SceneLoader::WriteBinary(*sceneData, data);
+    builder.AddAsset(path, AssetType::Scene, data.str());
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " <manifest> <output> [pixel format]" << std::endl;
+        return 1;
+    }
+
+    std::string manifestLoc = argv[1];
+    std::string outputLoc = argv[2];
+    std::string formatName = argc > 3 ? argv[3] : "ARGB8888";
+    uint32_t pixelFormat = SDL_PIXELFORMAT_UNKNOWN;
+    for (const PixelFormatName& candidate : PIXEL_FORMATS)
+    {
+        if (formatName == candidate.name) pixelFormat = candidate.format;
+    }
+    if (pixelFormat == SDL_PIXELFORMAT_UNKNOWN)
+    {
+        std::cerr << "Unknown pixel format '" << formatName << "'"
+                  << std::endl;
+        return 1;
+    }
+
+    std::ifstream manifest(manifestLoc);
+    if (!manifest.is_open())
+    {
+        std::cerr << "Could not open manifest '" << manifestLoc << "'"
+                  << std::endl;
+        return 1;
+    }
+
+    AssetBundleBuilder builder;
+    std::string line;
+    unsigned int lineNumber = 0;
+    try
+    {
+        while (std::getline(manifest, line))
+        {
+            ++lineNumber;
+            std::istringstream ss(line);
+            std::string type, path;
+            if (!(ss >> type) || type[0] == '#') continue;
+            if (!(ss >> path))
+            {
+                throw std::invalid_argument("Asset has no path.");
+            }
+
+            if (type == "texture")
+            {
+                uint32_t spriteWidth = 0, spriteHeight = 0;
+                ss >> spriteWidth >> spriteHeight;
+                BakeTexture(builder, path, pixelFormat, spriteWidth,
+                            spriteHeight);
+            }
+            else if (type == "tilemap")
+            {
+                BakeTilemap(builder, path);
+            }
+            else if (type == "scene")
+            {
+                BakeScene(builder, path);
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown asset type '" + type +
+                                            "'.");
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << manifestLoc << ":" << lineNumber << ": " << e.what()
+                  << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        builder.Write(outputLoc);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Baked " << builder.GetAssetCount() << " asset(s) into "
+              << outputLoc << " (" << formatName << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,158 @@
+// Measures how long images take to load, to compare formats of the same
+// assets (e.g. BMP and PNG). Each image is read and decoded the way the
+// TextureLoader does, one after another and then spread over worker threads
+// like asynchronous loads are. Files are read from the disk cache after the
+// first round, so the times are mostly decoding.
+//
+// Usage: imagebench <rounds> <image>...
+// Prints the size and load time of each image, then the totals of each file
+// extension.
+
+#include "core/resources/TextureLoader.hpp"
+#include "core/util/ThreadPool.hpp"
+
+#include "BenchUtil.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(LINUX) || defined(MINGW)
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#else  // This works for Mac
+#include <SDL.h>
+#include <SDL_image.h>
+#endif
+
+namespace
+{
+using bench::Clock;
+using bench::MsSince;
+
+struct ImageResult
+{
+    std::string path;
+    size_t fileSize = 0;
+    double loadMs = 0;
+};
+
+struct FormatTotals
+{
+    unsigned int imageCount = 0;
+    size_t fileSize = 0;
+    double loadMs = 0;
+    double parallelMs = 0;
+};
+
+size_t FileSize(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file.is_open() ? (size_t)file.tellg() : 0;
+}
+
+std::string Extension(const std::string& path)
+{
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos) return "(none)";
+    return path.substr(dot + 1);
+}
+
+/**
+ * Load an image once.
+ * @return false if it could not be loaded
+ */
+bool LoadImage(const std::string& path)
+{
+    SDL_Surface* surface = TextureLoader::DecodeFile(path);
+    if (!surface) return false;
+
+    SDL_FreeSurface(surface);
+    return true;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    bench::Args args(argc, argv, "<rounds> <image>...");
+    int rounds = args.Get(1, 0);
+    if (!args.Check(args.Count() >= 3 && rounds >= 1)) return 1;
+    std::vector<std::string> paths(argv + 2, argv + argc);
+
+    // As ResourceManager::Startup does, before any worker decodes
+    IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG);
+
+    // Load every image one after another
+    std::vector<ImageResult> results;
+    for (const std::string& path : paths)
+    {
+        ImageResult result;
+        result.path = path;
+        result.fileSize = FileSize(path);
+
+        Clock::time_point start = Clock::now();
+        for (int round = 0; round < rounds; ++round)
+        {
+            if (!LoadImage(path))
+            {
+                std::cerr << "Could not load '" << path
+                          << "': " << SDL_GetError() << std::endl;
+                IMG_Quit();
+                return 1;
+            }
+        }
+        result.loadMs = MsSince(start) / rounds;
+        results.push_back(result);
+    }
+
+    std::map<std::string, FormatTotals> totals;
+    std::printf("%-64s %10s %10s\n", "image", "bytes", "load ms");
+    for (const ImageResult& result : results)
+    {
+        std::printf("%-64s %10zu %10.3f\n", result.path.c_str(),
+                    result.fileSize, result.loadMs);
+
+        FormatTotals& format = totals[Extension(result.path)];
+        format.imageCount++;
+        format.fileSize += result.fileSize;
+        format.loadMs += result.loadMs;
+    }
+
+    // Load the images of each format at once on the workers, like a level's
+    // asynchronous loads
+    util::ThreadPool workers(util::ThreadPool::DefaultWorkerCount());
+    for (auto& format : totals)
+    {
+        std::vector<std::function<void()>> tasks;
+        for (int round = 0; round < rounds; ++round)
+        {
+            for (const std::string& path : paths)
+            {
+                if (Extension(path) != format.first) continue;
+                tasks.push_back([path] { LoadImage(path); });
+            }
+        }
+
+        Clock::time_point start = Clock::now();
+        workers.RunAll(tasks);
+        format.second.parallelMs = MsSince(start) / rounds;
+    }
+
+    std::printf("\n%-10s %8s %12s %12s %14s\n", "format", "images", "bytes",
+                "load ms", "on workers ms");
+    for (const auto& format : totals)
+    {
+        std::printf("%-10s %8u %12zu %12.3f %14.3f\n", format.first.c_str(),
+                    format.second.imageCount, format.second.fileSize,
+                    format.second.loadMs, format.second.parallelMs);
+    }
+    std::printf("(%d round(s), %u worker(s) and the main thread)\n", rounds,
+                workers.GetWorkerCount());
+
+    IMG_Quit();
+    return 0;
+}
@@ -0,0 +1,141 @@
+// Measures taking and giving up references to a spritesheet, as sprite
+// renderers do (see ResourceLoader::Acquire). References are taken straight
+// from the spritesheet loader, then by building a level of sprites that all
+// use the sheet and unloading it. The engine runs without a window.
+//
+// Usage: resourcebench [references] [rounds] [spritesheet]
+// Prints the average time to take and give up every reference each way.
+
+#include "core/Engine.hpp"
+#include "core/GameObject.hpp"
+#include "core/ResourceManager.hpp"
+#include "core/SpriteRenderer.hpp"
+#include "core/resources/Spritesheet.hpp"
+
+#include "BenchUtil.hpp"
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+using bench::Clock;
+using bench::MsSince;
+
+const char* DEFAULT_SPRITESHEET =
+    "assets/mspj-engine/sprites/walk-cycle/character-walk-spritesheet.bmp";
+
+struct Times
+{
+    double acquireMs = 0;
+    double releaseMs = 0;
+};
+
+/**
+ * Acquire and release references through the loader.
+ */
+void RunLoader(SpritesheetLoader& spritesheets,
+               const std::shared_ptr<Spritesheet>& spritesheet,
+               size_t referenceCount, Times& times)
+{
+    std::vector<ResourceHandle<Spritesheet>> handles;
+    handles.reserve(referenceCount);
+
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < referenceCount; ++i)
+    {
+        handles.push_back(spritesheets.Acquire(spritesheet));
+    }
+    times.acquireMs += MsSince(start);
+
+    start = Clock::now();
+    for (ResourceHandle<Spritesheet>& handle : handles)
+    {
+        spritesheets.Release(handle);
+    }
+    times.releaseMs += MsSince(start);
+}
+
+/**
+ * Build a level of sprites using the spritesheet, then unload it, which
+ * releases their references.
+ */
+void RunLevel(Engine& engine, const std::shared_ptr<Spritesheet>& spritesheet,
+              size_t referenceCount, Times& times)
+{
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < referenceCount; ++i)
+    {
+        GameObject& sprite = engine.InstantiateGameObject();
+        engine.InstantiateComponent<SpriteRenderer>(sprite)->UseSpritesheet(
+            spritesheet);
+    }
+    times.acquireMs += MsSince(start);
+
+    start = Clock::now();
+    engine.UnloadLevel();
+    times.releaseMs += MsSince(start);
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    bench::Args args(argc, argv, "[references] [rounds] [spritesheet]");
+    size_t referenceCount = args.Get<size_t>(1, 100000);
+    int rounds = args.Get(2, 3);
+    std::string spritesheetLoc = args.GetString(3, DEFAULT_SPRITESHEET);
+    if (!args.Check(referenceCount > 0 && rounds >= 1)) return 1;
+
+    Engine engine;
+    engine.InitializeHeadlessGraphicsSubSystem(true, false);
+    engine.Startup();
+
+    int result = 0;
+    try
+    {
+        SpritesheetLoader* spritesheets =
+            ResourceManager::instance().Spritesheets();
+        spritesheets->Load(spritesheetLoc);
+        std::shared_ptr<Spritesheet> spritesheet =
+            spritesheets->Get(spritesheetLoc);
+        // The scene's own reference, which keeps the sheet loaded between
+        // rounds
+        ResourceHandle<Spritesheet> sceneHandle =
+            spritesheets->Acquire(spritesheet);
+
+        std::cout << "Taking " << referenceCount << " references to '"
+                  << spritesheetLoc << "', " << rounds << " rounds"
+                  << std::endl;
+
+        Times loader;
+        Times level;
+        for (int round = 0; round < rounds; ++round)
+        {
+            RunLoader(*spritesheets, spritesheet, referenceCount, loader);
+            RunLevel(engine, spritesheet, referenceCount, level);
+        }
+        if (spritesheets->GetRefCount(sceneHandle) != 1)
+        {
+            throw std::runtime_error("References were not all released");
+        }
+        spritesheets->Release(sceneHandle);
+
+        std::cout << "loader: acquire " << loader.acquireMs / rounds
+                  << "ms, release " << loader.releaseMs / rounds << "ms"
+                  << std::endl;
+        std::cout << "level of sprites: build " << level.acquireMs / rounds
+                  << "ms, unload " << level.releaseMs / rounds << "ms"
+                  << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        result = 1;
+    }
+
+    engine.Shutdown();
+    return result;
+}
@@ -0,0 +1,52 @@
+// Converts scene files between the text and binary formats (see
+// SceneFormat).
+//
+// Usage: sceneconv <input> <output> [binary|text]
+// The input can be in either format. The output is binary by default.
+
+#include "core/resources/SceneLoader.hpp"
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <input> <output> [binary|text]"
+                  << std::endl;
+        return 1;
+    }
+
+    std::string inputLoc = argv[1];
+    std::string outputLoc = argv[2];
+    std::string formatName = argc > 3 ? argv[3] : "binary";
+    if (formatName != "binary" && formatName != "text")
+    {
+        std::cerr << "Unknown format '" << formatName << "'" << std::endl;
+        return 1;
+    }
+    SceneFormat format = formatName == "binary" ? SceneFormat::Binary
+                                                : SceneFormat::Text;
+
+    try
+    {
+        SceneFormat inputFormat;
+        std::shared_ptr<SceneData> sceneData =
+            SceneLoader::Read(inputLoc, &inputFormat);
+        SceneLoader::Write(*sceneData, outputLoc, format);
+
+        std::cout << "Wrote scene of " << sceneData->GetObjects().size()
+                  << " objects to " << outputLoc << " (" << formatName << ")"
+                  << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,210 @@
+// Measures how much memory a large tilemap takes and how fast its tiles are
+// read. The map is grown outward from its centre one ring of tiles at a time,
+// so every side of the map grows (like a map painted in an editor), then
+// every tile is read a number of times. Last, the map is written in the text
+// and binary formats (see TilemapFormat) and read back from each.
+//
+// Usage: tilemapbench [size] [reads]
+// Prints the build time, the memory used by the tiles, the average time to
+// read a tile, and a checksum of the tiles to compare builds with. Then the
+// time to load each format, and to first read every tile of the binary map,
+// which is when its pages are faulted in.
+
+#include "core/resources/TilemapData.hpp"
+#include "core/resources/TilemapLoader.hpp"
+
+#include "BenchUtil.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+using bench::Clock;
+using bench::MsSince;
+
+// Maps can only be made by reading a file, so the map grows from this one
+const char* SEED_LOC = "tilemapbench-seed.txt";
+const char* TEXT_LOC = "tilemapbench.txt";
+const char* BINARY_LOC = "tilemapbench.bin";
+
+/**
+ * A tile that differs from its neighbours, so chunks do not compress.
+ */
+TileData MakeTile(unsigned int ring, unsigned int index)
+{
+    TileData tile;
+    tile.type = (ring * 7 + index) % 64;
+    tile.bHasCollider = tile.type % 5 == 0;
+    return tile;
+}
+
+/**
+ * Grow a map from 1x1 to a square of a size, setting every new tile.
+ */
+std::shared_ptr<TilemapData> BuildMap(unsigned int mapSize)
+{
+    {
+        std::ofstream seed(SEED_LOC);
+        seed << MakeTile(0, 0) << "\n";
+    }
+    TilemapFormat format;
+    std::shared_ptr<TilemapData> mapData =
+        TilemapLoader::Read(SEED_LOC, &format);
+    std::remove(SEED_LOC);
+
+    unsigned int rings = (mapSize - 1) / 2;
+    for (unsigned int ring = 1; ring <= rings; ++ring)
+    {
+        // One tile before the map, then one after it, on both axes
+        mapData->SetTile(TileLoc(-1, -1), MakeTile(ring, 0));
+        Size2D size = mapData->GetSize();
+        mapData->SetTile(TileLoc(size), MakeTile(ring, 1));
+        size = mapData->GetSize();
+
+        unsigned int index = 2;
+        for (int x = 0; x < (int)size.x; ++x)
+        {
+            mapData->SetTile(TileLoc(x, 0), MakeTile(ring, index++));
+            mapData->SetTile(TileLoc(x, size.y - 1), MakeTile(ring, index++));
+        }
+        for (int y = 1; y < (int)size.y - 1; ++y)
+        {
+            mapData->SetTile(TileLoc(0, y), MakeTile(ring, index++));
+            mapData->SetTile(TileLoc(size.x - 1, y), MakeTile(ring, index++));
+        }
+    }
+
+    // An even size is one row and column past the last ring
+    if (mapSize % 2 == 0)
+    {
+        unsigned int index = 0;
+        for (unsigned int i = 0; i < mapSize; ++i)
+        {
+            mapData->SetTile(TileLoc(i, mapSize - 1),
+                             MakeTile(rings + 1, index++));
+            mapData->SetTile(TileLoc(mapSize - 1, i),
+                             MakeTile(rings + 1, index++));
+        }
+    }
+    return mapData;
+}
+
+/**
+ * Read every tile of a map.
+ * @return A checksum of the tiles
+ */
+uint64_t ReadTiles(const TilemapData& mapData)
+{
+    uint64_t checksum = 0;
+    Size2D size = mapData.GetSize();
+    TileLoc tileLoc;
+    for (tileLoc.y = 0; tileLoc.y < (int)size.y; ++tileLoc.y)
+    {
+        for (tileLoc.x = 0; tileLoc.x < (int)size.x; ++tileLoc.x)
+        {
+            TileData tile = mapData.GetTile(tileLoc);
+            checksum = checksum * 31 + tile.type * 2 + tile.bHasCollider;
+        }
+    }
+    return checksum;
+}
+
+/**
+ * Write a map in a format, then time reading it back.
+ * @param out_loadMs Set to how long the map took to read
+ * @return The map read back
+ */
+std::shared_ptr<TilemapData> WriteAndRead(const TilemapData& mapData,
+                                          const char* fileLoc,
+                                          TilemapFormat format,
+                                          double* out_loadMs)
+{
+    TilemapLoader::Write(mapData, fileLoc, format);
+
+    TilemapFormat readFormat;
+    Clock::time_point start = Clock::now();
+    std::shared_ptr<TilemapData> loaded =
+        TilemapLoader::Read(fileLoc, &readFormat);
+    *out_loadMs = MsSince(start);
+    return loaded;
+}
+
+/**
+ * Check a map read back from a file has the tiles that were written.
+ */
+void CheckLoaded(const TilemapData& loaded, Size2D size, uint64_t checksum,
+                 uint64_t loadedChecksum, const std::string& name)
+{
+    if (loaded.GetSize() != size || loadedChecksum != checksum)
+    {
+        throw std::runtime_error("The " + name +
+                                 " map does not match what was written");
+    }
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    bench::Args args(argc, argv, "[size] [reads]");
+    unsigned int size = args.Get(1, 2047u);
+    int reads = args.Get(2, 20);
+    if (!args.Check(size > 0 && reads >= 1)) return 1;
+
+    try
+    {
+        Clock::time_point start = Clock::now();
+        std::shared_ptr<TilemapData> mapData = BuildMap(size);
+        double buildMs = MsSince(start);
+
+        Size2D mapSize = mapData->GetSize();
+        size_t tileCount = (size_t)mapSize.x * mapSize.y;
+        std::cout << "Built a " << mapSize.x << "x" << mapSize.y
+                  << " tilemap in " << buildMs << "ms, using "
+                  << mapData->GetMemoryUsage() / (1024.0 * 1024.0) << "MB"
+                  << std::endl;
+
+        uint64_t checksum = 0;
+        start = Clock::now();
+        for (int read = 0; read < reads; ++read)
+        {
+            checksum = ReadTiles(*mapData);
+        }
+        double readMs = MsSince(start);
+        std::cout << "GetTile: " << readMs * 1e6 / (tileCount * reads)
+                  << "ns per tile over " << reads << " reads (checksum "
+                  << checksum << ")" << std::endl;
+
+        double textMs = 0;
+        std::shared_ptr<TilemapData> textMap =
+            WriteAndRead(*mapData, TEXT_LOC, TilemapFormat::Text, &textMs);
+        CheckLoaded(*textMap, mapSize, checksum, ReadTiles(*textMap), "text");
+        textMap.reset();
+        std::remove(TEXT_LOC);
+        std::cout << "text load: " << textMs << "ms" << std::endl;
+
+        double binaryMs = 0;
+        std::shared_ptr<TilemapData> binaryMap = WriteAndRead(
+            *mapData, BINARY_LOC, TilemapFormat::Binary, &binaryMs);
+        start = Clock::now();
+        uint64_t binaryChecksum = ReadTiles(*binaryMap);
+        double firstReadMs = MsSince(start);
+        CheckLoaded(*binaryMap, mapSize, checksum, binaryChecksum, "binary");
+        // Unmapped before the file is removed
+        binaryMap.reset();
+        std::remove(BINARY_LOC);
+        std::cout << "binary load: " << binaryMs << "ms, first read of "
+                  << "every tile: " << firstReadMs << "ms" << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+// Converts tilemap files between the text and binary formats (see
+// TilemapFormat).
+//
+// Usage: tilemapconv <input> <output> [binary|text]
+// The input can be in either format. The output is binary by default.
+
+#include "core/ResourceManager.hpp"
+#include "core/resources/TilemapLoader.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <input> <output> [binary|text]"
+                  << std::endl;
+        return 1;
+    }
+
+    std::string inputLoc = argv[1];
+    std::string outputLoc = argv[2];
+    std::string formatName = argc > 3 ? argv[3] : "binary";
+    if (formatName != "binary" && formatName != "text")
+    {
+        std::cerr << "Unknown format '" << formatName << "'" << std::endl;
+        return 1;
+    }
+    TilemapFormat format = formatName == "binary" ? TilemapFormat::Binary
+                                                  : TilemapFormat::Text;
+
+    try
+    {
+        TilemapLoader* tilemaps = ResourceManager::instance().Tilemaps();
+        tilemaps->Load(inputLoc);
+        std::shared_ptr<TilemapData> mapData = tilemaps->Get(inputLoc);
+        TilemapLoader::Write(*mapData, outputLoc, format);
+
+        Size2D size = mapData->GetSize();
+        std::cout << "Wrote " << size.x << "x" << size.y << " tilemap to "
+                  << outputLoc << " (" << formatName << ")" << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
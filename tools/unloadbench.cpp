@@ -0,0 +1,145 @@
+// Measures how long unloading a level takes, with its game objects on the
+// heap and deleted one by one (as the engine used to), and in the level arena
+// (see Engine::UnloadLevel). Each game object gets the components of a
+// typical sprite, and objects are parented in groups like scenes are.
+//
+// Usage: unloadbench [objects] [rounds]
+// Prints the average build and unload time of each way.
+
+#include "core/Engine.hpp"
+#include "core/GameObject.hpp"
+#include "core/RectComponent.hpp"
+#include "core/SpriteRenderer.hpp"
+#include "core/collision/SpriteColliderComponent.hpp"
+
+#include "BenchUtil.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+using bench::Clock;
+using bench::MsSince;
+
+// Each group is a parent with this many objects in total
+const size_t GROUP_SIZE = 10;
+
+void AddComponents(Engine& engine, GameObject& gameObject)
+{
+    gameObject.ReserveComponents(3);
+    engine.InstantiateComponent<SpriteRenderer>(gameObject);
+    engine.InstantiateComponent<SpriteColliderComponent>(gameObject);
+    engine.InstantiateComponent<RectComponent>(gameObject);
+}
+
+void Parent(std::vector<GameObject*>& objects)
+{
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        if (i % GROUP_SIZE == 0) continue;
+        objects[i]->SetParent(objects[i - i % GROUP_SIZE]);
+    }
+}
+
+struct Times
+{
+    double buildMs = 0;
+    double unloadMs = 0;
+    // The most memory a level took, for the arena
+    size_t peakBytes = 0;
+};
+
+/**
+ * Build and unload a level on the heap.
+ * @param bHierarchy Whether the objects are in the engine's transform
+ * hierarchy, which the engine's objects always are
+ */
+void RunHeap(size_t objectCount, bool bHierarchy, Times& times)
+{
+    Engine engine;
+    std::vector<GameObject*> objects;
+    objects.reserve(objectCount);
+
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < objectCount; ++i)
+    {
+        objects.push_back(new GameObject(bHierarchy ? &engine : nullptr));
+        AddComponents(engine, *objects.back());
+    }
+    Parent(objects);
+    times.buildMs += MsSince(start);
+
+    start = Clock::now();
+    for (GameObject* pGO : objects)
+    {
+        delete pGO;
+    }
+    times.unloadMs += MsSince(start);
+}
+
+/**
+ * Build and unload a level in the level arena.
+ */
+void RunArena(Engine& engine, size_t objectCount, Times& times)
+{
+    std::vector<GameObject*> objects;
+    objects.reserve(objectCount);
+
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < objectCount; ++i)
+    {
+        objects.push_back(&engine.InstantiateGameObject());
+        AddComponents(engine, *objects.back());
+    }
+    Parent(objects);
+    times.buildMs += MsSince(start);
+    times.peakBytes = std::max(
+        times.peakBytes, engine.GetArena(Engine::Scope::Level).GetUsed());
+
+    start = Clock::now();
+    engine.UnloadLevel();
+    times.unloadMs += MsSince(start);
+}
+
+void Print(const std::string& name, const Times& times, int rounds)
+{
+    std::cout << name << ": build " << times.buildMs / rounds
+              << "ms, unload " << times.unloadMs / rounds << "ms"
+              << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    bench::Args args(argc, argv, "[objects] [rounds]");
+    size_t objectCount = args.Get<size_t>(1, 100000);
+    int rounds = args.Get(2, 3);
+    if (!args.Check(objectCount > 0 && rounds >= 1)) return 1;
+
+    std::cout << "Unloading " << objectCount << " game objects, "
+              << rounds << " rounds" << std::endl;
+
+    Times heap;
+    Times heapNoHierarchy;
+    Times arena;
+    {
+        // The same engine each round, as levels are loaded one after another
+        Engine engine;
+        for (int round = 0; round < rounds; ++round)
+        {
+            RunHeap(objectCount, true, heap);
+            RunHeap(objectCount, false, heapNoHierarchy);
+            RunArena(engine, objectCount, arena);
+        }
+    }
+
+    Print("heap, deleted one by one", heap, rounds);
+    Print("heap, deleted one by one, no hierarchy", heapNoHierarchy, rounds);
+    Print("level arena", arena, rounds);
+    std::cout << "level arena used " << arena.peakBytes / 1024 << "KB"
+              << std::endl;
+    return 0;
+}
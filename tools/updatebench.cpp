@@ -0,0 +1,149 @@
+// Measures how the update scales with worker threads. The same scene is
+// updated with no job system, then with 1 to N workers: walkers that steer
+// themselves and post the animation to play (like the controller does), each
+// with a sprite animator playing it and a collider.
+//
+// Usage: updatebench [objects] [frames] [max workers]
+// Prints the average update time of each worker count, and the speedup over
+// updating serially.
+
+#include "core/Engine.hpp"
+#include "core/GameObject.hpp"
+#include "core/SpriteAnimator.hpp"
+#include "core/TransformComponent.hpp"
+#include "core/UpdateContext.hpp"
+#include "core/collision/SpriteColliderComponent.hpp"
+#include "core/resources/Spritesheet.hpp"
+#include "core/util/ThreadPool.hpp"
+
+#include "BenchUtil.hpp"
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace
+{
+using bench::Clock;
+using bench::MsSince;
+
+// Every run steps the same time, so they do the same work
+const float FRAME_TIME = 1.0f / 60.0f;
+
+/**
+ * Walks in a circle around where it started, turning faster or slower
+ * depending on where it is, and posts the animation of the way it faces.
+ */
+class Walker : public Component
+{
+public:
+    Walker() : Component("walker") {}
+    virtual ~Walker() {}
+
+    virtual void Update(UpdateContext* update) override
+    {
+        TransformComponent& transform = mGameObject->GetTransform();
+        glm::vec2 pos = transform.GetPosition();
+
+        mHeading += update->deltaTime * (1.0f + std::sin(pos.x * 0.01f) *
+                                                    std::cos(pos.y * 0.01f));
+        glm::vec2 move(std::cos(mHeading), std::sin(mHeading));
+        transform.TranslatePosition(move * SPEED * update->deltaTime);
+
+        mGameObject->PostMessage(move.x < 0 ? "move_left" : "move_right");
+    }
+
+    virtual ComponentAccess GetAccess() const override
+    {
+        static const ComponentAccess access = ComponentAccess()
+                                                  .Reads({"transform"})
+                                                  .Writes({"transform",
+                                                           "messages"})
+                                                  .ObjectLocal();
+        return access;
+    }
+
+private:
+    static constexpr float SPEED = 64.0f;
+    float mHeading = 0;
+};
+
+void BuildScene(Engine& engine, size_t objectCount,
+                const std::shared_ptr<Spritesheet>& spritesheet)
+{
+    for (size_t i = 0; i < objectCount; ++i)
+    {
+        GameObject& walker = engine.InstantiateGameObject();
+        walker.GetTransform().SetPosition((i % 100) * 32.0f,
+                                          (i / 100) * 32.0f);
+        walker.ReserveComponents(3);
+        engine.InstantiateComponent<Walker>(walker);
+
+        SpriteAnimator* animator =
+            engine.InstantiateComponent<SpriteAnimator>(walker);
+        animator->UseSpritesheet(spritesheet);
+        animator->SetAnimation("move_left", 0, 4, 0.1f);
+        animator->SetAnimation("move_right", 1, 4, 0.1f);
+
+        engine.InstantiateComponent<SpriteColliderComponent>(walker);
+    }
+}
+
+/**
+ * Update the scene for a number of frames.
+ * @param workerCount The number of workers, or -1 for no job system
+ * @return The average update time, in milliseconds
+ */
+double Run(size_t objectCount, int frames, int workerCount,
+           const std::shared_ptr<Spritesheet>& spritesheet)
+{
+    Engine engine;
+    if (workerCount >= 0) engine.InitializeJobSystem(workerCount);
+    BuildScene(engine, objectCount, spritesheet);
+
+    // Settles the containers, like the first frames of a level do
+    engine.Update(FRAME_TIME);
+
+    Clock::time_point start = Clock::now();
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        engine.Update(FRAME_TIME);
+    }
+    double totalMs = MsSince(start);
+
+    engine.UnloadLevel();
+    return totalMs / frames;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    bench::Args args(argc, argv, "[objects] [frames] [max workers]");
+    size_t objectCount = args.Get<size_t>(1, 10000);
+    int frames = args.Get(2, 200);
+    int maxWorkers =
+        args.Get(3, (int)util::ThreadPool::DefaultWorkerCount());
+    if (!args.Check(objectCount > 0 && frames >= 1 && maxWorkers >= 0))
+        return 1;
+
+    // The frames are only stepped, never drawn, so there is no texture
+    std::shared_ptr<Spritesheet> spritesheet =
+        std::make_shared<Spritesheet>(std::shared_ptr<SDL_Texture>());
+
+    std::cout << "Updating " << objectCount << " walkers for " << frames
+              << " frames" << std::endl;
+
+    double serialMs = Run(objectCount, frames, -1, spritesheet);
+    std::cout << "no job system: " << serialMs << "ms" << std::endl;
+    for (int workerCount = 1; workerCount <= maxWorkers; ++workerCount)
+    {
+        double ms = Run(objectCount, frames, workerCount, spritesheet);
+        std::cout << workerCount << " worker(s), " << workerCount + 1
+                  << " threads: " << ms << "ms, " << std::setprecision(3)
+                  << serialMs / ms << "x" << std::setprecision(6)
+                  << std::endl;
+    }
+    return 0;
+}